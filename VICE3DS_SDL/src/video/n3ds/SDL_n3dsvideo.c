@@ -381,6 +381,10 @@ int hh= next_pow2(height);
 		free( this->hidden->palettedbuffer );
 		this->hidden->palettedbuffer = NULL;
 	}
+	if ( this->hidden->paletteddirty ) {
+		free( this->hidden->paletteddirty );
+		this->hidden->paletteddirty = NULL;
+	}
 
 	this->hidden->buffer = (u8*) linearAlloc(hw * hh * this->hidden->byteperpixel);
 	if ( ! this->hidden->buffer ) {
@@ -404,6 +408,16 @@ int hh= next_pow2(height);
 			return(NULL);
 		}
 		SDL_memset(this->hidden->palettedbuffer, 0, width * height);
+		this->hidden->paletteddirty = malloc(height);
+		if ( ! this->hidden->paletteddirty ) {
+			SDL_SetError("Couldn't allocate buffer for requested mode");
+			free(this->hidden->palettedbuffer);
+			this->hidden->palettedbuffer = NULL;
+			linearFree(this->hidden->buffer);
+			linearFree(this->hidden->buffer2);
+			return(NULL);
+		}
+		SDL_memset(this->hidden->paletteddirty, 3, height);
 	}
 
 	/* Allocate the new pixel format for the screen */
@@ -431,6 +445,8 @@ int hh= next_pow2(height);
 	}
 	/* Set up the new mode framebuffer */
 	current->flags =  SDL_HWSURFACE | SDL_DOUBLEBUF;
+	// the palette is ours, so that SDL_SetColors on a shadow surface gets here
+	if(bpp==8) current->flags |= SDL_HWPALETTE;
 	this->hidden->w = hw;
 	this->hidden->h = hh;
 
@@ -592,7 +608,9 @@ static void drawBuffers(_THIS)
 		// flip my buffers and signal to draw
 		svcWaitSynchronization(buffer_mutex, U64_MAX);
 		current_buffer=this->hidden->buffer;
-		this->hidden->currentVideoSurface->pixels = this->hidden->buffer = this->hidden->buffer2;
+		this->hidden->buffer = this->hidden->buffer2;
+		// in 8 bit mode the surface stays on the paletted buffer
+		if(this->hidden->bpp > 8) this->hidden->currentVideoSurface->pixels = this->hidden->buffer;
 		this->hidden->buffer2 = current_buffer;
 		svcReleaseMutex(buffer_mutex);
 		svcSignalEvent(repaintRequired);
@@ -600,49 +618,44 @@ static void drawBuffers(_THIS)
 	}
 }
 
-static void N3DS_UpdateRects(_THIS, int numrects, SDL_Rect *rects)
+// Convert the rows of the paletted buffer that changed since the back buffer
+// was last drawn: those of this update and of the one before, as the buffers
+// are flipped on every update.
+static void N3DS_ConvertPaletted(_THIS)
 {
-	if(app_pause || app_exiting) return; //Block video output on quitting
+	Uint8 *dirty = this->hidden->paletteddirty;
+	Uint8 *src_addr;
+	u32 *dst_addr;
+	int x,y;
+
+	for(y=0;y<this->info.current_h;y++) {
+		if(dirty[y]) {
+			src_addr = this->hidden->palettedbuffer + y*this->info.current_w;
+			dst_addr = (u32 *)this->hidden->buffer + y*this->hidden->w;
+			for(x=0;x<this->info.current_w;x++) {
+				dst_addr[x]=n3ds_palette[src_addr[x]];
+			}
+		}
+		dirty[y] = (dirty[y] & 1) << 1;
+	}
+}
 
+static void N3DS_UpdateRects(_THIS, int numrects, SDL_Rect *rects)
+{
 	if( this->hidden->bpp == 8) {
-/*
-		int i;
+		// remembered even when paused, the rows are converted later
+		int i,y,y1,y2;
 		for(i=0; i< numrects; i++) {
-			SDL_Rect *rect = &rects[i];
-			Uint8 *src_addr, *dst_addr, *src_baseaddr, *dst_baseaddr;
-			int cols, rows;
-			int x,y;
-			src_baseaddr = this->hidden->palettedbuffer;
-			dst_baseaddr = this->hidden->buffer;
-			cols = (rect->x + rect->w > this->info.current_w) ? this->info.current_w - rect->x : rect->w;
-			rows = (rect->y + rect->h > this->info.current_h) ? this->info.current_h - rect->y : rect->h;
-			for(y=0;y<rows;y++) {
-			  x = 0;
-			  src_addr = src_baseaddr + rect->x + x + (rect->y + y) * this->info.current_w;
-			  dst_addr = dst_baseaddr + (rect->x + x + (rect->y + y) * this->hidden->w) * 4;
-			  for(;x<cols;x++) {
-				*(u32*)dst_addr=n3ds_palette[*(Uint8 *)src_addr];
-				src_addr++;
-				dst_addr += 4;
-}
-			}
-		} 
-*/
-		Uint8 *src_addr, *dst_addr, *dst_baseaddr;
-		src_addr = this->hidden->palettedbuffer;
-		dst_baseaddr = this->hidden->buffer;
-		int x,y;
-		for(y=0;y<this->info.current_h;y++) {
-  		  dst_addr = dst_baseaddr + y*this->hidden->w*4;
-		  for(x=0;x<this->info.current_w;x++) {
-			*(u32*)dst_addr=n3ds_palette[*(Uint8 *)src_addr];
-			src_addr++;
-			dst_addr += 4;
-		  }
+			y1 = rects[i].y;
+			y2 = (y1 + rects[i].h > this->info.current_h) ? this->info.current_h : y1 + rects[i].h;
+			for(y=y1;y<y2;y++) this->hidden->paletteddirty[y] |= 1;
 		}
-	
 	}
 
+	if(app_pause || app_exiting) return; //Block video output on quitting
+
+	if( this->hidden->bpp == 8) N3DS_ConvertPaletted(this);
+
 	drawBuffers(this);
 }
 
@@ -652,7 +665,10 @@ static int N3DS_SetColors(_THIS, int firstcolor, int ncolors, SDL_Color *colors)
 {
 	int i;
 	for ( i = firstcolor; i < firstcolor + ncolors; ++i )
-		n3ds_palette[i] = N3DS_MAP_RGB(colors[i].r, colors[i].g, colors[i].b);
+		n3ds_palette[i] = N3DS_MAP_RGB(colors[i-firstcolor].r, colors[i-firstcolor].g, colors[i-firstcolor].b);
+	// both buffers have to be converted again
+	if( this->hidden->paletteddirty )
+		SDL_memset(this->hidden->paletteddirty, 3, this->info.current_h);
 	return(1);
 }
 
@@ -661,18 +677,8 @@ static int N3DS_FlipHWSurface (_THIS, SDL_Surface *surface) {
 	if(app_pause || app_exiting) return(0); //Block video output on quitting
 
 	if( this->hidden->bpp == 8) {
-		Uint8 *src_addr, *dst_addr, *dst_baseaddr;
-		src_addr = this->hidden->palettedbuffer;
-		dst_baseaddr = this->hidden->buffer;
-		int x,y;
-		for(y=0;y<this->info.current_h;y++) {
-  		  dst_addr = dst_baseaddr + y*this->hidden->w*4;
-		  for(x=0;x<this->info.current_w;x++) {
-			*(u32*)dst_addr=n3ds_palette[*(Uint8 *)src_addr];
-			src_addr++;
-			dst_addr += 4;
-		  }
-		}
+		SDL_memset(this->hidden->paletteddirty, 3, this->info.current_h);
+		N3DS_ConvertPaletted(this);
 	}
 
 	drawBuffers(this);
@@ -709,6 +715,11 @@ void N3DS_VideoQuit(_THIS)
 		free(this->hidden->palettedbuffer);
 		this->hidden->palettedbuffer = NULL;
 	}
+	if (this->hidden->paletteddirty)
+	{
+		free(this->hidden->paletteddirty);
+		this->hidden->paletteddirty = NULL;
+	}
 	if (this->hidden->currentVideoSurface) 
 		this->hidden->currentVideoSurface->pixels = NULL; // set to buffer or to palettedbuffer, so now pointing to not allocated memory
 	
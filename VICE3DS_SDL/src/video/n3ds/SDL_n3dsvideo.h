@@ -48,6 +48,7 @@ struct SDL_PrivateVideoData {
     void *buffer;
     void *buffer2;
 	Uint8 *palettedbuffer;
+	Uint8 *paletteddirty; // per row: bit0 changed in this update, bit1 in the one before
 	GSPGPU_FramebufferFormats mode;
 	unsigned int flags; // backup of create device flags
 	unsigned int screens; // SDL_TOPSCR, SDL_BOTTOMSCR, SDL_DUALSCR
@@ -346,6 +346,33 @@ static void clk_overflow_callback(CLOCK sub, void *unused_data)
 /* SCPU64 needs external reg_pc */
 #define NEED_REG_PC
 
+/* Plain SRAM pages in bank 0 are accessed through the direct tables (see
+   mem.h), doing the same BA check as ram_read() and ram_store().  */
+static inline uint8_t load_bank0(uint16_t addr)
+{
+    uint8_t *p = _mem_read_direct_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        check_ba();
+        return p[addr];
+    }
+    return (*_mem_read_tab_ptr[addr >> 8])(addr);
+}
+
+static inline void store_bank0(uint16_t addr, uint8_t value)
+{
+    uint8_t *p = _mem_write_direct_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        if (!scpu64_fastmode && !scpu64_emulation_mode && maincpu_ba_low_flags) {
+            maincpu_steal_cycles();
+        }
+        p[addr] = value;
+    } else {
+        (*_mem_write_tab_ptr[addr >> 8])(addr, value);
+    }
+}
+
 #define STORE(addr, value) \
     do { \
         uint32_t tmpx1 = (addr); \
@@ -353,12 +380,12 @@ static void clk_overflow_callback(CLOCK sub, void *unused_data)
         if (tmpx1 & ~0xffff) { \
             mem_store2(tmpx1, tmpx2); \
         } else { \
-            (*_mem_write_tab_ptr[tmpx1 >> 8])((uint16_t)tmpx1, tmpx2); \
+            store_bank0((uint16_t)tmpx1, tmpx2); \
         } \
     } while (0)
 
 #define LOAD(addr) \
-    (((addr) & ~0xffff)?mem_read2(addr):(*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
+    (((addr) & ~0xffff)?mem_read2(addr):load_bank0((uint16_t)(addr)))
 
 #define STORE_LONG(addr, value) store_long((uint32_t)(addr), (uint8_t)(value))
 
@@ -367,7 +394,7 @@ static inline void store_long(uint32_t addr, uint8_t value)
     if (addr & ~0xffff) {
         mem_store2(addr, value);
     } else {
-        (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
+        store_bank0((uint16_t)addr, value);
     }
     scpu64_clock_inc(1);
 }
@@ -381,7 +408,7 @@ static inline uint8_t load_long(uint32_t addr)
     if ((addr) & ~0xffff) {
         tmp = mem_read2(addr);
     } else {
-        tmp = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)addr);
+        tmp = load_bank0((uint16_t)addr);
     }
     scpu64_clock_inc(0);
     return tmp;
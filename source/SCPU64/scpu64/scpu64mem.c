@@ -127,6 +127,25 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Pointers to the currently used direct access tables (see mem.h).  */
+uint8_t **_mem_read_direct_tab_ptr;
+uint8_t **_mem_write_direct_tab_ptr;
+
+/* Direct access tables, filled in from the read and write tables the first
+   time a configuration is used.  The store functions depend on the mirror
+   configuration, so each table remembers which one it was filled in for.  */
+static uint8_t *mem_read_direct_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_write_direct_tab[NUM_CONFIGS][0x101];
+static int mem_direct_mirror[NUM_CONFIGS];
+
+/* Generation each direct table was filled in for; bumped whenever the read
+   or write tables change.  */
+static unsigned int mem_direct_generation = 1;
+static unsigned int mem_direct_valid[NUM_CONFIGS];
+
+/* All NULL, used while watchpoints are active.  */
+static uint8_t *mem_direct_tab_none[0x101];
+
 /* Current mirror config */
 static int mirror;
 
@@ -192,6 +211,50 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[mirror][mem_config][addr >> 8](addr, value);
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Only the plain SRAM pages get a direct pointer; the CPU does the BA check
+   of ram_read() and ram_store() itself (see scpu64cpu.c).  Everything else
+   stretches the clock or has side effects and keeps going through the
+   function tables.  */
+static void mem_direct_tab_fill(int config)
+{
+    int i;
+
+    for (i = 0; i <= 0x100; i++) {
+        int plain = (i != 0 && i != 0x100);
+
+        mem_read_direct_tab[config][i] =
+            (plain && mem_read_tab[config][i] == ram_read) ? mem_sram : NULL;
+        mem_write_direct_tab[config][i] =
+            (plain && mem_write_tab[mirror][config][i] == ram_store) ? mem_sram : NULL;
+    }
+    mem_direct_mirror[config] = mirror;
+    mem_direct_valid[config] = mem_direct_generation;
+}
+
+static void mem_direct_tab_update(void)
+{
+    if (watchpoints_active) {
+        _mem_read_direct_tab_ptr = mem_direct_tab_none;
+        _mem_write_direct_tab_ptr = mem_direct_tab_none;
+        return;
+    }
+
+    if (mem_direct_valid[mem_config] != mem_direct_generation
+        || mem_direct_mirror[mem_config] != mirror) {
+        mem_direct_tab_fill(mem_config);
+    }
+    _mem_read_direct_tab_ptr = mem_read_direct_tab[mem_config];
+    _mem_write_direct_tab_ptr = mem_write_direct_tab[mem_config];
+}
+
+/* Called whenever the read or write tables are changed.  */
+static void mem_direct_tab_invalidate(void)
+{
+    mem_direct_generation++;
+}
+
 void mem_toggle_watchpoints(int flag, void *context)
 {
     if (flag) {
@@ -202,6 +265,7 @@ void mem_toggle_watchpoints(int flag, void *context)
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
     watchpoints_active = flag;
+    mem_direct_tab_update();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -227,6 +291,7 @@ void mem_pla_config_changed(void)
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
     mem_read_limit_tab_ptr = mem_read_limit_tab[mem_config];
+    mem_direct_tab_update();
 
     maincpu_resync_limits();
 }
@@ -1076,11 +1141,13 @@ void mem_set_write_hook(int config, int page, store_func_t *f)
     for (j = 0; j < NUM_MIRRORS; j++) {
         mem_write_tab[j][config][page] = f;
     }
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func)
 {
     mem_read_tab[base][index] = read_func;
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
@@ -1189,6 +1256,9 @@ void mem_initialize_memory(void)
     /* Setup initial memory configuration.  */
     mem_pla_config_changed();
     cartridge_init_config();
+
+    mem_direct_tab_invalidate();
+    mem_direct_tab_update();
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -1274,6 +1344,7 @@ void mem_set_mirroring(int new_mirroring)
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
+    mem_direct_tab_update();
 }
 
 void mem_set_simm(int config)
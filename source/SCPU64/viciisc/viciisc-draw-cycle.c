@@ -26,9 +26,15 @@
 
 #include "vice.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include "types.h"
+#ifdef VICE_BENCH
+#include "bench.h"
+#include "lib.h"
+#include "log.h"
+#endif
 #include "snapshot.h"
 #include "vicii-chip-model.h"
 #include "vicii-draw-cycle.h"
@@ -117,6 +123,13 @@ static uint8_t last_color_value;
 
 static unsigned int cycle_flags_pipe;
 
+/* The bench draws every cycle pixel by pixel as before, to compare.  */
+#ifdef VICE_BENCH
+static int draw_per_pixel = 0;
+#else
+#define draw_per_pixel 0
+#endif
+
 
 /**************************************************************************
  *
@@ -135,6 +148,87 @@ static const uint8_t colors[] = {
     COL_NONE, COL_NONE, COL_NONE, COL_NONE          /* ECM=1 BMM=1 MCM=1 */
 };
 
+/* Resolve a color from colors[] the way draw_graphics() does.  */
+static DRAW_INLINE uint8_t graphics_color(uint8_t cc)
+{
+    switch (cc) {
+        case COL_NONE:
+            return 0;
+        case COL_VBUF_L:
+            return vbuf_reg & 0x0f;
+        case COL_VBUF_H:
+            return vbuf_reg >> 4;
+        case COL_CBUF:
+            return cbuf_reg;
+        case COL_CBUF_MC:
+            return cbuf_reg & 0x07;
+        case COL_D02X_EXT:
+            return COL_D021 + (vbuf_reg >> 6);
+        default:
+            return cc;
+    }
+}
+
+/* hires byte -> 8 pixels, 0xff where the bit is set */
+static uint8_t hires_mask[256][8];
+
+/* Pixels `from' to `to' - 1 of draw_graphics(), for a cycle in which the
+   video mode does not change: the colors are resolved once for the span
+   and a whole hires byte is drawn at once.  */
+static DRAW_INLINE void draw_graphics_span(int from, int to)
+{
+    uint8_t vmode = vmode11_pipe | vmode16_pipe;
+    uint8_t cc[4];
+    uint8_t hires_px;
+    int i;
+
+    cc[0] = graphics_color(colors[vmode]);
+    cc[1] = graphics_color(colors[vmode | 1]);
+    cc[2] = graphics_color(colors[vmode | 2]);
+    cc[3] = graphics_color(colors[vmode | 3]);
+
+    if ((vmode11_pipe & 0x08) || (cbuf_reg & 0x08)) {
+        if (vmode16_pipe2) {
+            /* mc pixels */
+            for (i = from; i < to; i++) {
+                if (gbuf_mc_flop) {
+                    gbuf_pixel_reg = gbuf_reg >> 6;
+                }
+                gbuf_reg <<= 1;
+                gbuf_mc_flop ^= 1;
+                render_buffer[i] = cc[gbuf_pixel_reg];
+                pri_buffer[i] = gbuf_pixel_reg & 0x2;
+            }
+            return;
+        }
+        /* see the $d023 kludge in draw_graphics() */
+        hires_px = 2;
+    } else {
+        hires_px = 3;
+    }
+
+    if (from == 0 && to == 8) {
+        const uint8_t *m = hires_mask[gbuf_reg];
+        uint8_t bg = cc[0], fg = cc[hires_px];
+
+        for (i = 0; i < 8; i++) {
+            render_buffer[i] = bg ^ ((bg ^ fg) & m[i]);
+            pri_buffer[i] = m[i] & 0x2;
+        }
+        gbuf_pixel_reg = (gbuf_reg & 0x01) ? hires_px : 0;
+        gbuf_reg = 0;
+        return;
+    }
+
+    for (i = from; i < to; i++) {
+        gbuf_pixel_reg = (gbuf_reg & 0x80) ? hires_px : 0;
+        gbuf_reg <<= 1;
+        gbuf_mc_flop ^= 1;
+        render_buffer[i] = cc[gbuf_pixel_reg];
+        pri_buffer[i] = gbuf_pixel_reg & 0x2;
+    }
+}
+
 static DRAW_INLINE void draw_graphics(int i)
 {
     uint8_t px;
@@ -191,40 +285,14 @@ static DRAW_INLINE void draw_graphics(int i)
     cc = colors[vmode | px];
 
     /* lookup colors and render pixel */
-    switch (cc) {
-        case COL_NONE:
-            cc = 0;
-            break;
-        case COL_VBUF_L:
-            cc = vbuf_reg & 0x0f;
-            break;
-        case COL_VBUF_H:
-            cc = vbuf_reg >> 4;
-            break;
-        case COL_CBUF:
-            cc = cbuf_reg;
-            break;
-        case COL_CBUF_MC:
-            cc = cbuf_reg & 0x07;
-            break;
-        case COL_D02X_EXT:
-            cc = COL_D021 + (vbuf_reg >> 6);
-            break;
-        default:
-            break;
-    }
-
-    render_buffer[i] = cc;
+    render_buffer[i] = graphics_color(cc);
     pri_buffer[i] = pixel_pri;
 }
 
-static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+/* The 8 pixels of a cycle one by one, with the video mode changes
+   within it.  */
+static DRAW_INLINE void draw_graphics8_pixels(void)
 {
-    int vis_en;
-
-    vis_en = cycle_is_visible(cycle_flags);
-
-    /* render pixels */
     /* pixel 0 */
     draw_graphics(0);
     /* pixel 1 */
@@ -254,6 +322,33 @@ static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
     }
     vmode16_pipe2 = vmode16_pipe;
     draw_graphics(7);
+}
+
+static DRAW_INLINE void draw_graphics8(unsigned int cycle_flags)
+{
+    int vis_en;
+
+    vis_en = cycle_is_visible(cycle_flags);
+
+    /* If the video mode is not going to change within the cycle, the
+       pixels before and after the new data is latched are drawn as two
+       spans.  */
+    if (!draw_per_pixel
+        && ((vicii.regs[0x16] & 0x10) >> 2) == vmode16_pipe
+        && vmode16_pipe == vmode16_pipe2
+        && (!vicii.color_latency || ((vicii.regs[0x11] & 0x60) >> 2) == vmode11_pipe)) {
+        if (xscroll_pipe > 0) {
+            draw_graphics_span(0, xscroll_pipe);
+        }
+        /* latch values at time xs */
+        vbuf_reg = vbuf_pipe1_reg;
+        cbuf_reg = cbuf_pipe1_reg;
+        gbuf_reg = gbuf_pipe1_reg;
+        gbuf_mc_flop = 1;
+        draw_graphics_span(xscroll_pipe, 8);
+    } else {
+        draw_graphics8_pixels();
+    }
 
     if (!vicii.color_latency) {
         vmode11_pipe = ( vicii.regs[0x11] & 0x60 ) >> 2;
@@ -337,24 +432,100 @@ static DRAW_INLINE void trigger_sprites(int xpos, uint8_t candidate_bits)
     }
 }
 
-static DRAW_INLINE void draw_sprites(int i)
+/*
+ * Sprites that nothing happens to within a cycle (no DMA, trigger, halt,
+ * or change of their MC and X expansion bits) are shifted out 8 pixels
+ * at a time by draw_sprites8() before the pixel loop.  Their pixels are
+ * kept here, and draw_sprites() only composites them.
+ */
+static uint8_t steady_bits = 0;
+static uint8_t steady_pixels[8][8];
+
+/* Sprite `s' over a whole cycle, as draw_sprites() would draw it.
+   Returns the pixels that are set, bit 0 for pixel 0.  */
+static DRAW_INLINE uint8_t draw_sprite_steady(int s)
+{
+    uint8_t m = 1 << s;
+    uint32_t sbuf = sbuf_reg[s];
+    uint8_t pixel = sbuf_pixel_reg[s];
+    uint8_t expx_flop = sbuf_expx_flops & m;
+    uint8_t mc_flop = sbuf_mc_flops & m;
+    uint8_t *px = steady_pixels[s];
+    uint8_t set = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        if (!sbuf && !pixel) {
+            /* shifted out, nothing more to draw */
+            sprite_active_bits &= ~m;
+            memset(px + i, 0, 8 - i);
+            break;
+        }
+        if (expx_flop) {
+            if (sprite_mc_bits & m) {
+                if (mc_flop) {
+                    /* fetch 2 bits */
+                    pixel = (uint8_t)((sbuf >> 22) & 0x03);
+                }
+                mc_flop ^= m;
+            } else {
+                /* fetch 1 bit and make it 0 or 2 */
+                pixel = (uint8_t)(((sbuf >> 23) & 0x01) << 1);
+            }
+            sbuf <<= 1;
+        }
+        if (sprite_expx_bits & m) {
+            expx_flop ^= m;
+        } else {
+            expx_flop = m;
+        }
+        px[i] = pixel;
+        if (pixel) {
+            set |= 1 << i;
+        }
+    }
+
+    sbuf_reg[s] = sbuf;
+    sbuf_pixel_reg[s] = pixel;
+    sbuf_expx_flops = (sbuf_expx_flops & ~m) | expx_flop;
+    sbuf_mc_flops = (sbuf_mc_flops & ~m) | mc_flop;
+
+    return set;
+}
+
+/* Turn the set pixels of each sprite (byte s, bit i) into the sprites set
+   at each pixel (byte i, bit s).  */
+static DRAW_INLINE uint64_t transpose8(uint64_t x)
+{
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00aa00aa00aa00aaULL;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000ccccULL;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0ULL;
+    x = x ^ t ^ (t << 28);
+
+    return x;
+}
+
+static DRAW_INLINE void draw_sprites(int i, uint8_t steady_mask)
 {
     int s;
-    int active_sprite;
     uint8_t collision_mask;
+    uint8_t pixel;
 
     /* do nothing if all sprites are inactive */
-    if (!sprite_active_bits) {
+    if (!(sprite_active_bits & ~steady_bits) && !steady_mask) {
         return;
     }
 
     /* check for active sprites */
-    active_sprite = -1;
     collision_mask = 0;
     for (s = 7; s >= 0; --s) {
         uint8_t m = 1 << s;
 
-        if (sprite_active_bits & m) {
+        if (sprite_active_bits & ~steady_bits & m) {
             /* render pixels if shift register or pixel reg still contains data */
             if (sbuf_reg[s] || sbuf_pixel_reg[s]) {
                 if (!(sprite_halt_bits & m)) {
@@ -382,12 +553,8 @@ static DRAW_INLINE void draw_sprites(int i)
                     }
                 }
 
-                /*
-                 * set collision mask bits and determine the highest
-                 * priority sprite number that has a pixel.
-                 */
+                /* set collision mask bits */
                 if (sbuf_pixel_reg[s]) {
-                    active_sprite = s;
                     collision_mask |= m;
                 }
             } else {
@@ -396,12 +563,17 @@ static DRAW_INLINE void draw_sprites(int i)
         }
     }
 
+    collision_mask |= steady_mask;
+
     if (collision_mask) {
         uint8_t pixel_pri = pri_buffer[i];
-        int as = active_sprite;
+        /* the lowest numbered sprite with a pixel is in front */
+        int as = __builtin_ctz(collision_mask);
         uint8_t spri = sprite_pri_bits & (1 << as);
+
+        pixel = (steady_bits & (1 << as)) ? steady_pixels[as][i] : sbuf_pixel_reg[as];
         if (!(pixel_pri && spri)) {
-            switch (sbuf_pixel_reg[as]) {
+            switch (pixel) {
                 case 1:
                     render_buffer[i] = COL_D025;
                     break;
@@ -469,8 +641,10 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     uint8_t candidate_bits;
     uint8_t dma_cycle_0 = 0;
     uint8_t dma_cycle_2 = 0;
+    uint64_t steady_masks = 0;
     int xpos;
     int spr_en;
+    int s;
 
     xpos = cycle_get_xpos(cycle_flags);
 
@@ -484,31 +658,48 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     }
     candidate_bits = get_trigger_candidates(xpos);
 
+    /* shift out the sprites nothing happens to in this cycle */
+    steady_bits = sprite_active_bits & ~sprite_halt_bits & ~candidate_bits
+                  & ~dma_cycle_0 & ~dma_cycle_2
+                  & ~(vicii.regs[0x1c] ^ sprite_mc_bits)
+                  & ~(vicii.regs[0x1d] ^ sprite_expx_bits);
+    if (draw_per_pixel) {
+        steady_bits = 0;
+    }
+    if (steady_bits) {
+        for (s = 0; s < 8; s++) {
+            if (steady_bits & (1 << s)) {
+                steady_masks |= (uint64_t)draw_sprite_steady(s) << (s * 8);
+            }
+        }
+        steady_masks = transpose8(steady_masks);
+    }
+
     /* process and render sprites */
     /* pixel 0 */
     trigger_sprites(xpos + 0, candidate_bits);
-    draw_sprites(0);
+    draw_sprites(0, (uint8_t)steady_masks);
     /* pixel 1 */
     trigger_sprites(xpos + 1, candidate_bits);
-    draw_sprites(1);
+    draw_sprites(1, (uint8_t)(steady_masks >> 8));
     /* pixel 2 */
     sprite_active_bits &= ~dma_cycle_2;
     trigger_sprites(xpos + 2, candidate_bits);
-    draw_sprites(2);
+    draw_sprites(2, (uint8_t)(steady_masks >> 16));
     /* pixel 3 */
     sprite_halt_bits |= dma_cycle_0;
     trigger_sprites(xpos + 3, candidate_bits);
-    draw_sprites(3);
+    draw_sprites(3, (uint8_t)(steady_masks >> 24));
     /* pixel 4 */
     if (spr_en) {
         sprite_pending_bits = vicii.sprite_display_bits;
     }
     update_sprite_data(cycle_flags);
     trigger_sprites(xpos + 4, candidate_bits);
-    draw_sprites(4);
+    draw_sprites(4, (uint8_t)(steady_masks >> 32));
     /* pixel 5 */
     trigger_sprites(xpos + 5, candidate_bits);
-    draw_sprites(5);
+    draw_sprites(5, (uint8_t)(steady_masks >> 40));
     /* pixel 6 */
     if (!vicii.color_latency) {
         update_sprite_mc_bits_8565();
@@ -516,14 +707,15 @@ static DRAW_INLINE void draw_sprites8(unsigned int cycle_flags)
     sprite_pri_bits = vicii.regs[0x1b];
     sprite_expx_bits = vicii.regs[0x1d];
     trigger_sprites(xpos + 6, candidate_bits);
-    draw_sprites(6);
+    draw_sprites(6, (uint8_t)(steady_masks >> 48));
     /* pixel 7 */
     if (vicii.color_latency) {
         update_sprite_mc_bits_6569();
     }
     sprite_halt_bits &= ~dma_cycle_2;
     trigger_sprites(xpos + 7, candidate_bits);
-    draw_sprites(7);
+    draw_sprites(7, (uint8_t)(steady_masks >> 56));
+    steady_bits = 0;
 
     /* pipe xpos */
     update_sprite_xpos();
@@ -685,9 +877,235 @@ void vicii_draw_cycle(void)
 }
 
 
+#ifdef VICE_BENCH
+#define BENCH_DRAW_FRAMES   5
+#define BENCH_DRAW_LINES    312
+#define BENCH_DRAW_OUT      (VICII_DRAW_BUFFER_SIZE + 2)
+
+/* The registers written in a cycle, 0xff for no color register.  */
+typedef struct bench_cycle_s {
+    uint8_t gbuf;
+    uint8_t d011, d016, d01b, d01c, d01d;
+    uint8_t color_reg, color_value;
+} bench_cycle_t;
+
+/* What the fetches left for a line.  */
+typedef struct bench_line_s {
+    uint8_t vbuf[VICII_SCREEN_TEXTCOLS];
+    uint8_t cbuf[VICII_SCREEN_TEXTCOLS];
+    uint32_t sprite_data[8];
+    int sprite_x[8];
+    uint8_t sprite_display_bits;
+    uint8_t idle_state;
+    uint8_t vborder;
+    uint8_t main_border;
+} bench_line_t;
+
+static uint32_t bench_seed;
+
+static uint32_t bench_rand(void)
+{
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return bench_seed >> 8;
+}
+
+static uint8_t *bench_save_state(size_t *size)
+{
+    snapshot_t *s;
+    snapshot_module_t *m;
+
+    s = snapshot_memory_create(NULL, 0, 0, 0, "BENCH");
+    if (s == NULL) {
+        return NULL;
+    }
+    m = snapshot_module_create(s, "VICIIDRAW", 0, 0);
+    if (m == NULL || vicii_draw_cycle_snapshot_write(m) < 0) {
+        snapshot_close(s);
+        return NULL;
+    }
+    snapshot_module_close(m);
+    return snapshot_memory_take(s, size, NULL);
+}
+
+static void bench_restore_state(const uint8_t *data, size_t size)
+{
+    snapshot_t *s;
+    snapshot_module_t *m;
+    uint8_t major, minor;
+
+    s = snapshot_memory_open(data, size, &major, &minor, "BENCH");
+    if (s == NULL) {
+        return;
+    }
+    m = snapshot_module_open(s, "VICIIDRAW", &major, &minor);
+    if (m != NULL) {
+        vicii_draw_cycle_snapshot_read(m);
+        snapshot_module_close(m);
+    }
+    snapshot_close(s);
+}
+
+/* Draws the same random stream of mode, color and sprite register changes
+   once pixel by pixel and once with the 8 pixel spans and steady sprites,
+   and compares the pixels and collisions of every line.  */
+static void vicii_draw_cycle_bench(void)
+{
+    vicii_t *saved;
+    uint8_t *state, *out[2];
+    bench_cycle_t *cycle_in, *c;
+    bench_line_t *line_in, *l;
+    size_t state_size = 0, out_size;
+    unsigned int cycles, i, j, s, n, y;
+    double ns[2];
+    int k, identical;
+
+    state = bench_save_state(&state_size);
+    if (state == NULL) {
+        return;
+    }
+    saved = lib_malloc(sizeof(vicii_t));
+    memcpy(saved, &vicii, sizeof(vicii_t));
+
+    cycles = (unsigned int)vicii.cycles_per_line;
+    out_size = (size_t)BENCH_DRAW_FRAMES * BENCH_DRAW_LINES * BENCH_DRAW_OUT;
+    out[0] = lib_malloc(out_size);
+    out[1] = lib_malloc(out_size);
+    cycle_in = lib_malloc(sizeof(bench_cycle_t) * BENCH_DRAW_LINES * cycles);
+    line_in = lib_malloc(sizeof(bench_line_t) * BENCH_DRAW_LINES);
+
+    bench_seed = 1;
+    for (y = 0; y < BENCH_DRAW_LINES; y++) {
+        uint8_t d011, d016, d01b, d01c, d01d;
+
+        l = &line_in[y];
+        for (i = 0; i < VICII_SCREEN_TEXTCOLS; i++) {
+            l->vbuf[i] = (uint8_t)bench_rand();
+            l->cbuf[i] = (uint8_t)(bench_rand() & 0x0f);
+        }
+        for (s = 0; s < 8; s++) {
+            l->sprite_data[s] = bench_rand() & 0xffffff;
+            l->sprite_x[s] = (int)(bench_rand() % 0x1f8);
+        }
+        l->sprite_display_bits = (uint8_t)bench_rand();
+        l->idle_state = (bench_rand() & 15) == 0;
+        l->vborder = (y & 63) == 63;
+        l->main_border = (bench_rand() & 7) == 0;
+
+        /* mostly one mode per line, with the odd change mid line */
+        d011 = (uint8_t)(0x1b | (bench_rand() & 0x60));
+        d016 = (uint8_t)(0x08 | (bench_rand() & 0x17));
+        d01b = (uint8_t)bench_rand();
+        d01c = (uint8_t)bench_rand();
+        d01d = (uint8_t)bench_rand();
+        for (i = 0; i < cycles; i++) {
+            c = &cycle_in[y * cycles + i];
+            if ((bench_rand() & 63) == 0) {
+                d011 = (uint8_t)(0x1b | (bench_rand() & 0x60));
+            }
+            if ((bench_rand() & 63) == 0) {
+                d016 = (uint8_t)(0x08 | (bench_rand() & 0x17));
+            }
+            if ((bench_rand() & 127) == 0) {
+                d01b = (uint8_t)bench_rand();
+            }
+            if ((bench_rand() & 127) == 0) {
+                d01c = (uint8_t)bench_rand();
+            }
+            if ((bench_rand() & 127) == 0) {
+                d01d = (uint8_t)bench_rand();
+            }
+            c->gbuf = (uint8_t)bench_rand();
+            c->d011 = d011;
+            c->d016 = d016;
+            c->d01b = d01b;
+            c->d01c = d01c;
+            c->d01d = d01d;
+            if ((bench_rand() & 15) == 0) {
+                c->color_reg = (uint8_t)(COL_D020 + bench_rand() % 15);
+                c->color_value = (uint8_t)(bench_rand() & 0x0f);
+            } else {
+                c->color_reg = 0xff;
+                c->color_value = 0;
+            }
+        }
+    }
+
+    for (k = 0; k < 2; k++) {
+        uint8_t *o = out[k];
+        uint64_t start;
+
+        bench_restore_state(state, state_size);
+        memcpy(&vicii, saved, sizeof(vicii_t));
+        vicii.sprite_sprite_collisions = 0;
+        vicii.sprite_background_collisions = 0;
+        draw_per_pixel = !k;
+
+        start = bench_ticks();
+        for (n = 0; n < BENCH_DRAW_FRAMES; n++) {
+            for (y = 0; y < BENCH_DRAW_LINES; y++) {
+                l = &line_in[y];
+                memcpy(vicii.vbuf, l->vbuf, VICII_SCREEN_TEXTCOLS);
+                memcpy(vicii.cbuf, l->cbuf, VICII_SCREEN_TEXTCOLS);
+                for (s = 0; s < 8; s++) {
+                    vicii.sprite[s].data = l->sprite_data[s];
+                    vicii.sprite[s].x = l->sprite_x[s];
+                }
+                vicii.sprite_display_bits = l->sprite_display_bits;
+                vicii.idle_state = l->idle_state;
+                vicii.vborder = l->vborder;
+                vicii.main_border = l->main_border;
+
+                for (i = 0; i < cycles; i++) {
+                    c = &cycle_in[y * cycles + i];
+                    vicii.raster_cycle = i;
+                    vicii.cycle_flags = vicii.cycle_table[i];
+                    vicii.gbuf = c->gbuf;
+                    vicii.regs[0x11] = c->d011;
+                    vicii.regs[0x16] = c->d016;
+                    vicii.regs[0x1b] = c->d01b;
+                    vicii.regs[0x1c] = c->d01c;
+                    vicii.regs[0x1d] = c->d01d;
+                    vicii.last_color_reg = c->color_reg;
+                    vicii.last_color_value = c->color_value;
+                    vicii_draw_cycle();
+                }
+
+                memcpy(o, vicii.dbuf, VICII_DRAW_BUFFER_SIZE);
+                o[VICII_DRAW_BUFFER_SIZE] = vicii.sprite_sprite_collisions;
+                o[VICII_DRAW_BUFFER_SIZE + 1] = vicii.sprite_background_collisions;
+                vicii.sprite_sprite_collisions = 0;
+                vicii.sprite_background_collisions = 0;
+                o += BENCH_DRAW_OUT;
+            }
+        }
+        ns[k] = (double)(bench_ticks() - start) * 1e9 / bench_ticks_per_second() / BENCH_DRAW_FRAMES;
+    }
+    for (j = 0; j < out_size && out[0][j] == out[1][j]; j++) {
+        /* find the first line that differs */
+    }
+    identical = (j == out_size);
+
+    log_message(vicii.log, "viciisc: %u cycle lines %.3f ms/frame per pixel, %.3f ms/frame in spans%s",
+                cycles, ns[0] / 1e6, ns[1] / 1e6, identical ? "" : ", OUTPUT DIFFERS");
+    printf("BENCH viciisc cycles=%u pixel_ms_per_frame=%.3f span_ms_per_frame=%.3f speedup=%.2f identical=%d first_diff_line=%d\n",
+           cycles, ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1], identical,
+           identical ? -1 : (int)(j / BENCH_DRAW_OUT));
+
+    draw_per_pixel = 0;
+    memcpy(&vicii, saved, sizeof(vicii_t));
+    bench_restore_state(state, state_size);
+    lib_free(saved);
+    lib_free(state);
+    lib_free(out[0]);
+    lib_free(out[1]);
+    lib_free(cycle_in);
+    lib_free(line_in);
+}
+#endif
+
 void vicii_draw_cycle_init(void)
 {
-    int i;
+    int i, j;
 
     /* initialize the draw buffer */
     memset(vicii.dbuf, 0, VICII_DRAW_BUFFER_SIZE);
@@ -696,6 +1114,12 @@ void vicii_draw_cycle_init(void)
     /* initialize the pixel ring buffer. */
     memset(pixel_buffer, 0, sizeof(pixel_buffer));
 
+    for (i = 0; i < 0x100; i++) {
+        for (j = 0; j < 8; j++) {
+            hires_mask[i][j] = (i & (0x80 >> j)) ? 0xff : 0;
+        }
+    }
+
     /* clear cregs and fill 0x00-0x0f with 1:1 mapping */
     memset(cregs, 0, sizeof(cregs));
     for (i = 0; i < 0x10; i++) {
@@ -705,6 +1129,10 @@ void vicii_draw_cycle_init(void)
     last_color_reg = 0xff;
 
     cycle_flags_pipe = 0;
+
+#ifdef VICE_BENCH
+    bench_register_micro("viciisc", vicii_draw_cycle_bench);
+#endif
 }
 
 
@@ -56,15 +56,8 @@
 #define SNAP_MAJOR        0
 #define SNAP_MINOR        0
 
-int c128_snapshot_write(const char *name, int save_roms, int save_disks, int save_settings, int event_mode)
+static int c128_snapshot_write_snapshot(snapshot_t *s, int save_roms, int save_disks, int save_settings, int event_mode, int memory)
 {
-    snapshot_t *s;
-
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
-    if (s == NULL) {
-        return -1;
-    }
-
     sound_snapshot_prepare();
 
     if (maincpu_snapshot_write_module(s) < 0
@@ -72,7 +65,8 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int sav
         || ciacore_snapshot_write_module(machine_context.cia1, s) < 0
         || ciacore_snapshot_write_module(machine_context.cia2, s) < 0
         || sid_snapshot_write_module(s) < 0
-        || drive_snapshot_write_module(s, save_disks, save_roms) < 0
+        || (memory ? drive_snapshot_write_quick_module(s)
+                   : drive_snapshot_write_module(s, save_disks, save_roms)) < 0
         || vicii_snapshot_write_module(s) < 0
         || event_snapshot_write_module(s, event_mode) < 0
         || tapeport_snapshot_write_module(s, save_disks) < 0
@@ -81,6 +75,22 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int sav
         || joyport_snapshot_write_module(s, JOYPORT_2) < 0
         || userport_snapshot_write_module(s) < 0
 		|| resources_snapshot_write_module(s, save_settings) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int c128_snapshot_write(const char *name, int save_roms, int save_disks, int save_settings, int event_mode)
+{
+    snapshot_t *s;
+
+    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
+    if (s == NULL) {
+        return -1;
+    }
+
+    if (c128_snapshot_write_snapshot(s, save_roms, save_disks, save_settings, event_mode, 0) < 0) {
         snapshot_close(s);
         ioutil_remove(name);
         return -1;
@@ -90,16 +100,26 @@ int c128_snapshot_write(const char *name, int save_roms, int save_disks, int sav
     return 0;
 }
 
-int c128_snapshot_read(const char *name, int event_mode)
+int c128_snapshot_write_memory(uint8_t **buffer, size_t *size, size_t *buffer_size)
 {
     snapshot_t *s;
-    uint8_t minor, major;
+    int retval;
 
-    s = snapshot_open(name, &major, &minor, SNAP_MACHINE_NAME);
+    s = snapshot_memory_create(*buffer, *buffer_size, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), SNAP_MACHINE_NAME);
     if (s == NULL) {
+        *buffer = NULL;
+        *buffer_size = 0;
         return -1;
     }
 
+    retval = c128_snapshot_write_snapshot(s, 0, 0, 0, 0, 1);
+
+    *buffer = snapshot_memory_take(s, size, buffer_size);
+    return retval;
+}
+
+static int c128_snapshot_read_snapshot(snapshot_t *s, uint8_t major, uint8_t minor, int event_mode, int memory)
+{
     if (major != SNAP_MAJOR || minor != SNAP_MINOR) {
         log_message(LOG_DEFAULT, "Snapshot version (%d.%d) not valid: expecting %d.%d.", major, minor, SNAP_MAJOR, SNAP_MINOR);
         snapshot_set_error(SNAPSHOT_MODULE_INCOMPATIBLE);
@@ -115,7 +135,8 @@ int c128_snapshot_read(const char *name, int event_mode)
         || ciacore_snapshot_read_module(machine_context.cia1, s) < 0
         || ciacore_snapshot_read_module(machine_context.cia2, s) < 0
         || sid_snapshot_read_module(s) < 0
-        || drive_snapshot_read_module(s) < 0
+        || (memory ? drive_snapshot_read_quick_module(s)
+                   : drive_snapshot_read_module(s)) < 0
         || vicii_snapshot_read_module(s) < 0
         || event_snapshot_read_module(s, event_mode) < 0
         || tapeport_snapshot_read_module(s) < 0
@@ -138,7 +159,36 @@ fail:
         snapshot_close(s);
     }
 
-    machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    /* rewind and run-ahead deal with their own failures */
+    if (!memory) {
+        machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    }
 
     return -1;
 }
+
+int c128_snapshot_read(const char *name, int event_mode)
+{
+    snapshot_t *s;
+    uint8_t minor, major;
+
+    s = snapshot_open(name, &major, &minor, SNAP_MACHINE_NAME);
+    if (s == NULL) {
+        return -1;
+    }
+
+    return c128_snapshot_read_snapshot(s, major, minor, event_mode, 0);
+}
+
+int c128_snapshot_read_memory(const uint8_t *data, size_t size)
+{
+    snapshot_t *s;
+    uint8_t minor, major;
+
+    s = snapshot_memory_open(data, size, &major, &minor, SNAP_MACHINE_NAME);
+    if (s == NULL) {
+        return -1;
+    }
+
+    return c128_snapshot_read_snapshot(s, major, minor, 0, 1);
+}
@@ -1358,6 +1358,16 @@ int machine_read_snapshot(const char *name, int event_mode)
     return c128_snapshot_read(name, event_mode);
 }
 
+int machine_write_snapshot_memory(uint8_t **buffer, size_t *size, size_t *buffer_size)
+{
+    return c128_snapshot_write_memory(buffer, size, buffer_size);
+}
+
+int machine_read_snapshot_memory(const uint8_t *data, size_t size)
+{
+    return c128_snapshot_read_memory(data, size);
+}
+
 /* ------------------------------------------------------------------------- */
 
 int machine_autodetect_psid(const char *name)
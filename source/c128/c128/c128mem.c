@@ -121,6 +121,27 @@ static int mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Pointers to the currently used direct access tables (see mem.h).  */
+uint8_t **_mem_read_direct_tab_ptr;
+uint8_t **_mem_write_direct_tab_ptr;
+
+/* Direct access tables, filled in from the read and write tables the first
+   time a configuration is used.  RAM pages depend on the selected RAM bank
+   and the store functions on the video bank, so each table remembers which
+   ones it was filled in for.  */
+static uint8_t *mem_read_direct_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_write_direct_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_direct_ram_bank[NUM_CONFIGS];
+static int mem_direct_vbank[NUM_CONFIGS];
+
+/* Generation each direct table was filled in for; bumped whenever the read
+   or write tables change.  */
+static unsigned int mem_direct_generation = 1;
+static unsigned int mem_direct_valid[NUM_CONFIGS];
+
+/* All NULL, used while watchpoints are active.  */
+static uint8_t *mem_direct_tab_none[0x101];
+
 /* Current video bank (0, 1, 2 or 3 in the first bank,
    4, 5, 6 or 7 in the second bank).  */
 static int vbank = 0;
@@ -160,6 +181,73 @@ static void watch_store(uint16_t addr, uint8_t value)
     mem_write_tab[vbank][mem_config][addr >> 8](addr, value);
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Pages whose read or store function only accesses a plain RAM or ROM array
+   get a direct pointer, everything else (I/O, MMU, shared RAM, cartridges,
+   function ROMs and the video bank handlers) keeps going through the function
+   tables.  */
+static void mem_direct_tab_fill(int config)
+{
+    int i;
+
+    for (i = 0; i <= 0x100; i++) {
+        read_func_ptr_t rf = mem_read_tab[config][i];
+        store_func_ptr_t sf = mem_write_tab[vbank][config][i];
+        uint8_t *p = NULL;
+
+        if (i == 0 || i == 1 || i == 0x100) {
+            rf = NULL;
+            sf = NULL;
+        }
+
+        if (rf == ram_read) {
+            p = ram_bank;
+        } else if (rf == basic_lo_read || rf == basic_hi_read || rf == editor_read) {
+            p = c128memrom_basic_rom - 0x4000;
+        } else if (rf == hi_read) {
+            p = c128memrom_kernal_rom + ((i << 8) & 0x1fff) - (i << 8);
+        } else if (rf == c64memrom_basic64_read) {
+            p = c64memrom_basic64_rom + ((i << 8) & 0x1fff) - (i << 8);
+        } else if (rf == c64memrom_kernal64_read) {
+            p = c64memrom_kernal64_rom + ((i << 8) & 0x1fff) - (i << 8);
+        }
+        mem_read_direct_tab[config][i] = p;
+
+        if (sf == ram_store || sf == basic_lo_store || sf == basic_hi_store) {
+            mem_write_direct_tab[config][i] = ram_bank;
+        } else {
+            mem_write_direct_tab[config][i] = NULL;
+        }
+    }
+    mem_direct_ram_bank[config] = ram_bank;
+    mem_direct_vbank[config] = vbank;
+    mem_direct_valid[config] = mem_direct_generation;
+}
+
+static void mem_direct_tab_update(void)
+{
+    if (watchpoints_active) {
+        _mem_read_direct_tab_ptr = mem_direct_tab_none;
+        _mem_write_direct_tab_ptr = mem_direct_tab_none;
+        return;
+    }
+
+    if (mem_direct_valid[mem_config] != mem_direct_generation
+        || mem_direct_ram_bank[mem_config] != ram_bank
+        || mem_direct_vbank[mem_config] != vbank) {
+        mem_direct_tab_fill(mem_config);
+    }
+    _mem_read_direct_tab_ptr = mem_read_direct_tab[mem_config];
+    _mem_write_direct_tab_ptr = mem_write_direct_tab[mem_config];
+}
+
+/* Called whenever the read or write tables are changed.  */
+static void mem_direct_tab_invalidate(void)
+{
+    mem_direct_generation++;
+}
+
 void mem_toggle_watchpoints(int flag, void *context)
 {
     if (flag) {
@@ -170,6 +258,7 @@ void mem_toggle_watchpoints(int flag, void *context)
         _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
     }
     watchpoints_active = flag;
+    mem_direct_tab_update();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -209,6 +298,7 @@ void mem_update_config(int config)
 
     _mem_read_base_tab_ptr = mem_read_base_tab[config];
     mem_read_limit_tab_ptr = mem_read_limit_tab[config];
+    mem_direct_tab_update();
 
     maincpu_resync_limits();
 
@@ -675,11 +765,13 @@ void mem_set_write_hook(int config, int page, store_func_t *f)
     for (i = 0; i < NUM_VBANKS; i++) {
         mem_write_tab[i][config][page] = f;
     }
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func)
 {
     mem_read_tab[base][index] = read_func;
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
@@ -837,6 +929,9 @@ void mem_initialize_memory(void)
     c64pla_pport_reset();
 
     cartridge_init_config();
+
+    mem_direct_tab_invalidate();
+    mem_direct_tab_update();
 }
 
 #ifdef _MSC_VER
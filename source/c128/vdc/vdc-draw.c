@@ -31,6 +31,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef VICE_BENCH
+#include "bench.h"
+#include "lib.h"
+#include "log.h"
+#endif
 #include "raster-cache-const.h"
 #include "raster-cache-fill.h"
 #include "raster-cache.h"
@@ -195,6 +200,185 @@ index = where in the screen memory we are, to check against the cursor */
     return data;
 }
 
+/*-----------------------------------------------------------------------*/
+
+/* The glyph cache: one row of a character as drawn in 80 column text
+   mode, i.e. its byte after attributes, underline, semigraphics and
+   reverse have been applied, and the 8 pixels it becomes.  The glyphs
+   are looked up by a hash of the character row, the character and its
+   attribute.  Everything else they depend on is the same for the whole
+   screen and is checked on every line: when it changes, or the character
+   RAM is written to (see vdc_draw_ram_changed()), all the glyphs are
+   dropped by moving to a new generation.  The cursor is not part of the
+   glyphs, it only inverts its character.  */
+
+#define GLYPH_BITS          13
+#define GLYPH_ROWS          32
+
+/* key: generation | row | monochrome | attribute | character */
+#define GLYPH_MONO          0x10000
+#define GLYPH_ROW_SHIFT     17
+#define GLYPH_GEN_SHIFT     22
+#define GLYPH_GEN_MAX       (1U << (32 - GLYPH_GEN_SHIFT))
+
+typedef struct glyph_s {
+    uint32_t key;
+    uint32_t pixels[2];
+    uint8_t data;
+} glyph_t;
+
+static glyph_t glyph_cache[1 << GLYPH_BITS];
+
+static uint32_t glyph_generation = 1;
+
+/* the registers the current generation was made with */
+static uint64_t glyph_state = (uint64_t)-1;
+
+/* set up for the current line by glyph_setup_line() */
+static uint32_t glyph_line_key;
+static uint8_t glyph_attr_mask;
+static uint8_t glyph_cursor;
+
+/* cleared by the benchmark, to compare with the plain drawing */
+static int glyph_cache_enabled = 1;
+
+static unsigned int glyph_lookups, glyph_misses;
+
+static void glyph_flush(void)
+{
+    if (++glyph_generation == GLYPH_GEN_MAX) {
+        memset(glyph_cache, 0, sizeof(glyph_cache));
+        glyph_generation = 1;
+    }
+}
+
+static void glyph_setup_line(void)
+{
+    int l = vdc.raster.ycounter;
+    uint64_t state;
+
+    state = (uint64_t)(vdc.regs[22] & 0x0f)
+            | ((uint64_t)vdc.regs[23] << 4)
+            | ((uint64_t)vdc.regs[29] << 12)
+            | ((uint64_t)vdc.regs[26] << 20)
+            | ((uint64_t)(vdc.regs[25] & 0x20) << 23)
+            | ((uint64_t)(vdc.regs[24] & 0x40) << 23)
+            | ((uint64_t)vdc.bytes_per_char << 30)
+            | ((uint64_t)vdc.chargen_adr << 36);
+    if (state != glyph_state) {
+        glyph_state = state;
+        glyph_flush();
+    }
+
+    glyph_line_key = (glyph_generation << GLYPH_GEN_SHIFT) | ((uint32_t)l << GLYPH_ROW_SHIFT);
+
+    /* a flashing character is only different while it is blanked */
+    glyph_attr_mask = vdc.attribute_blink ? 0xff : (uint8_t)~VDC_FLASH_ATTR;
+
+    glyph_cursor = 0;
+    if ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3]) {
+        if (((l >= (vdc.regs[10] & 0x1F)) && (l < (vdc.regs[11] & 0x1F)))
+            || ((l == (vdc.regs[10] & 0x1F)) && (l == (vdc.regs[11] & 0x1F)))
+            || (((vdc.regs[10] & 0x1F) > (vdc.regs[11] & 0x1F)) && ((l >= (vdc.regs[10] & 0x1F)) || (l < (vdc.regs[11] & 0x1F))))) {
+            glyph_cursor = 0xff;
+        }
+    }
+}
+
+inline static glyph_t *glyph_slot(uint32_t key)
+{
+    return glyph_cache + ((key * 2654435761U) >> (32 - GLYPH_BITS));
+}
+
+/* Attribute mode, as get_attr_char_data().  */
+inline static const glyph_t *get_glyph_attr(uint8_t c, uint8_t a)
+{
+    glyph_t *g;
+    uint32_t key;
+
+    a &= glyph_attr_mask;
+    key = glyph_line_key | (a << 8) | c;
+    g = glyph_slot(key);
+
+    if (g->key != key) {
+        uint32_t *ptr = hr_table + ((a & 0x0f) << 8) + ((vdc.regs[26] & 0x0f) << 4);
+        uint8_t d = get_attr_char_data(c, a, vdc.raster.ycounter,
+                                       vdc.ram + vdc.chargen_adr,
+                                       vdc.bytes_per_char, 0, 0, -1, 0);
+
+        g->key = key;
+        g->data = d;
+        g->pixels[0] = ptr[d >> 4];
+        g->pixels[1] = ptr[d & 0x0f];
+        glyph_misses++;
+    }
+    return g;
+}
+
+/* Monochrome mode, as draw_std_text().  */
+inline static const glyph_t *get_glyph_mono(uint8_t c)
+{
+    glyph_t *g;
+    uint32_t key;
+
+    key = glyph_line_key | GLYPH_MONO | c;
+    g = glyph_slot(key);
+
+    if (g->key != key) {
+        uint32_t *ptr = hr_table + (vdc.regs[26] << 4);
+        uint8_t d;
+
+        d = vdc.ram[vdc.chargen_adr + c * vdc.bytes_per_char + vdc.raster.ycounter];
+        d &= mask[vdc.regs[22] & 0x0F];
+        if ((vdc.regs[25] & 0x20) && (d & semigfxtest[vdc.regs[22] & 0x0F])) {
+            d |= semigfxmask[vdc.regs[22] & 0x0F];
+        }
+        if (vdc.regs[24] & VDC_REVERSE_ATTR) {
+            d ^= 0xff;
+        }
+
+        g->key = key;
+        g->data = d;
+        g->pixels[0] = ptr[d >> 4];
+        g->pixels[1] = ptr[d & 0x0f];
+        glyph_misses++;
+    }
+    return g;
+}
+
+inline static uint8_t glyph_char_data(uint8_t c, uint8_t a, int curpos, int index)
+{
+    uint8_t d = get_glyph_attr(c, a)->data;
+
+    if (curpos == index) {
+        d ^= glyph_cursor;
+    }
+    return d;
+}
+
+void vdc_draw_ram_changed(unsigned int addr, unsigned int len)
+{
+    /* both character sets, and a character row past them with 16 bytes
+       per character */
+    unsigned int size = 0x200 * vdc.bytes_per_char + GLYPH_ROWS;
+    unsigned int i;
+
+    for (i = 0; i < len; i++) {
+        if ((((addr + i) & vdc.vdc_address_mask) - vdc.chargen_adr) < size) {
+            glyph_flush();
+            return;
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+
+/* get_attr_char_data(), from the glyph cache if it can be used */
+#define ATTR_CHAR_DATA(c, a, i)                                            \
+    (use_glyphs ? glyph_char_data((c), (a), curpos, (i))                   \
+                : get_attr_char_data((c), (a), l, char_mem, bytes_per_char, \
+                                     blink, revers, curpos, (i)))
+
 inline static int cache_data_fill_attr_text(uint8_t *dest,
                                             const uint8_t *src,
                                             uint8_t *attr,
@@ -210,21 +394,25 @@ inline static int cache_data_fill_attr_text(uint8_t *dest,
                                             int curpos)
 {
     unsigned int i;
+    int use_glyphs = glyph_cache_enabled && (unsigned int)l < GLYPH_ROWS;
 
     /* Fill (*dest) with (length) bytes of character data from (*src)
     - VDC screen memory - using attributes (*attr) - VDC attribute memory -,
     at vertical character reference (l) from VDC memory character set
     (*char_mem) */
 
+    if (use_glyphs) {
+        glyph_setup_line();
+        glyph_lookups += length;
+    }
+
     if (no_check) {
         /* fill *dest regardless of any changes */
         /* xs/xe seem to the start & end of any data that was updated/filled */
         *xs = 0;
         *xe = length - 1;
         for (i = 0; i < length; i++, src++, attr++) {
-            dest[i] = get_attr_char_data(src[0], attr[0], l, char_mem,
-                                         bytes_per_char, blink, revers,
-                                         curpos, i);
+            dest[i] = ATTR_CHAR_DATA(src[0], attr[0], i);
         }
         /* dest data was updated */
         return 1;
@@ -232,8 +420,7 @@ inline static int cache_data_fill_attr_text(uint8_t *dest,
         uint8_t b;
         /* compare destination to data to look for any differences */
         for (i = 0; i < length; i++, src++, attr++) {
-            if (dest[i] != get_attr_char_data(src[0], attr[0], l, char_mem,
-                                              bytes_per_char, blink, revers, curpos, i)) {
+            if (dest[i] != ATTR_CHAR_DATA(src[0], attr[0], i)) {
                 break;
             }
         }
@@ -243,9 +430,7 @@ inline static int cache_data_fill_attr_text(uint8_t *dest,
             /* xs/xe set start/end address for modified data */
             /* compare & update *dest, adjusting *xe if needed */
             for (; i < length; i++, src++, attr++) {
-                b = get_attr_char_data(src[0], attr[0], l, char_mem,
-                                       bytes_per_char, blink, revers,
-                                       curpos, i);
+                b = ATTR_CHAR_DATA(src[0], attr[0], i);
                 if (dest[i] != b) {
                     dest[i] = b;
                     *xe = i;
@@ -522,6 +707,55 @@ static void draw_std_text_cached(raster_cache_t *cache, unsigned int xs,
     }
 }
 
+/* draw_std_text() from the glyph cache, for normal width characters
+   without inter character spacing; returns where the characters end.  */
+static uint8_t *draw_std_text_glyphs(uint8_t *p, unsigned int charwidth)
+{
+    uint8_t *attr_ptr, *screen_ptr;
+    const glyph_t *g;
+    uint32_t *ptr;
+    unsigned int i, cpos;
+    uint8_t d;
+
+    cpos = vdc.crsrpos - vdc.screen_adr - vdc.mem_counter;
+    attr_ptr = vdc.ram + vdc.attribute_adr + vdc.mem_counter;
+    screen_ptr = vdc.ram + vdc.screen_adr + vdc.mem_counter;
+
+    glyph_setup_line();
+    glyph_lookups += vdc.screen_text_cols;
+
+    if (vdc.regs[25] & 0x40) {
+        /* attribute mode */
+        for (i = 0; i < vdc.screen_text_cols; i++, p += charwidth) {
+            g = get_glyph_attr(screen_ptr[i], attr_ptr[i]);
+            if (cpos == i && glyph_cursor) {
+                d = g->data ^ glyph_cursor;
+                ptr = hr_table + ((attr_ptr[i] & 0x0f) << 8) + ((vdc.regs[26] & 0x0f) << 4);
+                *((uint32_t *)p) = ptr[d >> 4];
+                *((uint32_t *)p + 1) = ptr[d & 0x0f];
+            } else {
+                *((uint32_t *)p) = g->pixels[0];
+                *((uint32_t *)p + 1) = g->pixels[1];
+            }
+        }
+    } else {
+        /* monochrome mode - attributes from register 26 */
+        for (i = 0; i < vdc.screen_text_cols; i++, p += charwidth) {
+            g = get_glyph_mono(screen_ptr[i]);
+            if (cpos == i && glyph_cursor) {
+                d = g->data ^ glyph_cursor;
+                ptr = hr_table + (vdc.regs[26] << 4);
+                *((uint32_t *)p) = ptr[d >> 4];
+                *((uint32_t *)p + 1) = ptr[d & 0x0f];
+            } else {
+                *((uint32_t *)p) = g->pixels[0];
+                *((uint32_t *)p + 1) = g->pixels[1];
+            }
+        }
+    }
+    return p;
+}
+
 static void draw_std_text(void)
 /* raster_modes_draw_line() in raster - draw text mode when cache is not used
    This draws one raster line of text directly into the raster buffer
@@ -560,7 +794,11 @@ static void draw_std_text(void)
     screen_ptr = vdc.ram + vdc.screen_adr + vdc.mem_counter;
     char_ptr = vdc.ram + vdc.chargen_adr + vdc.raster.ycounter;
 
-    if (vdc.regs[25] & 0x40) {
+    if (glyph_cache_enabled && icsi < 0 && !(vdc.regs[25] & 0x10)
+        && (unsigned int)vdc.raster.ycounter < GLYPH_ROWS) {
+        /* 80 columns, the usual case */
+        p = draw_std_text_glyphs(p, charwidth);
+    } else if (vdc.regs[25] & 0x40) {
         /* attribute mode */
         /* regs[26] & 0xf is the background colour */
         table_ptr = hr_table + ((vdc.regs[26] & 0x0f) << 4);
@@ -1053,9 +1291,102 @@ static void setup_modes(void)
                      NULL);                             /*draw_std_text_foreground */
 }
 
+#ifdef VICE_BENCH
+#define BENCH_VDC_FRAMES    200
+#define BENCH_VDC_PITCH     704
+
+/* A made up 80x25 attribute mode screen drawn line by line, without and
+   with the glyph cache.  Like most screens, each row has mostly one
+   attribute, with a few characters in another one.  The VDC is put back
+   as it was afterwards.  */
+static void vdc_draw_bench(void)
+{
+    static const uint8_t attrs[8] = { 0x8f, 0x8f, 0x8f, 0x87, 0x8d, 0xcf, 0xaf, 0x9f };
+    vdc_t *saved;
+    uint8_t *frame[2];
+    size_t frame_size = BENCH_VDC_PITCH * 25 * 8;
+    uint32_t seed = 1;
+    unsigned int i, row, l, misses = 0, lookups = 0;
+    double ns[2];
+    int k, n, identical;
+
+    saved = lib_malloc(sizeof(vdc_t));
+    memcpy(saved, &vdc, sizeof(vdc_t));
+    frame[0] = lib_calloc(1, frame_size);
+    frame[1] = lib_calloc(1, frame_size);
+
+    vdc.regs[10] = 0x60;
+    vdc.regs[11] = 7;
+    vdc.regs[22] = 0x78;
+    vdc.regs[23] = 8;
+    vdc.regs[24] = 0;
+    vdc.regs[25] = 0x47;
+    vdc.regs[26] = 0xf0;
+    vdc.regs[29] = 7;
+    vdc.screen_adr = 0;
+    vdc.attribute_adr = 0x800;
+    vdc.chargen_adr = 0x2000;
+    vdc.bytes_per_char = 16;
+    vdc.screen_text_cols = 80;
+    vdc.crsrpos = 5 * 80 + 10;
+    vdc.border_width = 16;
+    vdc.xsmooth = 7;
+
+    for (i = 0; i < 0x200 * 16; i++) {
+        seed = seed * 1103515245 + 12345;
+        vdc.ram[vdc.chargen_adr + i] = (uint8_t)(seed >> 16);
+    }
+    for (i = 0; i < 80 * 25; i++) {
+        seed = seed * 1103515245 + 12345;
+        vdc.ram[vdc.screen_adr + i] = ((seed >> 16) & 3) ? (uint8_t)(0x01 + ((seed >> 18) % 0x1a)) : 0x20;
+        vdc.ram[vdc.attribute_adr + i] = attrs[((seed >> 24) & 15) ? (i / 80) & 7 : (seed >> 28) & 7];
+    }
+    glyph_flush();
+
+    for (k = 0; k < 2; k++) {
+        uint64_t start;
+
+        glyph_cache_enabled = k;
+        glyph_lookups = glyph_misses = 0;
+        start = bench_ticks();
+        for (n = 0; n < BENCH_VDC_FRAMES; n++) {
+            vdc.frame_counter = n;
+            vdc.attribute_blink = n & 16;
+            for (row = 0; row < 25; row++) {
+                vdc.mem_counter = row * 80;
+                for (l = 0; l < 8; l++) {
+                    vdc.raster.ycounter = l;
+                    vdc.raster.draw_buffer_ptr = frame[k] + (row * 8 + l) * BENCH_VDC_PITCH;
+                    draw_std_text();
+                }
+            }
+        }
+        ns[k] = (double)(bench_ticks() - start) * 1e9 / bench_ticks_per_second() / BENCH_VDC_FRAMES;
+        lookups = glyph_lookups;
+        misses = glyph_misses;
+    }
+    identical = memcmp(frame[0], frame[1], frame_size) ? 0 : 1;
+
+    log_message(vdc.log, "vdc: 80x25 text %.3f ms/frame, with the glyph cache %.3f ms/frame, %u of %u glyphs made%s",
+                ns[0] / 1e6, ns[1] / 1e6, misses, lookups, identical ? "" : ", OUTPUT DIFFERS");
+    printf("BENCH vdc cols=80 plain_ms_per_frame=%.3f glyph_ms_per_frame=%.3f speedup=%.2f lookups=%u misses=%u identical=%d\n",
+           ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1], lookups, misses, identical);
+
+    memcpy(&vdc, saved, sizeof(vdc_t));
+    glyph_cache_enabled = 1;
+    glyph_flush();
+    lib_free(saved);
+    lib_free(frame[0]);
+    lib_free(frame[1]);
+}
+#endif
+
 void vdc_draw_init(void)
 {
     init_drawing_tables();
 
     setup_modes();
+#ifdef VICE_BENCH
+    bench_register_micro("vdc", vdc_draw_bench);
+#endif
 }
@@ -66,6 +66,7 @@ static void vdc_write_data(void)
 
     /* Write data byte to update address. */
     vdc.ram[ptr & vdc.vdc_address_mask] = vdc.regs[31];
+    vdc_draw_ram_changed(ptr & vdc.vdc_address_mask, 1);
 #ifdef REG_DEBUG
     log_message(vdc.log, "STORE %04x %02x", ptr & vdc.vdc_address_mask,
                 vdc.regs[31]);
@@ -109,6 +110,8 @@ static void vdc_perform_fillcopy(void)
         }
     }
 
+    vdc_draw_ram_changed(ptr & vdc.vdc_address_mask, blklen);
+
     ptr = ptr + blklen;
     vdc.regs[18] = (ptr >> 8) & 0xff;
     vdc.regs[19] = ptr & 0xff;
@@ -574,6 +577,7 @@ uint8_t vdc_ram_read(uint16_t addr)
 void vdc_ram_store(uint16_t addr, uint8_t value)
 {
     vdc.ram[addr & vdc.vdc_address_mask] = value;
+    vdc_draw_ram_changed(addr & vdc.vdc_address_mask, 1);
 }
 
 
@@ -346,6 +346,7 @@ void vdc_powerup(void)
         vdc.ram[i] = v;
         v ^= 0xff;
     }
+    vdc_draw_ram_changed(0, sizeof(vdc.ram));
     memset(vdc.regs, 0, sizeof(vdc.regs));
     vdc.mem_counter = 0;
     vdc.mem_counter_inc = 0;
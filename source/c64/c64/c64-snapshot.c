@@ -57,15 +57,8 @@
 #define SNAP_MAJOR 1
 #define SNAP_MINOR 1
 
-int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save_settings, int event_mode)
+static int c64_snapshot_write_snapshot(snapshot_t *s, int save_roms, int save_disks, int save_settings, int event_mode, int memory)
 {
-    snapshot_t *s;
-
-    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
-    if (s == NULL) {
-        return -1;
-    }
-
     sound_snapshot_prepare();
 
     /* Execute drive CPUs to get in sync with the main CPU.  */
@@ -76,7 +69,8 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save
         || ciacore_snapshot_write_module(machine_context.cia1, s) < 0
         || ciacore_snapshot_write_module(machine_context.cia2, s) < 0
         || sid_snapshot_write_module(s) < 0
-        || drive_snapshot_write_module(s, save_disks, save_roms) < 0
+        || (memory ? drive_snapshot_write_quick_module(s)
+                   : drive_snapshot_write_module(s, save_disks, save_roms)) < 0
         || vicii_snapshot_write_module(s) < 0
         || c64_glue_snapshot_write_module(s) < 0
         || event_snapshot_write_module(s, event_mode) < 0
@@ -87,6 +81,22 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save
         || joyport_snapshot_write_module(s, JOYPORT_2) < 0
         || userport_snapshot_write_module(s) < 0
 		|| resources_snapshot_write_module(s, save_settings) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save_settings, int event_mode)
+{
+    snapshot_t *s;
+
+    s = snapshot_create(name, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
+    if (s == NULL) {
+        return -1;
+    }
+
+    if (c64_snapshot_write_snapshot(s, save_roms, save_disks, save_settings, event_mode, 0) < 0) {
         snapshot_close(s);
         ioutil_remove(name);
         return -1;
@@ -96,16 +106,26 @@ int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save
     return 0;
 }
 
-int c64_snapshot_read(const char *name, int event_mode)
+int c64_snapshot_write_memory(uint8_t **buffer, size_t *size, size_t *buffer_size)
 {
     snapshot_t *s;
-    uint8_t minor, major;
+    int retval;
 
-    s = snapshot_open(name, &major, &minor, machine_get_name());
+    s = snapshot_memory_create(*buffer, *buffer_size, ((uint8_t)(SNAP_MAJOR)), ((uint8_t)(SNAP_MINOR)), machine_get_name());
     if (s == NULL) {
+        *buffer = NULL;
+        *buffer_size = 0;
         return -1;
     }
 
+    retval = c64_snapshot_write_snapshot(s, 0, 0, 0, 0, 1);
+
+    *buffer = snapshot_memory_take(s, size, buffer_size);
+    return retval;
+}
+
+static int c64_snapshot_read_snapshot(snapshot_t *s, uint8_t major, uint8_t minor, int event_mode, int memory)
+{
     if (major != SNAP_MAJOR || minor != SNAP_MINOR) {
         log_error(LOG_DEFAULT, "Snapshot version (%d.%d) not valid: expecting %d.%d.", major, minor, SNAP_MAJOR, SNAP_MINOR);
         snapshot_set_error(SNAPSHOT_MODULE_INCOMPATIBLE);
@@ -121,7 +141,8 @@ int c64_snapshot_read(const char *name, int event_mode)
         || ciacore_snapshot_read_module(machine_context.cia1, s) < 0
         || ciacore_snapshot_read_module(machine_context.cia2, s) < 0
         || sid_snapshot_read_module(s) < 0
-        || drive_snapshot_read_module(s) < 0
+        || (memory ? drive_snapshot_read_quick_module(s)
+                   : drive_snapshot_read_module(s)) < 0
         || vicii_snapshot_read_module(s) < 0
         || c64_glue_snapshot_read_module(s) < 0
         || event_snapshot_read_module(s, event_mode) < 0
@@ -146,7 +167,36 @@ fail:
         snapshot_close(s);
     }
 
-    machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    /* rewind and run-ahead deal with their own failures */
+    if (!memory) {
+        machine_trigger_reset(MACHINE_RESET_MODE_SOFT);
+    }
 
     return -1;
 }
+
+int c64_snapshot_read(const char *name, int event_mode)
+{
+    snapshot_t *s;
+    uint8_t minor, major;
+
+    s = snapshot_open(name, &major, &minor, machine_get_name());
+    if (s == NULL) {
+        return -1;
+    }
+
+    return c64_snapshot_read_snapshot(s, major, minor, event_mode, 0);
+}
+
+int c64_snapshot_read_memory(const uint8_t *data, size_t size)
+{
+    snapshot_t *s;
+    uint8_t minor, major;
+
+    s = snapshot_memory_open(data, size, &major, &minor, machine_get_name());
+    if (s == NULL) {
+        return -1;
+    }
+
+    return c64_snapshot_read_snapshot(s, major, minor, 0, 1);
+}
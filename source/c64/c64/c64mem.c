@@ -108,6 +108,23 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Pointers to the currently used direct access tables (see mem.h).  */
+uint8_t **_mem_read_direct_tab_ptr;
+uint8_t **_mem_write_direct_tab_ptr;
+
+/* Direct access tables, filled in from the read and write tables the first
+   time a configuration is used.  */
+static uint8_t *mem_read_direct_tab[NUM_CONFIGS][0x101];
+static uint8_t *mem_write_direct_tab[NUM_VBANKS][NUM_CONFIGS][0x101];
+
+/* Generation each direct table was filled in for; bumped whenever the read
+   or write tables change.  */
+static unsigned int mem_direct_generation = 1;
+static unsigned int mem_direct_valid[NUM_VBANKS][NUM_CONFIGS];
+
+/* All NULL, used while watchpoints are active.  */
+static uint8_t *mem_direct_tab_none[0x101];
+
 /* Current video bank (0, 1, 2 or 3).  */
 static int vbank;
 
@@ -151,6 +168,62 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[vbank][mem_config][addr >> 8](addr, value);
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Pages whose read or store function only accesses a plain RAM or ROM array
+   get a direct pointer, everything else (I/O, cartridges, memory expansions,
+   the video bank and zero page handlers) keeps going through the function
+   tables.  */
+static void mem_direct_tab_fill(int bank, int config)
+{
+    int i;
+
+    for (i = 0; i <= 0x100; i++) {
+        read_func_ptr_t rf = mem_read_tab[config][i];
+        store_func_ptr_t sf = mem_write_tab[bank][config][i];
+        uint8_t *p = NULL;
+
+        if (i == 0 || i == 0x100) {
+            rf = NULL;
+            sf = NULL;
+        }
+
+        if (rf == ram_read) {
+            p = mem_ram;
+        } else if (rf == c64memrom_basic64_read) {
+            p = c64memrom_basic64_rom + ((i << 8) & 0x1fff) - (i << 8);
+        } else if (rf == c64memrom_kernal64_read) {
+            p = c64memrom_kernal64_rom + ((i << 8) & 0x1fff) - (i << 8);
+        } else if (rf == chargen_read) {
+            p = mem_chargen_rom + ((i << 8) & 0xfff) - (i << 8);
+        }
+        mem_read_direct_tab[config][i] = p;
+        mem_write_direct_tab[bank][config][i] = (sf == ram_store) ? mem_ram : NULL;
+    }
+    mem_direct_valid[bank][config] = mem_direct_generation;
+}
+
+static void mem_direct_tab_update(void)
+{
+    if (watchpoints_active) {
+        _mem_read_direct_tab_ptr = mem_direct_tab_none;
+        _mem_write_direct_tab_ptr = mem_direct_tab_none;
+        return;
+    }
+
+    if (mem_direct_valid[vbank][mem_config] != mem_direct_generation) {
+        mem_direct_tab_fill(vbank, mem_config);
+    }
+    _mem_read_direct_tab_ptr = mem_read_direct_tab[mem_config];
+    _mem_write_direct_tab_ptr = mem_write_direct_tab[vbank][mem_config];
+}
+
+/* Called whenever the read or write tables are changed.  */
+static void mem_direct_tab_invalidate(void)
+{
+    mem_direct_generation++;
+}
+
 void mem_toggle_watchpoints(int flag, void *context)
 {
     if (flag) {
@@ -161,6 +234,7 @@ void mem_toggle_watchpoints(int flag, void *context)
         _mem_write_tab_ptr = mem_write_tab[vbank][mem_config];
     }
     watchpoints_active = flag;
+    mem_direct_tab_update();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -221,6 +295,7 @@ void mem_pla_config_changed(void)
 
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
     mem_read_limit_tab_ptr = mem_read_limit_tab[mem_config];
+    mem_direct_tab_update();
 
     maincpu_resync_limits();
 }
@@ -652,11 +727,13 @@ void mem_set_write_hook(int config, int page, store_func_t *f)
     for (i = 0; i < NUM_VBANKS; i++) {
         mem_write_tab[i][config][page] = f;
     }
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func)
 {
     mem_read_tab[base][index] = read_func;
+    mem_direct_tab_invalidate();
 }
 
 void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
@@ -783,6 +860,9 @@ void mem_initialize_memory(void)
     if (board == 1) {
         mem_limit_max_init(mem_read_limit_tab);
     }
+
+    mem_direct_tab_invalidate();
+    mem_direct_tab_update();
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -821,6 +901,7 @@ void mem_set_vbank(int new_vbank)
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[new_vbank][mem_config];
     }
+    mem_direct_tab_update();
 
     vicii_set_vbank(new_vbank);
 }
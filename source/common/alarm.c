@@ -54,6 +54,7 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = (CLOCK) ~0L;
+    context->next_pending_alarm = NULL;
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -93,10 +94,17 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
         }
     }
 
-    if (warp_direction > 0) {
-        context->next_pending_alarm_clk += warp_amount;
-    } else {
-        context->next_pending_alarm_clk -= warp_amount;
+    /* Shifting every alarm by the same amount keeps the heap ordered unless
+       some of them wrapped around, so rebuild it to be safe.  This only
+       happens on clock overflow prevention and is cheap.  */
+    for (i = context->num_pending_alarms / 2; i-- > 0;) {
+        alarm_heap_sift_down(context, i);
+    }
+
+    /* the next alarm stays the same one */
+    if (context->next_pending_alarm != NULL) {
+        context->next_pending_alarm_clk
+            = context->pending_alarms[context->next_pending_alarm->pending_idx].clk;
     }
 }
 
@@ -167,6 +175,7 @@ void alarm_destroy(alarm_t *alarm)
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
+    unsigned int last, slot;
     int idx;
 
     idx = alarm->pending_idx;
@@ -176,31 +185,27 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
-    if (context->num_pending_alarms > 1) {
-        int last;
+    slot = context->pending_alarms[idx].slot;
+    last = --context->num_pending_alarms;
 
-        last = --context->num_pending_alarms;
+    if ((unsigned int)idx != last) {
+        /* Fill the hole with the last heap entry and restore the heap
+           property in whichever direction it was violated.  */
+        alarm_heap_put(context, (unsigned int)idx, &context->pending_alarms[last]);
+        alarm_heap_fix(context, (unsigned int)idx);
+    }
 
-        if (last != idx) {
-            /* Let's copy the struct by hand to make sure stupid compilers
-               don't do stupid things.  */
-            context->pending_alarms[idx].alarm
-                = context->pending_alarms[last].alarm;
-            context->pending_alarms[idx].clk
-                = context->pending_alarms[last].clk;
+    if (slot != last) {
+        /* The alarm in the last slot takes over the freed one.  */
+        alarm_t *moved = context->slot_alarms[last];
 
-            context->pending_alarms[idx].alarm->pending_idx = idx;
-        }
+        context->slot_alarms[slot] = moved;
+        context->pending_alarms[moved->pending_idx].slot = slot;
+        alarm_heap_fix(context, (unsigned int)moved->pending_idx);
+    }
 
-        if (context->next_pending_alarm_idx == idx) {
-            alarm_context_update_next_pending(context);
-        } else if (context->next_pending_alarm_idx == last) {
-            context->next_pending_alarm_idx = idx;
-        }
-    } else {
-        context->num_pending_alarms = 0;
-        context->next_pending_alarm_clk = (CLOCK) ~0L;
-        context->next_pending_alarm_idx = -1;
+    if (alarm == context->next_pending_alarm) {
+        alarm_context_update_next_pending(context);
     }
 
     alarm->pending_idx = -1;
@@ -162,6 +162,7 @@ static char *get_drive_type_string(int drive)
 UI_MENU_DEFINE_TOGGLE(DriveTrueEmulation)
 UI_MENU_DEFINE_TOGGLE(DriveLED)
 UI_MENU_DEFINE_TOGGLE(DriveSoundEmulation)
+UI_MENU_DEFINE_TOGGLE(DriveThread)
 UI_MENU_DEFINE_TOGGLE(VirtualDevices)
 
 static UI_MENU_CALLBACK(set_hide_p00_files_callback)
@@ -1286,6 +1287,10 @@ const ui_menu_entry_t drive_menu[] = {
       MENU_ENTRY_RESOURCE_TOGGLE,
       toggle_DriveTrueEmulation_callback,
       NULL },
+    { "Run drives on second core",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_DriveThread_callback,
+      NULL },
     { "Drive sound emulation",
       MENU_ENTRY_RESOURCE_TOGGLE,
       toggle_DriveSoundEmulation_callback,
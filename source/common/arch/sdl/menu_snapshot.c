@@ -36,11 +36,15 @@
 #include "menu_common.h"
 #include "menu_snapshot.h"
 #include "resources.h"
+#include "rewind.h"
+#include "screenshot.h"
 #include "snapshot.h"
 #include "ui.h"
+#include "uiapi.h"
 #include "uifilereq.h"
 #include "uimenu.h"
 #include "util.h"
+#include "videoarch.h"
 #include "vice-event.h"
 #include "archdep_xdg.h"
 #include "vsync.h"
@@ -75,7 +79,26 @@ static void save_snapshot_trap(uint16_t addr, void *data)
     lib_free(filename);
 }
 
+static void start_video_recording_trap(uint16_t addr, void *data)
+{
+    char *filename = (char *)data;
+
+    if (screenshot_save("AVI", filename, sdl_active_canvas) < 0) {
+        ui_error("Cannot record to %s.", filename);
+    }
+    lib_free(filename);
+}
+
+static void stop_video_recording_trap(uint16_t addr, void *data)
+{
+    screenshot_stop_recording();
+}
+
 UI_MENU_DEFINE_RADIO(EventStartMode)
+UI_MENU_DEFINE_TOGGLE(Rewind)
+UI_MENU_DEFINE_SLIDER(RewindInterval, 1, 250)
+UI_MENU_DEFINE_SLIDER(RewindDepth, REWIND_DEPTH_MIN, 3000)
+UI_MENU_DEFINE_INT(RewindBudget)
 
 static UI_MENU_CALLBACK(toggle_save_disk_images_callback)
 {
@@ -157,6 +180,14 @@ static UI_MENU_CALLBACK(quicksave_snapshot_callback)
     return NULL;
 }
 
+static UI_MENU_CALLBACK(rewind_step_back_callback)
+{
+    if (activated) {
+        rewind_step_back();
+    }
+    return NULL;
+}
+
 static UI_MENU_CALLBACK(start_stop_recording_history_callback)
 {
     int recording_new;
@@ -176,6 +207,28 @@ static UI_MENU_CALLBACK(start_stop_recording_history_callback)
     return NULL;
 }
 
+static UI_MENU_CALLBACK(start_stop_video_recording_callback)
+{
+    char *name;
+
+    if (activated) {
+        if (screenshot_is_recording()) {
+            interrupt_maincpu_trigger_trap(stop_video_recording_trap, NULL);
+        } else {
+            name = sdl_ui_file_selection_dialog("Choose AVI file to record to", FILEREQ_MODE_SAVE_FILE);
+            if (name != NULL) {
+                util_add_extension(&name, "avi");
+                interrupt_maincpu_trigger_trap(start_video_recording_trap, name);
+            }
+        }
+    } else {
+        if (screenshot_is_recording()) {
+            return "(recording)";
+        }
+    }
+    return NULL;
+}
+
 static UI_MENU_CALLBACK(start_stop_playback_history_callback)
 {
     int playback_new;
@@ -276,6 +329,27 @@ const ui_menu_entry_t snapshot_menu[] = {
       quicksave_snapshot_callback,
       NULL },
     SDL_MENU_ITEM_SEPARATOR,
+    { "Rewind",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_Rewind_callback,
+      NULL },
+    { "Rewind one step",
+      MENU_ENTRY_OTHER,
+      rewind_step_back_callback,
+      NULL },
+    { "Frames between steps",
+      MENU_ENTRY_RESOURCE_INT,
+      slider_RewindInterval_callback,
+      (ui_callback_data_t)"Enter frames between rewind steps (1-250)" },
+    { "Number of steps",
+      MENU_ENTRY_RESOURCE_INT,
+      slider_RewindDepth_callback,
+      (ui_callback_data_t)"Enter number of rewind steps (1-3000)" },
+    { "Memory budget (KB)",
+      MENU_ENTRY_RESOURCE_INT,
+      int_RewindBudget_callback,
+      (ui_callback_data_t)"Enter rewind memory budget in KB, buffers included" },
+    SDL_MENU_ITEM_SEPARATOR,
     { "Start/stop recording history",
       MENU_ENTRY_OTHER,
       start_stop_recording_history_callback,
@@ -315,6 +389,11 @@ const ui_menu_entry_t snapshot_menu[] = {
       MENU_ENTRY_DIALOG,
       select_history_files_callback,
       NULL },
+    SDL_MENU_ITEM_SEPARATOR,
+    { "Start/stop recording video",
+      MENU_ENTRY_DIALOG,
+      start_stop_video_recording_callback,
+      NULL },
     SDL_MENU_LIST_END
 };
 
@@ -42,6 +42,7 @@
 #include "util.h"
 
 UI_MENU_DEFINE_TOGGLE(Sound)
+UI_MENU_DEFINE_TOGGLE(SoundSidThreads)
 UI_MENU_DEFINE_RADIO(SoundSampleRate)
 UI_MENU_DEFINE_RADIO(SoundFragmentSize)
 UI_MENU_DEFINE_RADIO(SoundSpeedAdjustment)
@@ -206,6 +207,10 @@ static ui_menu_entry_t sound_output_driver_menu[] = {
       MENU_ENTRY_RESOURCE_RADIO,
       radio_SoundDeviceName_callback,
       (ui_callback_data_t)"dummy" },
+    { "Dummy, real-time",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_SoundDeviceName_callback,
+      (ui_callback_data_t)"nulltimed" },
 #if defined(WIN32) && defined(USE_DXSOUND)
     { "DirectX",
       MENU_ENTRY_RESOURCE_RADIO,
@@ -412,6 +417,10 @@ const ui_menu_entry_t sound_output_menu[] = {
       MENU_ENTRY_SUBMENU,
       custom_sidsubmenu_callback,
       (ui_callback_data_t)sid_c64_menu },
+    { "Render SIDs on second core",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_SoundSidThreads_callback,
+      NULL },
 	SDL_MENU_ITEM_SEPARATOR,
     SDL_MENU_ITEM_TITLE("Frequency"),
     { "22050 Hz",
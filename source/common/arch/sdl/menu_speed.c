@@ -33,11 +33,15 @@
 #include "menu_common.h"
 #include "menu_speed.h"
 #include "resources.h"
+#include "uiapi.h"
 #include "uimenu.h"
+#include "vsync.h"
 
 UI_MENU_DEFINE_TOGGLE(WarpMode)
 UI_MENU_DEFINE_RADIO(RefreshRate)
 UI_MENU_DEFINE_RADIO(Speed)
+UI_MENU_DEFINE_RADIO(RunAhead)
+UI_MENU_DEFINE_TOGGLE(AdaptiveFrameskip)
 
 
 static UI_MENU_CALLBACK(custom_RefreshRate_callback)
@@ -67,6 +71,29 @@ static UI_MENU_CALLBACK(custom_RefreshRate_callback)
     return NULL;
 }
 
+static UI_MENU_CALLBACK(frameskip_stats_callback)
+{
+    vsync_frameskip_stats_t stats;
+    char histogram[VSYNC_COST_BUCKETS * 11 + 1];
+    int i, len = 0;
+
+    if (activated) {
+        vsync_get_frameskip_stats(&stats);
+        for (i = 0; i < VSYNC_COST_BUCKETS; i++) {
+            len += sprintf(histogram + len, " %u", stats.histogram[i]);
+        }
+        ui_message("Target %.1f fps, shown %.1f fps.\n"
+                   "Skipped %u of %u frames (%.1f%%).\n"
+                   "Frame takes %.1f ms, %.1f ms skipped.\n"
+                   "Frames by time taken, in quarters of a frame:%s",
+                   stats.target_fps, stats.actual_fps,
+                   stats.skipped, stats.frames,
+                   stats.frames ? stats.skipped * 100.0 / stats.frames : 0.0,
+                   stats.render_ms, stats.skip_ms, histogram);
+    }
+    return NULL;
+}
+
 static UI_MENU_CALLBACK(custom_Speed_callback)
 {
     static char buf[20];
@@ -152,6 +179,14 @@ const ui_menu_entry_t speed_menu[] = {
       MENU_ENTRY_DIALOG,
       custom_RefreshRate_callback,
       NULL },
+    { "Adaptive frameskip",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_AdaptiveFrameskip_callback,
+      NULL },
+    { "Frameskip statistics",
+      MENU_ENTRY_DIALOG,
+      frameskip_stats_callback,
+      NULL },
     SDL_MENU_ITEM_SEPARATOR,
     SDL_MENU_ITEM_TITLE("Maximum speed"),
     { "10%",
@@ -182,6 +217,28 @@ const ui_menu_entry_t speed_menu[] = {
       MENU_ENTRY_DIALOG,
       custom_Speed_callback,
       NULL },
+    SDL_MENU_ITEM_SEPARATOR,
+    SDL_MENU_ITEM_TITLE("Run-ahead"),
+    { "Off",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_RunAhead_callback,
+      (ui_callback_data_t)0 },
+    { "1 frame",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_RunAhead_callback,
+      (ui_callback_data_t)1 },
+    { "2 frames",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_RunAhead_callback,
+      (ui_callback_data_t)2 },
+    { "3 frames",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_RunAhead_callback,
+      (ui_callback_data_t)3 },
+    { "4 frames",
+      MENU_ENTRY_RESOURCE_RADIO,
+      radio_RunAhead_callback,
+      (ui_callback_data_t)4 },
     SDL_MENU_LIST_END
 };
 
@@ -34,10 +34,12 @@
 #include "menu_common.h"
 #include "menu_video.h"
 #include "palette.h"
+#include "raster-cache.h"
 #include "resources.h"
 #include "ted.h"
 #include "ui.h"
 #include "uibottom.h"
+#include "uiapi.h"
 #include "uifilereq.h"
 #include "uimenu.h"
 #include "vic.h"
@@ -629,6 +631,7 @@ UI_MENU_DEFINE_TOGGLE(VDCVideoCache)
 UI_MENU_DEFINE_TOGGLE(CrtcVideoCache)
 UI_MENU_DEFINE_TOGGLE(TEDVideoCache)
 UI_MENU_DEFINE_TOGGLE(VICVideoCache)
+UI_MENU_DEFINE_TOGGLE(VideoThread)
 UI_MENU_DEFINE_TOGGLE(VICIIExternalPalette)
 UI_MENU_DEFINE_TOGGLE(VDCExternalPalette)
 UI_MENU_DEFINE_TOGGLE(CrtcExternalPalette)
@@ -638,6 +641,30 @@ UI_MENU_DEFINE_RADIO(MachineVideoStandard)
 UI_MENU_DEFINE_TOGGLE(VICIICheckSsColl)
 UI_MENU_DEFINE_TOGGLE(VICIICheckSbColl)
 
+static UI_MENU_CALLBACK(video_cache_stats_callback)
+{
+    raster_cache_stats_t stats;
+    unsigned long hits = 0, partial = 0, misses = 0, lines;
+    int i;
+
+    if (activated) {
+        raster_cache_get_stats(&stats);
+        for (i = 0; i < RASTER_CACHE_STATS_MODES; i++) {
+            hits += stats.hits[i];
+            partial += stats.partial[i];
+            misses += stats.misses[i];
+        }
+        lines = hits + partial + misses;
+        ui_message("%lu lines with the cache.\n"
+                   "Unchanged %.1f%%, partly drawn %.1f%%.\n"
+                   "%lu lines without the cache.",
+                   lines, lines ? hits * 100.0 / lines : 0.0,
+                   lines ? partial * 100.0 / lines : 0.0, stats.uncached);
+        raster_cache_reset_stats();
+    }
+    return NULL;
+}
+
 /*
 static UI_MENU_CALLBACK(restore_size_callback)
 {
@@ -695,6 +722,11 @@ const ui_menu_entry_t c128_video_menu[] = {
       restore_size_callback,
       NULL },*/
     SDL_MENU_ITEM_SEPARATOR,
+    { "Render on second core",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_VideoThread_callback,
+      NULL },
+    SDL_MENU_ITEM_SEPARATOR,
     { "VICII Video cache",
       MENU_ENTRY_RESOURCE_TOGGLE,
       toggle_VICIIVideoCache_callback,
@@ -846,6 +878,14 @@ const ui_menu_entry_t c64_video_menu[] = {
       MENU_ENTRY_RESOURCE_TOGGLE,
       toggle_VICIIVideoCache_callback,
       NULL },
+    { "Video cache statistics",
+      MENU_ENTRY_DIALOG,
+      video_cache_stats_callback,
+      NULL },
+    { "Render on second core",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_VideoThread_callback,
+      NULL },
     SDL_MENU_ITEM_SEPARATOR,
     { "VICII border mode",
       MENU_ENTRY_SUBMENU,
@@ -898,6 +938,11 @@ const ui_menu_entry_t c64sc_video_menu[] = {
       restore_size_callback,
       NULL },*/
     SDL_MENU_ITEM_SEPARATOR,
+    { "Render on second core",
+      MENU_ENTRY_RESOURCE_TOGGLE,
+      toggle_VideoThread_callback,
+      NULL },
+    SDL_MENU_ITEM_SEPARATOR,
     { "VICII border mode",
       MENU_ENTRY_SUBMENU,
       submenu_radio_callback,
@@ -38,6 +38,7 @@
 #include "uimenu.h"
 #include "vsync.h"
 #include "uibottom.h"
+#include "video-thread.h"
 #include "videoarch.h"
 
 
@@ -48,6 +49,7 @@ int is_paused = 0;
 
 static void pause_trap(uint16_t addr, void *data)
 {
+    video_thread_sync();
     vsync_suspend_speed_eval();
     while (is_paused) {
         SDL_Delay(20);
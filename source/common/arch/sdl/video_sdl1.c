@@ -39,6 +39,7 @@
 #include "vice_sdl.h"
 
 #include "archdep.h"
+#include "bench.h"
 //#include "cmdline.h"
 #include "fullscreen.h"
 #include "fullscreenarch.h"
@@ -56,6 +57,7 @@
 #include "uimenu.h"
 #include "uistatusbar.h"
 #include "util.h"
+#include "video-thread.h"
 #include "videoarch.h"
 #include "vsidui_sdl.h"
 #include "vsync.h"
@@ -71,6 +73,7 @@
 static log_t sdlvideo_log = LOG_ERR;
 
 static int sdl_bitdepth;
+static int sdl_paletted;
 static int fullscreen_stretch;
 
 static int sdl_limit_mode;
@@ -155,6 +158,13 @@ static int set_sdl_bitdepth(int d, void *param)
     return 0;
 }
 
+static int set_sdl_paletted(int val, void *param)
+{
+    sdl_paletted = val ? 1 : 0;
+    /* the canvas is re-created on the next refresh */
+    return 0;
+}
+
 static int set_sdl_limit_mode(int v, void *param)
 {
     switch (v) {
@@ -364,6 +374,8 @@ static const resource_string_t resources_string[] = {
 static resource_int_t resources_int[] = {
     { "SDLBitdepth", VICE_DEFAULT_BITDEPTH, RES_EVENT_NO, NULL,
       &sdl_bitdepth, set_sdl_bitdepth, NULL },
+    { "SDLPaletted", 0, RES_EVENT_NO, NULL,
+      &sdl_paletted, set_sdl_paletted, NULL },
     { "SDLLimitMode", SDLLIMITMODE_DEFAULT, RES_EVENT_NO, NULL,
       &sdl_limit_mode, set_sdl_limit_mode, NULL },
     { "SDLCustomWidth", SDLCUSTOMWIDTH_DEFAULT, RES_EVENT_NO, NULL,
@@ -499,6 +511,8 @@ void video_shutdown(void)
 {
     DBG(("%s", __func__));
 
+    video_thread_shutdown();
+
     if (draw_buffer_vsid) {
         lib_free(draw_buffer_vsid);
     }
@@ -573,6 +587,20 @@ static void sdl_gl_set_viewport(unsigned int src_w, unsigned int src_h, unsigned
 }
 #endif
 
+/* With "SDLPaletted" the screen is an 8 bit surface: the draw buffer is
+   copied to it as it is and SDL looks the colours up in the palette given
+   with SDL_SetColors().  The CRT emulation blends neighbouring colours, so
+   it needs a true colour screen and gets one; scale2x and the double size
+   modes only copy pixels and work the same on both.  It has no menu entry
+   as it has yet to beat true colour on the 3DS (BenchMicro=paletted
+   measures both); it can be set in vicerc to try.  */
+static int sdl_canvas_paletted(video_canvas_t *canvas)
+{
+    return sdl_paletted
+           && !canvas->videoconfig->hwscale
+           && canvas->videoconfig->filter != VIDEO_FILTER_CRT;
+}
+
 static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *width, unsigned int *height)
 {
 	SDL_Surface *new_screen;
@@ -585,6 +613,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
     unsigned int limit_h = (unsigned int)sdl_custom_height;
     int hwscale = 0;
     int lightpen_updated = 0;
+    int depth;
 #ifdef HAVE_HWSCALE
     int rbits = 0, gbits = 0, bbits = 0;
     const Uint32
@@ -598,6 +627,11 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
 
     DBG(("%s: %i,%i (%i)", __func__, *width, *height, canvas->index));
 
+    /* the video thread may still be drawing on the old screen */
+    video_thread_sync();
+
+    canvas->paletted = sdl_canvas_paletted(canvas);
+
     flags = SDL_SWSURFACE;
 
     new_width = *width;
@@ -695,6 +729,8 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
     }
 #endif
 
+    depth = canvas->paletted ? 8 : sdl_bitdepth;
+
     actual_width = new_width;
     actual_height = new_height;
 
@@ -728,7 +764,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
         SDL_EventState(SDL_VIDEORESIZE, SDL_IGNORE);
 #endif
 #ifndef HAVE_HWSCALE
-        new_screen = SDL_SetVideoMode(actual_width, actual_height, sdl_bitdepth, flags);
+        new_screen = SDL_SetVideoMode(actual_width, actual_height, depth, flags);
         new_width = new_screen->w;
         new_height = new_screen->h;
 #else
@@ -739,7 +775,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
             if ((fullscreen) && (canvas->fullscreenconfig->mode == FULLSCREEN_MODE_CUSTOM)) {
                 new_screen = SDL_SetVideoMode(limit_w, limit_h, sdl_bitdepth, flags);
             } else {
-                new_screen = SDL_SetVideoMode(actual_width, actual_height, sdl_bitdepth, flags);
+                new_screen = SDL_SetVideoMode(actual_width, actual_height, depth, flags);
             }
             if (!new_screen) { /* Did not work out quite well. Let's try without hwscale */
                 resources_set_int("HwScalePossible", 0);
@@ -760,7 +796,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
             sdl_gl_set_viewport(new_width, new_height, actual_width, actual_height);
             lightpen_updated = 1;
         } else {
-		new_screen = SDL_SetVideoMode(actual_width, actual_height, sdl_bitdepth, flags);
+		new_screen = SDL_SetVideoMode(actual_width, actual_height, depth, flags);
         new_width = new_screen->w;
         new_height = new_screen->h;
 
@@ -794,7 +830,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
             SDL_FreeSurface(canvas->screen);
 			canvas->screen=NULL;
         }
-        new_screen = SDL_CreateRGBSurface(SDL_SWSURFACE, new_width, new_height, sdl_bitdepth, 0, 0, 0, 0);
+        new_screen = SDL_CreateRGBSurface(SDL_SWSURFACE, new_width, new_height, depth, 0, 0, 0, 0);
     }
 
     if (!new_screen) {
@@ -802,14 +838,17 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
 
 		return NULL;
     }
-    sdl_bitdepth = new_screen->format->BitsPerPixel;
+    canvas->depth = new_screen->format->BitsPerPixel;
+    if (!canvas->paletted) {
+        sdl_bitdepth = canvas->depth;
+    }
 
-    canvas->depth = sdl_bitdepth;
     canvas->width = new_width;
     canvas->height = new_height;
     canvas->screen = new_screen;
     canvas->actual_width = actual_width;
     canvas->actual_height = actual_height;
+    video_canvas_dirty_reset(canvas);
 
     if (canvas == sdl_active_canvas) {
         if (!fullscreen) {
@@ -818,7 +857,7 @@ static video_canvas_t *sdl_canvas_create(video_canvas_t *canvas, unsigned int *w
         }
     }
 
-    log_message(sdlvideo_log, "%s (%s) %ix%i %ibpp %s%s", canvas->videoconfig->chip_name, (canvas == sdl_active_canvas) ? "active" : "inactive", actual_width, actual_height, sdl_bitdepth, hwscale ? "OpenGL " : "", (canvas->fullscreenconfig->enable) ? "(fullscreen)" : "");
+    log_message(sdlvideo_log, "%s (%s) %ix%i %ibpp %s%s", canvas->videoconfig->chip_name, (canvas == sdl_active_canvas) ? "active" : "inactive", actual_width, actual_height, canvas->depth, hwscale ? "OpenGL " : "", (canvas->fullscreenconfig->enable) ? "(fullscreen)" : "");
 #ifdef SDL_DEBUG
     log_message(sdlvideo_log, "Canvas %ix%i, real %ix%i", new_width, new_height, canvas->real_width, canvas->real_height);
 #endif
@@ -861,6 +900,28 @@ void video_canvas_refresh(struct video_canvas_s *canvas, unsigned int xs, unsign
         uistatusbar_draw();
     }
 
+    /* "SDLPaletted" or the filter has changed */
+    if (canvas->paletted != sdl_canvas_paletted(canvas)) {
+        video_viewport_resize(canvas, 0);
+        return;
+    }
+
+    if (video_thread_refresh(canvas, xs, ys, xi, yi, w, h)) {
+        return;
+    }
+
+    BENCH_ENTER(BENCH_VIDEO);
+    video_canvas_present(canvas, canvas->draw_buffer->draw_buffer, xs, ys, xi, yi, w, h);
+    BENCH_LEAVE(BENCH_VIDEO);
+}
+
+/* Also called on the video thread, see video-thread.c.  */
+void video_canvas_present(struct video_canvas_s *canvas, uint8_t *src, unsigned int xs, unsigned int ys, unsigned int xi, unsigned int yi, unsigned int w, unsigned int h)
+{
+    video_canvas_run_t runs[VIDEO_CANVAS_MAX_RUNS];
+    SDL_Rect rects[VIDEO_CANVAS_MAX_RUNS];
+    int nruns, i;
+
     xi *= canvas->videoconfig->scalex;
     w *= canvas->videoconfig->scalex;
 
@@ -884,12 +945,22 @@ void video_canvas_refresh(struct video_canvas_s *canvas, unsigned int xs, unsign
         canvas->videoconfig->readable = !(canvas->screen->flags & SDL_HWSURFACE);
     }
 
-    video_canvas_render(canvas, (uint8_t *)canvas->screen->pixels, w, h, xs, ys, xi, yi, canvas->screen->pitch, canvas->screen->format->BitsPerPixel);
+    nruns = video_canvas_render(canvas, src, (uint8_t *)canvas->screen->pixels, w, h, xs, ys, xi, yi, canvas->screen->pitch, canvas->screen->format->BitsPerPixel, runs);
 
     if (SDL_MUSTLOCK(canvas->screen)) {
         SDL_UnlockSurface(canvas->screen);
     }
 
+#ifdef VICE_BENCH
+    /* null canvas: the frame is converted but never presented */
+    return;
+#endif
+
+    /* nothing changed, what is shown is still right */
+    if (nruns == 0) {
+        return;
+    }
+
 #if defined(HAVE_HWSCALE)
     if (canvas->videoconfig->hwscale) {
         const float *v = &(sdl_gl_vertex_coord[sdl_gl_vertex_base]);
@@ -959,7 +1030,13 @@ start_profiling(pc);
 stop_profiling(pc);
 */
 
-	SDL_UpdateRect(canvas->screen, xi, yi, w, h);
+    for (i = 0; i < nruns; i++) {
+        rects[i].x = xi;
+        rects[i].y = runs[i].yt;
+        rects[i].w = w;
+        rects[i].h = runs[i].height;
+    }
+    SDL_UpdateRects(canvas->screen, nruns, rects);
 }
 
 int video_canvas_set_palette(struct video_canvas_s *canvas, struct palette_s *palette)
@@ -1140,11 +1217,16 @@ void sdl_video_canvas_switch(int index)
         sdl_canvaslist[index]->screen = NULL;
     }
 */
+    video_thread_sync();
+
     sdl_active_canvas_num = index;
 
     canvas = sdl_canvaslist[sdl_active_canvas_num];
     sdl_active_canvas = canvas;
 
+    /* the screen holds what the other canvas rendered */
+    video_canvas_dirty_reset(canvas);
+
     video_viewport_resize(canvas, 1);
 }
 
@@ -1170,6 +1252,7 @@ void video_arch_canvas_init(struct video_canvas_s *canvas)
     sdl_canvaslist[sdl_num_screens++] = canvas;
 
     canvas->screen = NULL;
+    canvas->paletted = 0;
 #if defined(HAVE_HWSCALE)
     canvas->hwscale_screen = NULL;
 #endif
@@ -1183,6 +1266,8 @@ void video_canvas_destroy(struct video_canvas_s *canvas)
 
     DBG(("%s: (%p, %i)", __func__, canvas, canvas->index));
 
+    video_thread_sync();
+
     for (i = 0; i < sdl_num_screens; ++i) {
         if ((sdl_canvaslist[i] == canvas) && (canvas == sdl_active_canvas)) {
             SDL_FreeSurface(sdl_canvaslist[i]->screen);
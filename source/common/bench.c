@@ -0,0 +1,818 @@
+/*
+ * bench.c - Headless throughput benchmark
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The bench build (`make bench`) runs the normal machine with the dummy
+   sound device, no presentation and no speed limit for a fixed number of
+   frames, then reports emulated cycles per host second, frames per second
+   and how the host time was split between the emulated subsystems.
+
+   The image to run is taken from the usual autostart sources (the
+   "AutostartImage" resource or an autostart.* file), so PRG, D64 and
+   snapshot files all work.  The subsystems that keep statistics of their
+   own are reported after the totals when they were in use, and the final
+   machine state is printed last.
+
+   If "BenchMicro" names one of the micro-benchmarks (or is "all"), those
+   run instead of the machine and the program exits. */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _3DS
+#include <3ds.h>
+#else
+#include <time.h>
+#endif
+
+#include "bench.h"
+#include "types.h"
+
+uint64_t bench_ticks(void)
+{
+#ifdef _3DS
+    return svcGetSystemTick();
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+uint64_t bench_ticks_per_second(void)
+{
+#ifdef _3DS
+    return SYSCLOCK_ARM11;
+#else
+    return 1000000000;
+#endif
+}
+
+#ifdef VICE_BENCH
+
+#include "alarm.h"
+#include "archdep.h"
+#include "clkguard.h"
+#include "crc32.h"
+#include "drive-thread.h"
+#include "drive.h"
+#include "drivetypes.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "mem.h"
+#include "raster-cache.h"
+#include "render1x1.h"
+#include "render1x1pal.h"
+#include "resid.h"
+#include "resources.h"
+#include "rewind.h"
+#include "runahead.h"
+#include "sound-ring.h"
+#include "sound-thread.h"
+#include "sound.h"
+#include "util.h"
+#include "video-render.h"
+#include "video-thread.h"
+#include "video.h"
+#include "vsync.h"
+
+/* nesting depth of bench_enter() calls we keep track of */
+#define BENCH_STACK_MAX 8
+
+static const char * const subsystem_names[BENCH_NUM_SUBSYSTEMS] = {
+    "cpu", "drive", "sound", "video", "sync"
+};
+
+static int bench_frames;
+
+static int set_bench_frames(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+    bench_frames = val;
+    return 0;
+}
+
+static char *bench_micro = NULL;
+
+static int set_bench_micro(const char *val, void *param)
+{
+    util_string_set(&bench_micro, val);
+    return 0;
+}
+
+static const resource_string_t resources_string[] = {
+    { "BenchMicro", "", RES_EVENT_NO, NULL,
+      &bench_micro, set_bench_micro, NULL },
+    RESOURCE_STRING_LIST_END
+};
+
+static const resource_int_t resources_int[] = {
+    { "BenchFrames", 3000, RES_EVENT_NO, NULL,
+      &bench_frames, set_bench_frames, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int bench_resources_init(void)
+{
+    if (resources_register_string(resources_string) < 0) {
+        return -1;
+    }
+    return resources_register_int(resources_int);
+}
+
+void bench_resources_shutdown(void)
+{
+    lib_free(bench_micro);
+    bench_micro = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static log_t bench_log = LOG_ERR;
+
+static int frame_count = -1;
+static CLOCK start_clk;
+static uint64_t start_tick;
+
+static uint64_t subsystem_ticks[BENCH_NUM_SUBSYSTEMS];
+static int stack[BENCH_STACK_MAX];
+static int stack_depth;
+static uint64_t last_tick;
+
+static void clk_overflow_callback(CLOCK amount, void *data)
+{
+    start_clk -= amount;
+}
+
+void bench_init(void)
+{
+    bench_log = log_open("Bench");
+    clk_guard_add_callback(maincpu_clk_guard, clk_overflow_callback, NULL);
+}
+
+/* Charge the time since the last switch to whatever is on top of the
+   stack, so every subsystem only sees its exclusive share. */
+static void bench_switch(uint64_t now)
+{
+    int depth = stack_depth < BENCH_STACK_MAX ? stack_depth : BENCH_STACK_MAX;
+    int current = depth ? stack[depth - 1] : BENCH_CPU;
+
+    subsystem_ticks[current] += now - last_tick;
+    last_tick = now;
+}
+
+void bench_enter(int subsystem)
+{
+    bench_switch(bench_ticks());
+    if (stack_depth < BENCH_STACK_MAX) {
+        stack[stack_depth] = subsystem;
+    }
+    stack_depth++;
+}
+
+void bench_leave(int subsystem)
+{
+    bench_switch(bench_ticks());
+    if (stack_depth > 0) {
+        stack_depth--;
+    }
+}
+
+static void bench_report(void)
+{
+    uint64_t now = bench_ticks();
+    uint32_t state_crc = crc32_buf((const char *)mem_ram, 0x10000);
+    rewind_stats_t rewind;
+    runahead_stats_t runahead;
+    drive_thread_stats_t drive_thread;
+    sound_thread_stats_t sound_thread;
+    sound_ring_stats_t sound_ring;
+    video_canvas_dirty_stats_t dirty;
+    video_thread_stats_t video_thread;
+    vsync_frameskip_stats_t frameskip;
+    raster_cache_stats_t cache;
+    double secs, cycles, total;
+    int i;
+
+    bench_switch(now);
+
+    /* the last frame may still be on the video thread */
+    video_thread_sync();
+
+    secs = (double)(now - start_tick) / bench_ticks_per_second();
+    cycles = (double)(CLOCK)(maincpu_clk - start_clk);
+    total = 0.0;
+    for (i = 0; i < BENCH_NUM_SUBSYSTEMS; i++) {
+        total += (double)subsystem_ticks[i];
+    }
+    if (secs <= 0.0) {
+        secs = 1e-9;
+    }
+    if (total <= 0.0) {
+        total = 1.0;
+    }
+
+    log_message(bench_log, "%s: %d frames in %.3f s", machine_get_name(), frame_count, secs);
+    log_message(bench_log, "cycles/sec: %.0f (%.1f%% of real time)",
+                cycles / secs, 100.0 * cycles / secs / machine_get_cycles_per_second());
+    log_message(bench_log, "frames/sec: %.2f", frame_count / secs);
+    for (i = 0; i < BENCH_NUM_SUBSYSTEMS; i++) {
+        log_message(bench_log, "  %-6s %6.2f%%", subsystem_names[i], 100.0 * subsystem_ticks[i] / total);
+    }
+
+    printf("BENCH %s frames=%d secs=%.3f cycles_per_sec=%.0f fps=%.2f",
+           machine_get_name(), frame_count, secs, cycles / secs, frame_count / secs);
+    for (i = 0; i < BENCH_NUM_SUBSYSTEMS; i++) {
+        printf(" %s=%.2f", subsystem_names[i], 100.0 * subsystem_ticks[i] / total);
+    }
+    printf("\n");
+
+    /* rewind capture cost, when "Rewind" is enabled for the run */
+    rewind_get_stats(&rewind);
+    if (rewind.captures > 0) {
+        double capture_us = (double)rewind.capture_ticks * 1e6 / bench_ticks_per_second();
+
+        log_message(bench_log, "rewind: %u captures, %.1f us/capture, %.1f us/frame, %.0f bytes/step (%.1f%% of %.0f), %u steps in %u KB",
+                    rewind.captures, capture_us / rewind.captures, capture_us / frame_count,
+                    (double)rewind.stored_bytes / rewind.captures,
+                    100.0 * rewind.stored_bytes / rewind.raw_bytes,
+                    (double)rewind.raw_bytes / rewind.captures,
+                    rewind.steps, (unsigned int)(rewind.bytes / 1024));
+        printf("BENCH rewind captures=%u us_per_capture=%.1f us_per_frame=%.1f bytes_per_step=%.0f raw_bytes_per_step=%.0f\n",
+               rewind.captures, capture_us / rewind.captures, capture_us / frame_count,
+               (double)rewind.stored_bytes / rewind.captures,
+               (double)rewind.raw_bytes / rewind.captures);
+    }
+
+    /* run-ahead cost per shown frame, when "RunAhead" is set for the run */
+    runahead_get_stats(&runahead);
+    if (runahead.frames > 0) {
+        double ahead_us = (double)runahead.ticks * 1e6 / bench_ticks_per_second();
+        double state_us = (double)runahead.state_ticks * 1e6 / bench_ticks_per_second();
+        double max_us = (double)runahead.max_ticks * 1e6 / bench_ticks_per_second();
+        double budget_us = 1e6 * machine_get_cycles_per_frame() / machine_get_cycles_per_second();
+
+        log_message(bench_log, "run-ahead: %u frames, %.1f us/frame (%.1f us save+restore, max %.1f us), %.1f%% of the frame time",
+                    runahead.frames, ahead_us / runahead.frames, state_us / runahead.frames,
+                    max_us, 100.0 * ahead_us / runahead.frames / budget_us);
+        printf("BENCH runahead frames=%u us_per_frame=%.1f state_us_per_frame=%.1f max_us=%.1f frame_budget_pct=%.1f\n",
+               runahead.frames, ahead_us / runahead.frames, state_us / runahead.frames,
+               max_us, 100.0 * ahead_us / runahead.frames / budget_us);
+    }
+
+    /* main CPU waits for the drive thread, when "DriveThread" is used */
+    drive_thread_get_stats(&drive_thread);
+    if (drive_thread.slices > 0) {
+        double wait_us = (double)drive_thread.wait_ticks * 1e6 / bench_ticks_per_second();
+
+        log_message(bench_log, "drive thread: %u slices, %u busy, %u waits, %.1f us waiting/frame",
+                    drive_thread.slices, drive_thread.busy, drive_thread.waits, wait_us / frame_count);
+        printf("BENCH drivethread slices=%u busy=%u waits=%u wait_us_per_frame=%.1f\n",
+               drive_thread.slices, drive_thread.busy, drive_thread.waits, wait_us / frame_count);
+    }
+
+    /* fill of the sound ring, when the sound device pulls */
+    sound_ring_get_stats(&sound_ring);
+    if (sound_ring.pulls > 0) {
+        double ms = 1000.0 / sound_ring.rate;
+
+        log_message(bench_log, "sound ring: %u pulls, %u underruns (%u frames), %u frames dropped, fill %.1f/%.1f/%.1f ms, target %.1f ms",
+                    sound_ring.pulls, sound_ring.underruns, sound_ring.underrun_frames, sound_ring.overrun_frames,
+                    sound_ring.fill_min * ms, (double)sound_ring.fill_sum / sound_ring.pulls * ms,
+                    sound_ring.fill_max * ms, sound_ring.target * ms);
+        printf("BENCH soundring pulls=%u underruns=%u underrun_frames=%u dropped_frames=%u fill_min_ms=%.1f fill_avg_ms=%.1f fill_max_ms=%.1f target_ms=%.1f\n",
+               sound_ring.pulls, sound_ring.underruns, sound_ring.underrun_frames, sound_ring.overrun_frames,
+               sound_ring.fill_min * ms, (double)sound_ring.fill_sum / sound_ring.pulls * ms,
+               sound_ring.fill_max * ms, sound_ring.target * ms);
+    }
+
+    /* SIDs rendered in parallel, when "SoundSidThreads" is used */
+    sound_thread_get_stats(&sound_thread);
+    if (sound_thread.runs > 0) {
+        double wait_us = (double)sound_thread.wait_ticks * 1e6 / bench_ticks_per_second();
+
+        log_message(bench_log, "sound thread: %u runs, %u jobs (%u on the workers), %u waits, %.1f us waiting/frame",
+                    sound_thread.runs, sound_thread.jobs, sound_thread.thread_jobs,
+                    sound_thread.waits, wait_us / frame_count);
+        printf("BENCH soundthread runs=%u jobs=%u thread_jobs=%u waits=%u wait_us_per_frame=%.1f\n",
+               sound_thread.runs, sound_thread.jobs, sound_thread.thread_jobs,
+               sound_thread.waits, wait_us / frame_count);
+    }
+
+    /* lines that were not rendered again because they hadn't changed */
+    video_canvas_get_dirty_stats(&dirty);
+    if (dirty.lines > 0) {
+        double skipped = 100.0 * dirty.lines_skipped / dirty.lines;
+
+        log_message(bench_log, "dirty lines: %.1f%% of lines skipped, %u of %u frames unchanged",
+                    skipped, dirty.frames_clean, dirty.frames);
+        printf("BENCH dirtylines frames=%u clean_frames=%u lines=%lu skipped=%lu skipped_percent=%.1f\n",
+               dirty.frames, dirty.frames_clean, dirty.lines, dirty.lines_skipped, skipped);
+    }
+
+    /* how the raster cache did by video mode, when "VICIIVideoCache" is on;
+       a text mode, a bitmap and a sprite heavy program show how well the
+       cache does on each */
+    raster_cache_get_stats(&cache);
+    for (i = 0; i < RASTER_CACHE_STATS_MODES; i++) {
+        unsigned long lines = cache.hits[i] + cache.partial[i] + cache.misses[i];
+
+        if (lines == 0) {
+            continue;
+        }
+        log_message(bench_log, "raster cache: mode %d, %lu lines, %.1f%% unchanged, %.1f%% partly drawn",
+                    i, lines, 100.0 * cache.hits[i] / lines, 100.0 * cache.partial[i] / lines);
+        printf("BENCH rastercache mode=%d lines=%lu hits=%lu partial=%lu misses=%lu hit_percent=%.1f\n",
+               i, lines, cache.hits[i], cache.partial[i], cache.misses[i],
+               100.0 * cache.hits[i] / lines);
+    }
+    if (cache.partial_pixels > 0 || cache.uncached > 0) {
+        printf("BENCH rastercache partial_pixels=%lu uncached=%lu\n",
+               cache.partial_pixels, cache.uncached);
+    }
+
+    /* frame pacing, when "VideoThread" is used */
+    video_thread_get_stats(&video_thread);
+    if (video_thread.frames > 0) {
+        double tps = (double)bench_ticks_per_second();
+
+        log_message(bench_log, "video thread: %u frames, %u shown, %.2f ms render avg, %.2f ms max, %u waits, %.2f ms waiting/frame, %.2f-%.2f ms between frames",
+                    video_thread.frames, video_thread.presented,
+                    video_thread.render_ticks * 1e3 / tps / video_thread.frames,
+                    video_thread.max_render_ticks * 1e3 / tps,
+                    video_thread.waits, video_thread.wait_ticks * 1e3 / tps / frame_count,
+                    video_thread.min_interval_ticks * 1e3 / tps,
+                    video_thread.max_interval_ticks * 1e3 / tps);
+        printf("BENCH videothread frames=%u presented=%u dropped=%u render_ms_avg=%.3f render_ms_max=%.3f waits=%u wait_ms_per_frame=%.3f interval_ms_min=%.3f interval_ms_max=%.3f\n",
+               video_thread.frames, video_thread.presented,
+               video_thread.frames - video_thread.presented,
+               video_thread.render_ticks * 1e3 / tps / video_thread.frames,
+               video_thread.max_render_ticks * 1e3 / tps,
+               video_thread.waits, video_thread.wait_ticks * 1e3 / tps / frame_count,
+               video_thread.min_interval_ticks * 1e3 / tps,
+               video_thread.max_interval_ticks * 1e3 / tps);
+    }
+
+    /* host time per frame, as "AdaptiveFrameskip" measures it, as a
+       histogram in quarters of the frame time */
+    vsync_get_frameskip_stats(&frameskip);
+    if (frameskip.frames > 0) {
+        log_message(bench_log, "frame cost: %.2f ms predicted, in quarters of the frame time:",
+                    frameskip.render_ms);
+        printf("BENCH framecost frames=%u predicted_ms=%.3f target_fps=%.2f histogram=",
+               frameskip.frames, frameskip.render_ms, frameskip.target_fps);
+        for (i = 0; i < VSYNC_COST_BUCKETS; i++) {
+            log_message(bench_log, "  %s%d/4: %u", (i == VSYNC_COST_BUCKETS - 1) ? ">=" : "<",
+                        (i == VSYNC_COST_BUCKETS - 1) ? i : i + 1, frameskip.histogram[i]);
+            printf("%s%u", i ? "," : "", frameskip.histogram[i]);
+        }
+        printf("\n");
+    }
+
+    /* final machine state, to check that build variants emulate alike,
+       e.g. loading a D64 with "DriveThread" on and off must end the same */
+    log_message(bench_log, "state: clk=%u pc=%04x a=%02x x=%02x y=%02x sp=%02x ram=%08x",
+                (unsigned int)maincpu_clk, maincpu_get_pc(), maincpu_get_a(),
+                maincpu_get_x(), maincpu_get_y(), maincpu_get_sp(), state_crc);
+    printf("BENCH state clk=%u pc=%04x a=%02x x=%02x y=%02x sp=%02x ram=%08x\n",
+           (unsigned int)maincpu_clk, maincpu_get_pc(), maincpu_get_a(),
+           maincpu_get_x(), maincpu_get_y(), maincpu_get_sp(), state_crc);
+
+    /* bring the drives up to date first, they may lag behind by a different
+       amount depending on where they were last synchronized */
+    drive_cpu_execute_all(maincpu_clk);
+    for (i = 0; i < DRIVE_NUM; i++) {
+        drive_context_t *drv = drive_context[i];
+        uint32_t drive_crc;
+
+        if (!drv->drive->enable) {
+            continue;
+        }
+        drive_crc = crc32_buf((const char *)drv->drive->drive_ram, DRIVE_RAM_SIZE);
+        log_message(bench_log, "drive %d: clk=%u pc=%04x ram=%08x",
+                    i + 8, (unsigned int)*(drv->clk_ptr), drv->cpu->cpu_regs.pc, drive_crc);
+        printf("BENCH drive unit=%d clk=%u pc=%04x ram=%08x\n",
+               i + 8, (unsigned int)*(drv->clk_ptr), drv->cpu->cpu_regs.pc, drive_crc);
+    }
+    fflush(stdout);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Micro-benchmarks */
+
+static double bench_elapsed_ns(uint64_t start)
+{
+    return (double)(bench_ticks() - start) * 1e9 / bench_ticks_per_second();
+}
+
+#define BENCH_ALARM_DISPATCHES 2000000
+
+static alarm_context_t *bench_alarm_context;
+static CLOCK bench_alarm_clk;
+static uint32_t bench_alarm_seed;
+
+static void bench_alarm_callback(CLOCK offset, void *data)
+{
+    /* reschedule with a pseudo-random period, like the chips do */
+    bench_alarm_seed = bench_alarm_seed * 1103515245 + 12345;
+    alarm_set((alarm_t *)data, bench_alarm_clk + 1 + ((bench_alarm_seed >> 16) & 0x3ff));
+}
+
+static void bench_alarm(void)
+{
+    static const unsigned int sizes[] = { 8, 32, 128 };
+    alarm_t *alarms[128];
+    unsigned int s, i;
+
+    for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint64_t start;
+
+        bench_alarm_context = alarm_context_new("Bench");
+        bench_alarm_clk = 0;
+        bench_alarm_seed = 1;
+        for (i = 0; i < sizes[s]; i++) {
+            alarms[i] = alarm_new(bench_alarm_context, "BenchAlarm", bench_alarm_callback, NULL);
+            alarms[i]->data = alarms[i];
+            bench_alarm_callback(0, alarms[i]);
+        }
+
+        start = bench_ticks();
+        for (i = 0; i < BENCH_ALARM_DISPATCHES; i++) {
+            bench_alarm_clk = alarm_context_next_pending_clk(bench_alarm_context);
+            alarm_context_dispatch(bench_alarm_context, bench_alarm_clk);
+        }
+        log_message(bench_log, "alarm: %3u pending: %.1f ns/dispatch",
+                    sizes[s], bench_elapsed_ns(start) / BENCH_ALARM_DISPATCHES);
+        printf("BENCH alarm pending=%u ns_per_dispatch=%.1f\n",
+               sizes[s], bench_elapsed_ns(start) / BENCH_ALARM_DISPATCHES);
+
+        alarm_context_destroy(bench_alarm_context);
+    }
+}
+
+#define BENCH_RENDER_WIDTH  384
+#define BENCH_RENDER_HEIGHT 272
+#define BENCH_RENDER_FRAMES 20
+
+/* A frame of 8x8 character cells in a few colours, like most screens are,
+   rendered with the plain and the word parallel renderers.  */
+static void bench_render(void)
+{
+    static const char * const scaler_names[3] = { "1x1", "2x2", "scale2x" };
+    const video_render_kernels_t *kernels[2];
+    video_render_config_t *config;
+    unsigned int pitchs = BENCH_RENDER_WIDTH + 2;
+    unsigned int pitcht = BENCH_RENDER_WIDTH * 2 * 4;
+    uint8_t *src, *trg[2];
+    size_t trg_size = (size_t)pitcht * BENCH_RENDER_HEIGHT * 2;
+    uint32_t seed = 1;
+    unsigned int x, y, i;
+    int depth, scaler, k, n;
+
+    config = lib_calloc(1, sizeof(video_render_config_t));
+    config->readable = 1;
+    config->doublescan = 1;
+
+    src = lib_calloc(pitchs, BENCH_RENDER_HEIGHT + 2);
+    for (y = 0; y < BENCH_RENDER_HEIGHT + 2; y++) {
+        for (x = 0; x < pitchs; x++) {
+            seed = seed * 1103515245 + 12345;
+            /* background, or one of two colours where the character has ink */
+            src[y * pitchs + x] = ((seed >> 16) & 3) ? 6 : (uint8_t)(14 + ((x >> 3) & 1));
+        }
+    }
+    trg[0] = lib_malloc(trg_size);
+    trg[1] = lib_malloc(trg_size);
+
+    kernels[0] = video_render_get_kernels(0);
+    kernels[1] = video_render_get_kernels(1);
+
+    for (depth = 16; depth <= 32; depth += 16) {
+        for (i = 0; i < 256; i++) {
+            uint32_t color = i * 0x01030507;
+
+            config->color_tables.physical_colors[i] = (depth == 16) ? ((color & 0xffff) | (color << 16)) : color;
+        }
+        for (scaler = 0; scaler < 3; scaler++) {
+            double ns[2] = { 0.0, 0.0 };
+            unsigned int pixels = BENCH_RENDER_WIDTH * BENCH_RENDER_HEIGHT * (scaler ? 4 : 1);
+
+            for (k = 0; k < 2; k++) {
+                const video_render_kernels_t *kern = kernels[k];
+                video_render_1x1_func_t func = NULL;
+                video_render_2x2_func_t func_2x2 = NULL;
+                uint64_t start;
+
+                if (kern == NULL) {
+                    continue;
+                }
+                switch (scaler) {
+                    case 0:
+                        func = (depth == 16) ? kern->render_16_1x1 : kern->render_32_1x1;
+                        break;
+                    case 1:
+                        func_2x2 = (depth == 16) ? kern->render_16_2x2 : kern->render_32_2x2;
+                        break;
+                    case 2:
+                        func = (depth == 16) ? kern->render_16_scale2x : kern->render_32_scale2x;
+                        break;
+                }
+
+                memset(trg[k], 0, trg_size);
+                start = bench_ticks();
+                for (n = 0; n < BENCH_RENDER_FRAMES; n++) {
+                    if (func_2x2 != NULL) {
+                        func_2x2(&config->color_tables, src, trg[k],
+                                 BENCH_RENDER_WIDTH * 2, BENCH_RENDER_HEIGHT * 2,
+                                 1, 1, 0, 0, pitchs, pitcht, 1, config);
+                    } else {
+                        func(&config->color_tables, src, trg[k],
+                             BENCH_RENDER_WIDTH * (scaler ? 2 : 1), BENCH_RENDER_HEIGHT * (scaler ? 2 : 1),
+                             1, 1, 0, 0, pitchs, pitcht);
+                    }
+                }
+                ns[k] = bench_elapsed_ns(start) / BENCH_RENDER_FRAMES;
+            }
+
+            if (kernels[1] == NULL) {
+                log_message(bench_log, "render: %2d bpp %-7s plain %.3f pixels/ns",
+                            depth, scaler_names[scaler], pixels / ns[0]);
+                printf("BENCH render depth=%d scaler=%s plain_pixels_per_ns=%.3f\n",
+                       depth, scaler_names[scaler], pixels / ns[0]);
+                continue;
+            }
+            log_message(bench_log, "render: %2d bpp %-7s plain %.3f, word parallel %.3f pixels/ns%s",
+                        depth, scaler_names[scaler], pixels / ns[0], pixels / ns[1],
+                        memcmp(trg[0], trg[1], trg_size) ? ", OUTPUT DIFFERS" : "");
+            printf("BENCH render depth=%d scaler=%s plain_pixels_per_ns=%.3f simd_pixels_per_ns=%.3f speedup=%.2f identical=%d\n",
+                   depth, scaler_names[scaler], pixels / ns[0], pixels / ns[1], ns[0] / ns[1],
+                   memcmp(trg[0], trg[1], trg_size) ? 0 : 1);
+        }
+    }
+
+    lib_free(trg[0]);
+    lib_free(trg[1]);
+    lib_free(src);
+    lib_free(config);
+}
+
+/* The same frame through the 1x1 PAL renderer, working out every pixel
+   from the colour tables and with the lookup tables.  */
+static void bench_pal(void)
+{
+    video_render_config_t *config;
+    video_render_color_tables_t *tab;
+    unsigned int pitchs = BENCH_RENDER_WIDTH + 4;
+    unsigned int pitcht = BENCH_RENDER_WIDTH * 4;
+    uint8_t *src, *trg[2];
+    size_t trg_size = (size_t)pitcht * BENCH_RENDER_HEIGHT;
+    uint32_t seed = 1;
+    unsigned int x, y, i;
+    int depth, k, n;
+
+    config = lib_calloc(1, sizeof(video_render_config_t));
+    config->video_resources.color_saturation = 1000;
+    config->video_resources.color_contrast = 1000;
+    config->video_resources.color_brightness = 1000;
+    config->video_resources.color_gamma = 2200;
+    config->video_resources.color_tint = 1000;
+    config->video_resources.pal_blur = 500;
+    config->video_resources.pal_oddlines_offset = 750;
+    video_render_initraw(config);
+
+    /* a made up palette, in the range of the real ones */
+    tab = &config->color_tables;
+    for (i = 0; i < 16; i++) {
+        int32_t val = (int32_t)((i * 37) & 0xff) * 256;
+        int32_t cb = ((int32_t)((i * 53) & 0x7f) - 64) * 256;
+        int32_t cr = ((int32_t)((i * 91) & 0x7f) - 64) * 256;
+
+        tab->ytablel[i] = val * 32;
+        tab->ytableh[i] = val * 191;
+        tab->cbtable[i] = cb;
+        tab->crtable[i] = cr;
+        tab->cbtable_odd[i] = -cb;
+        tab->crtable_odd[i] = -cr;
+    }
+    render_1x1_pal_update_tables(tab);
+
+    src = lib_calloc(pitchs, BENCH_RENDER_HEIGHT + 2);
+    for (y = 0; y < BENCH_RENDER_HEIGHT + 2; y++) {
+        for (x = 0; x < pitchs; x++) {
+            seed = seed * 1103515245 + 12345;
+            src[y * pitchs + x] = ((seed >> 16) & 3) ? 6 : (uint8_t)(14 + ((x >> 3) & 1));
+        }
+    }
+    trg[0] = lib_malloc(trg_size);
+    trg[1] = lib_malloc(trg_size);
+
+    for (depth = 16; depth <= 32; depth += 16) {
+        double ns[2];
+
+        for (k = 0; k < 2; k++) {
+            uint64_t start;
+
+            tab->pal_lut_updated = k;
+            memset(trg[k], 0, trg_size);
+            start = bench_ticks();
+            for (n = 0; n < BENCH_RENDER_FRAMES; n++) {
+                if (depth == 16) {
+                    render_16_1x1_pal(tab, src, trg[k], BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT,
+                                      2, 1, 0, 0, pitchs, pitcht, config);
+                } else {
+                    render_32_1x1_pal(tab, src, trg[k], BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT,
+                                      2, 1, 0, 0, pitchs, pitcht, config);
+                }
+            }
+            ns[k] = bench_elapsed_ns(start) / BENCH_RENDER_FRAMES;
+        }
+
+        log_message(bench_log, "pal: %2d bpp 1x1 %.3f ms/frame, with lookup tables %.3f ms/frame%s",
+                    depth, ns[0] / 1e6, ns[1] / 1e6,
+                    memcmp(trg[0], trg[1], trg_size) ? ", OUTPUT DIFFERS" : "");
+        printf("BENCH pal depth=%d scaler=1x1 plain_ms_per_frame=%.3f lut_ms_per_frame=%.3f speedup=%.2f identical=%d\n",
+               depth, ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1],
+               memcmp(trg[0], trg[1], trg_size) ? 0 : 1);
+    }
+
+    lib_free(trg[0]);
+    lib_free(trg[1]);
+    lib_free(src);
+    lib_free(config);
+}
+
+/* Putting a frame on the screen as SDL does on the 3DS: rendered to the
+   shadow surface, copied to the screen surface and, for an 8 bit screen,
+   looked up in the palette into the buffer that is displayed.  */
+static void bench_paletted(void)
+{
+    video_render_config_t *config;
+    unsigned int pitchs = BENCH_RENDER_WIDTH + 2;
+    uint8_t *src, *shadow, *screen;
+    uint32_t *trg[2], palette[256];
+    size_t trg_size = (size_t)BENCH_RENDER_WIDTH * BENCH_RENDER_HEIGHT * 4;
+    uint32_t seed = 1;
+    unsigned int x, y, i;
+    double ns[2];
+    int k, n;
+
+    config = lib_calloc(1, sizeof(video_render_config_t));
+
+    src = lib_calloc(pitchs, BENCH_RENDER_HEIGHT + 2);
+    for (y = 0; y < BENCH_RENDER_HEIGHT + 2; y++) {
+        for (x = 0; x < pitchs; x++) {
+            seed = seed * 1103515245 + 12345;
+            src[y * pitchs + x] = ((seed >> 16) & 3) ? 6 : (uint8_t)(14 + ((x >> 3) & 1));
+        }
+    }
+    for (i = 0; i < 256; i++) {
+        palette[i] = i * 0x01030507;
+    }
+    shadow = lib_malloc(trg_size);
+    screen = lib_malloc(trg_size);
+    trg[0] = lib_malloc(trg_size);
+    trg[1] = lib_malloc(trg_size);
+
+    for (k = 0; k < 2; k++) {
+        unsigned int bpp = k ? 1 : 4;
+        unsigned int pitcht = BENCH_RENDER_WIDTH * bpp;
+        uint64_t start;
+
+        for (i = 0; i < 256; i++) {
+            video_render_setphysicalcolor(config, (int)i, k ? i : palette[i], k ? 8 : 32);
+        }
+        memset(trg[k], 0, trg_size);
+        start = bench_ticks();
+        for (n = 0; n < BENCH_RENDER_FRAMES; n++) {
+            if (k) {
+                render_08_1x1_04(&config->color_tables, src, shadow, BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT,
+                                 1, 1, 0, 0, pitchs, pitcht);
+            } else {
+                render_32_1x1_04(&config->color_tables, src, shadow, BENCH_RENDER_WIDTH, BENCH_RENDER_HEIGHT,
+                                 1, 1, 0, 0, pitchs, pitcht);
+            }
+            for (y = 0; y < BENCH_RENDER_HEIGHT; y++) {
+                memcpy((k ? screen : (uint8_t *)trg[k]) + y * pitcht, shadow + y * pitcht, pitcht);
+            }
+            if (k) {
+                for (i = 0; i < BENCH_RENDER_WIDTH * BENCH_RENDER_HEIGHT; i++) {
+                    trg[k][i] = palette[screen[i]];
+                }
+            }
+        }
+        ns[k] = bench_elapsed_ns(start) / BENCH_RENDER_FRAMES;
+    }
+
+    log_message(bench_log, "paletted: 1x1 true colour %.3f ms/frame, paletted %.3f ms/frame%s",
+                ns[0] / 1e6, ns[1] / 1e6,
+                memcmp(trg[0], trg[1], trg_size) ? ", OUTPUT DIFFERS" : "");
+    printf("BENCH paletted scaler=1x1 truecolour_ms_per_frame=%.3f paletted_ms_per_frame=%.3f speedup=%.2f identical=%d\n",
+           ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1],
+           memcmp(trg[0], trg[1], trg_size) ? 0 : 1);
+
+    lib_free(trg[0]);
+    lib_free(trg[1]);
+    lib_free(screen);
+    lib_free(shadow);
+    lib_free(src);
+    lib_free(config);
+}
+
+/* The micro-benchmarks common to all machines; the machines register
+   their own with bench_register_micro().  */
+typedef struct bench_micro_s {
+    const char *name;
+    void (*run)(void);
+} bench_micro_t;
+
+static const bench_micro_t micro_benchmarks[] = {
+    { "alarm", bench_alarm },
+    { "render", bench_render },
+    { "pal", bench_pal },
+    { "paletted", bench_paletted },
+#ifdef HAVE_RESID
+    { "resid", resid_bench },
+#endif
+    { "sidqueue", sound_queue_bench },
+    { NULL, NULL }
+};
+
+#define BENCH_MACHINE_MICRO_MAX 4
+
+static bench_micro_t machine_micro_benchmarks[BENCH_MACHINE_MICRO_MAX + 1];
+static int machine_micro_count = 0;
+
+void bench_register_micro(const char *name, void (*run)(void))
+{
+    if (machine_micro_count < BENCH_MACHINE_MICRO_MAX) {
+        machine_micro_benchmarks[machine_micro_count].name = name;
+        machine_micro_benchmarks[machine_micro_count].run = run;
+        machine_micro_count++;
+    }
+}
+
+static void bench_run_micro_list(const bench_micro_t *m)
+{
+    for (; m->name != NULL; m++) {
+        if (!strcmp(bench_micro, "all") || !strcmp(bench_micro, m->name)) {
+            m->run();
+        }
+    }
+}
+
+static void bench_run_micro(void)
+{
+    bench_run_micro_list(micro_benchmarks);
+    bench_run_micro_list(machine_micro_benchmarks);
+    fflush(stdout);
+}
+
+void bench_vsync(void)
+{
+    if (bench_micro != NULL && *bench_micro != 0) {
+        bench_run_micro();
+        archdep_vice_exit(EXIT_SUCCESS);
+    }
+
+    if (frame_count < 0) {
+        /* first frame: everything before this was machine startup */
+        start_clk = maincpu_clk;
+        start_tick = last_tick = bench_ticks();
+        memset(subsystem_ticks, 0, sizeof(subsystem_ticks));
+        frame_count = 0;
+        return;
+    }
+
+    if (++frame_count >= bench_frames) {
+        bench_report();
+        archdep_vice_exit(EXIT_SUCCESS);
+    }
+}
+
+#endif
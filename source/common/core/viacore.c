@@ -827,6 +827,26 @@ uint8_t viacore_read_(via_context_t *via_context, uint16_t addr)
     return via_context->via[addr];
 }
 
+/* Does reading register `addr' return a value worked out from the clock
+   (the timer counters, or PB7 driven by timer 1) rather than one that only
+   changes on a store or an alarm?  */
+int viacore_read_is_timed(via_context_t *via_context, uint16_t addr)
+{
+    addr &= 0xf;
+
+    switch (addr) {
+        case VIA_T1CL:
+        case VIA_T1CH:
+        case VIA_T2CL:
+        case VIA_T2CH:
+            return 1;
+        case VIA_PRB:
+            return (via_context->via[VIA_ACR] & 0x80) != 0;
+        default:
+            return 0;
+    }
+}
+
 /* return value of a register without side effects */
 /* FIXME: this is buggy/incomplete */
 uint8_t viacore_peek(via_context_t *via_context, uint16_t addr)
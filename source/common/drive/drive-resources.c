@@ -30,6 +30,7 @@
 
 #include "drive-check.h"
 #include "drive-resources.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
@@ -55,6 +56,9 @@ int drive_sound_emulation;
 /* volume of the drive sound */
 int drive_sound_emulation_volume;
 
+/* Is the drive CPU idle loop detector switched on?  */
+int drive_idle_detect;
+
 static int set_drive_true_emulation(int val, void *param)
 {
     unsigned int dnr;
@@ -109,6 +113,13 @@ static int set_drive_sound_emulation_volume(int val, void *param)
     return 0;
 }
 
+static int set_drive_idle_detect(int val, void *param)
+{
+    drive_idle_detect = val ? 1 : 0;
+
+    return 0;
+}
+
 static int set_drive_extend_image_policy(int val, void *param)
 {
     switch (val) {
@@ -340,6 +351,8 @@ static const resource_int_t resources_int[] = {
       &drive_sound_emulation, set_drive_sound_emulation, NULL },
     { "DriveSoundEmulationVolume", 1000, RES_EVENT_NO, (resource_value_t)1000,
       &drive_sound_emulation_volume, set_drive_sound_emulation_volume, NULL },
+    { "DriveIdleDetect", 1, RES_EVENT_NO, NULL,
+      &drive_idle_detect, set_drive_idle_detect, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -420,7 +433,8 @@ int drive_resources_init(void)
         }
     }
 
-    if (resources_register_int(resources_int) < 0) {
+    if (resources_register_int(resources_int) < 0
+        || drive_thread_resources_init() < 0) {
         return -1;
     }
     /* make sure machine_drive_resources_init() is called last here, as that
@@ -35,6 +35,7 @@
 #include "diskimage.h"
 #include "drive-snapshot.h"
 #include "drive-sound.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
@@ -107,7 +108,10 @@ Type                 DWORD  2      drive type
 #define DRIVE_SNAP_MAJOR 1
 #define DRIVE_SNAP_MINOR 4
 
-int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
+static int drive_snapshot_write_quick_id(snapshot_t *s);
+
+static int drive_snapshot_write(snapshot_t *s, int save_disks, int save_roms,
+                                int quick)
 {
     int i;
     char snap_module_name[] = "DRIVE";
@@ -118,6 +122,8 @@ int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
     int sync_factor;
     drive_t *drive;
 
+    drive_thread_sync();
+
     resources_get_int("DriveTrueEmulation", &drive_true_emulation);
 
     if (vdrive_snapshot_module_write(s, drive_true_emulation ? 10 : 8) < 0) {
@@ -128,7 +134,10 @@ int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
         return 0;
     }
 
-    drive_gcr_data_writeback_all();
+    /* an in-memory snapshot leaves the disk images alone */
+    if (!quick) {
+        drive_gcr_data_writeback_all();
+    }
 
     rotation_table_get(rotation_table_ptr);
 
@@ -292,6 +301,74 @@ int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
         }
     }
 
+    if (quick && drive_snapshot_write_quick_id(s) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int drive_snapshot_write_module(snapshot_t *s, int save_disks, int save_roms)
+{
+    return drive_snapshot_write(s, save_disks, save_roms, 0);
+}
+
+int drive_snapshot_write_quick_module(snapshot_t *s)
+{
+    return drive_snapshot_write(s, 0, 0, 1);
+}
+
+/* The current DRIVE module fields of one drive.  */
+static int drive_snapshot_read_drive(snapshot_module_t *m, drive_t *drive,
+                                     CLOCK *attach_clk, CLOCK *detach_clk,
+                                     int *half_track,
+                                     uint32_t *rotation_table_ptr)
+{
+    uint8_t dummy;
+
+    if (0
+        || SMR_DW(m, attach_clk) < 0
+        || SMR_B_INT(m, (int *)&(drive->byte_ready_level)) < 0
+        || SMR_B_INT(m, &(drive->clock_frequency)) < 0
+        || SMR_W_INT(m, half_track) < 0
+        || SMR_DW(m, detach_clk) < 0
+        || SMR_B(m, &dummy) < 0
+        || SMR_B(m, &dummy) < 0
+        || SMR_B_INT(m, &(drive->extend_image_policy)) < 0
+        || SMR_DW_UINT(m, &(drive->GCR_head_offset)) < 0
+        || SMR_B(m, &(drive->GCR_read)) < 0
+        || SMR_B(m, &(drive->GCR_write_value)) < 0
+        || SMR_B_INT(m, &(drive->idling_method)) < 0
+        || SMR_B_INT(m, &(drive->parallel_cable)) < 0
+        || SMR_B_INT(m, &(drive->read_only)) < 0
+        || SMR_DW(m, rotation_table_ptr) < 0
+        || SMR_DW_UINT(m, &(drive->type)) < 0
+
+        || SMR_DW_UL(m, &(drive->snap_accum)) < 0
+        || SMR_DW(m, &(drive->snap_rotation_last_clk)) < 0
+        || SMR_DW_INT(m, &(drive->snap_bit_counter)) < 0
+        || SMR_DW_INT(m, &(drive->snap_zero_count)) < 0
+        || SMR_W_INT(m, &(drive->snap_last_read_data)) < 0
+        || SMR_B(m, &(drive->snap_last_write_data)) < 0
+        || SMR_DW_INT(m, &(drive->snap_seed)) < 0
+        || SMR_DW(m, &(drive->snap_speed_zone)) < 0
+        || SMR_DW(m, &(drive->snap_ue7_dcba)) < 0
+        || SMR_DW(m, &(drive->snap_ue7_counter)) < 0
+        || SMR_DW(m, &(drive->snap_uf4_counter)) < 0
+        || SMR_DW(m, &(drive->snap_fr_randcount)) < 0
+        || SMR_DW(m, &(drive->snap_filter_counter)) < 0
+        || SMR_DW(m, &(drive->snap_filter_state)) < 0
+        || SMR_DW(m, &(drive->snap_filter_last_state)) < 0
+        || SMR_DW(m, &(drive->snap_write_flux)) < 0
+        || SMR_DW(m, &(drive->snap_PulseHeadPosition)) < 0
+        || SMR_DW(m, &(drive->snap_xorShift32)) < 0
+        || SMR_DW(m, &(drive->snap_so_delay)) < 0
+        || SMR_DW(m, &(drive->snap_cycle_index)) < 0
+        || SMR_DW(m, &(drive->snap_ref_advance)) < 0
+        || SMR_DW(m, &(drive->snap_req_ref_cycles)) < 0
+        ) {
+        return -1;
+    }
     return 0;
 }
 
@@ -311,6 +388,8 @@ int drive_snapshot_read_module(snapshot_t *s)
     int dummy;
     int half_track[DRIVE_NUM];
 
+    drive_thread_sync();
+
     m = snapshot_module_open(s, snap_module_name,
                              &major_version, &minor_version);
     if (m == NULL) {
@@ -487,47 +566,8 @@ int drive_snapshot_read_module(snapshot_t *s)
                 return -1;
             }
         } else {
-            if (0
-                || SMR_DW(m, &(attach_clk[i])) < 0
-                || SMR_B_INT(m, (int *)&(drive->byte_ready_level)) < 0
-                || SMR_B_INT(m, &(drive->clock_frequency)) < 0
-                || SMR_W_INT(m, &half_track[i]) < 0
-                || SMR_DW(m, &(detach_clk[i])) < 0
-                || SMR_B(m, (uint8_t *)&dummy) < 0
-                || SMR_B(m, (uint8_t *)&dummy) < 0
-                || SMR_B_INT(m, &(drive->extend_image_policy)) < 0
-                || SMR_DW_UINT(m, &(drive->GCR_head_offset)) < 0
-                || SMR_B(m, &(drive->GCR_read)) < 0
-                || SMR_B(m, &(drive->GCR_write_value)) < 0
-                || SMR_B_INT(m, &(drive->idling_method)) < 0
-                || SMR_B_INT(m, &(drive->parallel_cable)) < 0
-                || SMR_B_INT(m, &(drive->read_only)) < 0
-                || SMR_DW(m, &rotation_table_ptr[i]) < 0
-                || SMR_DW_UINT(m, &(drive->type)) < 0
-
-                || SMR_DW_UL(m, &(drive->snap_accum)) < 0
-                || SMR_DW(m, &(drive->snap_rotation_last_clk)) < 0
-                || SMR_DW_INT(m, &(drive->snap_bit_counter)) < 0
-                || SMR_DW_INT(m, &(drive->snap_zero_count)) < 0
-                || SMR_W_INT(m, &(drive->snap_last_read_data)) < 0
-                || SMR_B(m, &(drive->snap_last_write_data)) < 0
-                || SMR_DW_INT(m, &(drive->snap_seed)) < 0
-                || SMR_DW(m, &(drive->snap_speed_zone)) < 0
-                || SMR_DW(m, &(drive->snap_ue7_dcba)) < 0
-                || SMR_DW(m, &(drive->snap_ue7_counter)) < 0
-                || SMR_DW(m, &(drive->snap_uf4_counter)) < 0
-                || SMR_DW(m, &(drive->snap_fr_randcount)) < 0
-                || SMR_DW(m, &(drive->snap_filter_counter)) < 0
-                || SMR_DW(m, &(drive->snap_filter_state)) < 0
-                || SMR_DW(m, &(drive->snap_filter_last_state)) < 0
-                || SMR_DW(m, &(drive->snap_write_flux)) < 0
-                || SMR_DW(m, &(drive->snap_PulseHeadPosition)) < 0
-                || SMR_DW(m, &(drive->snap_xorShift32)) < 0
-                || SMR_DW(m, &(drive->snap_so_delay)) < 0
-                || SMR_DW(m, &(drive->snap_cycle_index)) < 0
-                || SMR_DW(m, &(drive->snap_ref_advance)) < 0
-                || SMR_DW(m, &(drive->snap_req_ref_cycles)) < 0
-                ) {
+            if (drive_snapshot_read_drive(m, drive, &attach_clk[i], &detach_clk[i],
+                                          &half_track[i], &rotation_table_ptr[i]) < 0) {
                 snapshot_module_close(m);
                 return -1;
             }
@@ -703,6 +743,212 @@ int drive_snapshot_read_module(snapshot_t *s)
     return 0;
 }
 
+/* -------------------------------------------------------------------- */
+/* in-memory snapshots */
+
+/* Run-ahead and rewind take and restore in-memory snapshots many times a
+   second.  Those neither write the disk images back nor read them again.
+   If the drives, their images and the video standard are still the ones
+   the snapshot was taken with, only the drive CPU, chip and head state is
+   restored; otherwise it is read like any other snapshot.  What was
+   written to the disks in the meantime stays on them.  */
+
+#define DRIVEQUICK_SNAP_MAJOR 1
+#define DRIVEQUICK_SNAP_MINOR 0
+
+static int drive_snapshot_write_quick_id(snapshot_t *s)
+{
+    snapshot_module_t *m;
+    int i, sync_factor;
+    drive_t *drive;
+
+    m = snapshot_module_create(s, "DRIVEQUICK", DRIVEQUICK_SNAP_MAJOR,
+                               DRIVEQUICK_SNAP_MINOR);
+    if (m == NULL) {
+        return -1;
+    }
+
+    resources_get_int("MachineVideoStandard", &sync_factor);
+
+    if (SMW_DW(m, (uint32_t)sync_factor) < 0) {
+        snapshot_module_close(m);
+        return -1;
+    }
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (0
+            || SMW_DW(m, (uint32_t)(drive->type)) < 0
+            || SMW_B(m, (uint8_t)(drive->enable)) < 0
+            || SMW_DW(m, (uint32_t)(drive->image_serial)) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+    return snapshot_module_close(m);
+}
+
+/* Whether the drives are set up as when the snapshot was taken.  */
+static int drive_snapshot_quick_matches(snapshot_t *s)
+{
+    uint8_t major_version, minor_version;
+    snapshot_module_t *m;
+    int i, sync_factor, now_sync_factor, drive_true_emulation;
+    uint32_t type, image_serial;
+    uint8_t enable;
+    drive_t *drive;
+
+    resources_get_int("DriveTrueEmulation", &drive_true_emulation);
+    if (!drive_true_emulation) {
+        return 0;
+    }
+
+    m = snapshot_module_open(s, "DRIVEQUICK", &major_version, &minor_version);
+    if (m == NULL) {
+        return 0;
+    }
+
+    resources_get_int("MachineVideoStandard", &now_sync_factor);
+
+    if (SMR_DW_INT(m, &sync_factor) < 0 || sync_factor != now_sync_factor) {
+        snapshot_module_close(m);
+        return 0;
+    }
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (0
+            || SMR_DW(m, &type) < 0
+            || SMR_B(m, &enable) < 0
+            || SMR_DW(m, &image_serial) < 0
+            || type != drive->type
+            || enable != drive->enable
+            || image_serial != drive->image_serial) {
+            snapshot_module_close(m);
+            return 0;
+        }
+    }
+    snapshot_module_close(m);
+    return 1;
+}
+
+int drive_snapshot_read_quick_module(snapshot_t *s)
+{
+    uint8_t major_version, minor_version;
+    snapshot_module_t *m;
+    uint32_t rotation_table_ptr[DRIVE_NUM];
+    CLOCK attach_clk[DRIVE_NUM];
+    CLOCK detach_clk[DRIVE_NUM];
+    CLOCK attach_detach_clk[DRIVE_NUM];
+    unsigned int head_offset;
+    int half_track[DRIVE_NUM];
+    int i, sync_factor, side;
+    drive_t *drive;
+
+    drive_thread_sync();
+
+    if (!drive_snapshot_quick_matches(s)) {
+        return drive_snapshot_read_module(s);
+    }
+
+    m = snapshot_module_open(s, "DRIVE", &major_version, &minor_version);
+    if (m == NULL) {
+        return -1;
+    }
+
+    if (SMR_DW_INT(m, &sync_factor) < 0) {
+        snapshot_module_close(m);
+        return -1;
+    }
+    for (i = 0; i < 2; i++) {
+        if (drive_snapshot_read_drive(m, drive_context[i]->drive, &attach_clk[i],
+                                      &detach_clk[i], &half_track[i],
+                                      &rotation_table_ptr[i]) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        if (SMR_DW(m, &(attach_detach_clk[i])) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (0
+            || SMR_B_INT(m, (int *)&(drive->byte_ready_edge)) < 0
+            || SMR_B_INT(m, (int *)&(drive->byte_ready_active)) < 0) {
+            snapshot_module_close(m);
+            return -1;
+        }
+    }
+    snapshot_module_close(m);
+
+    rotation_table_set(rotation_table_ptr);
+
+    /* Clear parallel cable before undumping parallel port values.  */
+    for (i = 0; i < DRIVE_PC_NUM; i++) {
+        parallel_cable_drive_write(i, 0xff, PARALLEL_WRITE, 0);
+        parallel_cable_drive_write(i, 0xff, PARALLEL_WRITE, 1);
+    }
+
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (drive->enable) {
+            if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
+                if (drivecpu65c02_snapshot_read_module(drive_context[i], s) < 0) {
+                    return -1;
+                }
+            } else {
+                if (drivecpu_snapshot_read_module(drive_context[i], s) < 0) {
+                    return -1;
+                }
+            }
+            if (machine_drive_snapshot_read(drive_context[i], s) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (i = 0; i < 2; i++) {
+        drive = drive_context[i]->drive;
+        if (drive->type == DRIVE_TYPE_NONE) {
+            continue;
+        }
+
+        /* what drive_enable() does, without attaching the image again */
+        drive_context[i]->cpu->stop_clk = *(drive_context[i]->clk_ptr);
+        if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
+            drivecpu65c02_wake_up(drive_context[i]);
+        } else {
+            drivecpu_wake_up(drive_context[i]);
+        }
+        drive->attach_clk = attach_clk[i];
+        drive->detach_clk = detach_clk[i];
+        drive->attach_detach_clk = attach_detach_clk[i];
+
+        side = 0;
+        if (drive->type == DRIVE_TYPE_1570
+            || drive->type == DRIVE_TYPE_1571
+            || drive->type == DRIVE_TYPE_1571CR) {
+            if (half_track[i] > (DRIVE_HALFTRACKS_1571 + 1)) {
+                side = 1;
+                half_track[i] -= DRIVE_HALFTRACKS_1571;
+            }
+        }
+        /* the head offset was saved for the track it is restored to */
+        head_offset = drive->GCR_head_offset;
+        drive_set_half_track(half_track[i], side, drive);
+        if (head_offset < drive->GCR_current_track_size) {
+            drive->GCR_head_offset = head_offset;
+        }
+    }
+
+    iec_update_ports_embedded();
+    drive_update_ui_status();
+
+    return vdrive_snapshot_module_read(s, 10);
+}
+
 /* -------------------------------------------------------------------- */
 /* read/write "normal" disk image snapshot module */
 
@@ -0,0 +1,368 @@
+/*
+ * drive-thread.c - Running the drive CPUs on a second host thread.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With "DriveThread" enabled, the drive CPUs are run on another core while
+   the main CPU goes on.  Every DRIVE_THREAD_SLICE main CPU cycles an alarm
+   hands the drive thread the current main CPU clock, and the thread runs
+   the drives up to it.  The main CPU doesn't wait for that unless it gets
+   to the bus (or anything else that looks at the drives), where it calls
+   drive_cpu_execute_*() as it always did; that first waits for the thread
+   to finish its slice and then runs the drives the rest of the way itself.
+
+   So the drives never get past a clock the main CPU has already reached,
+   and nothing the main CPU does to the bus can happen behind their back:
+   the result is exactly the same as without the thread, only part of the
+   drive emulation is done in parallel.  This holds as long as the drives
+   only talk to the main CPU through the serial bus, so drives with a
+   parallel cable or fast serial port, drive sound, drives that are idled
+   by skipping cycles, and anything but a 1540/1541 are always run the
+   usual way.
+
+   The drive thread doesn't look at the main CPU or call into the UI: a
+   drive CPU that jams on it is only noted, and reported by the main thread
+   when it collects the slice.
+
+   The drive thread needs a core of its own, so it is only used on the
+   New 3DS.  */
+
+#include "vice.h"
+
+#include "alarm.h"
+#include "bench.h"
+#include "drive-thread.h"
+#include "drive.h"
+#include "drivecpu.h"
+#include "drivetypes.h"
+#include "log.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "types.h"
+#include "vice3ds.h"
+
+/* main CPU cycles per slice */
+#define DRIVE_THREAD_SLICE      1000
+
+#define DRIVE_THREAD_STACKSIZE  (32 * 1024)
+#define DRIVE_THREAD_PRIORITY   VICE3DS_PRIO_DRIVE
+#define DRIVE_THREAD_CORE       2
+
+static log_t drive_thread_log = LOG_ERR;
+
+static Thread thread = NULL;
+static SDL_sem *work_sem = NULL;
+static SDL_sem *done_sem = NULL;
+
+/* set if the thread could not be started; the drives then run as usual */
+static int thread_failed = 0;
+
+/* whether the thread has a slice that nobody has waited for yet */
+static int busy = 0;
+
+/* held while waiting for the thread: the menus run on a thread of their
+   own and may call drive_thread_sync() while the main thread is waiting
+   too, and only one of them would get the semaphore */
+static LightLock sync_lock;
+
+/* the slice: the drives to run and the main CPU clock to run them to,
+   written by the main thread before posting `work_sem' */
+static unsigned int slice_drives;
+static CLOCK slice_clk;
+static int thread_quit = 0;
+
+/* the drives that jammed during the slice, written by the drive thread */
+static unsigned int slice_jams;
+
+/* the jams collected from the slices and not reported yet */
+static unsigned int jams = 0;
+
+static alarm_t *slice_alarm = NULL;
+
+extern int drive_sound_emulation;
+
+static drive_thread_stats_t stats;
+
+/* ------------------------------------------------------------------------- */
+
+static int drive_thread_enabled;
+
+static int set_drive_thread_enabled(int val, void *param)
+{
+    drive_thread_sync();
+    drive_thread_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "DriveThread", 0, RES_EVENT_NO, NULL,
+      &drive_thread_enabled, set_drive_thread_enabled, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int drive_thread_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void drive_thread_func(void *data)
+{
+    unsigned int dnr;
+
+    while (1) {
+        SDL_SemWait(work_sem);
+        if (thread_quit) {
+            break;
+        }
+        slice_jams = 0;
+        for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+            if (slice_drives & (1 << dnr)) {
+                drivecpu_execute(drive_context[dnr], slice_clk);
+            }
+        }
+        SDL_SemPost(done_sem);
+    }
+}
+
+static int drive_thread_start(void)
+{
+    drive_thread_log = log_open("DriveThread");
+
+    if (!isN3DS()) {
+        log_message(drive_thread_log, "Needs a New 3DS, drives run on the main thread.");
+        return -1;
+    }
+
+    work_sem = SDL_CreateSemaphore(0);
+    done_sem = SDL_CreateSemaphore(0);
+    if (work_sem == NULL || done_sem == NULL) {
+        log_error(drive_thread_log, "Cannot create semaphores.");
+        return -1;
+    }
+    LightLock_Init(&sync_lock);
+
+    thread = threadCreate(drive_thread_func, NULL, DRIVE_THREAD_STACKSIZE,
+                          DRIVE_THREAD_PRIORITY, DRIVE_THREAD_CORE, false);
+    if (thread == NULL) {
+        log_error(drive_thread_log, "Cannot start the drive thread.");
+        return -1;
+    }
+
+    log_message(drive_thread_log, "Drive thread started.");
+    return 0;
+}
+
+/* Can this drive be run on the thread without changing the result?  */
+static int drive_thread_drive_ok(drive_t *drive)
+{
+    switch (drive->type) {
+        case DRIVE_TYPE_1540:
+        case DRIVE_TYPE_1541:
+        case DRIVE_TYPE_1541II:
+            break;
+        default:
+            return 0;
+    }
+
+    return drive->parallel_cable == DRIVE_PC_NONE
+           && drive->idling_method != DRIVE_IDLE_SKIP_CYCLES
+           && drive->extend_image_policy != DRIVE_EXTEND_ASK;
+}
+
+static void drive_thread_slice(CLOCK clk)
+{
+    unsigned int dnr, drives = 0;
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        drive_t *drive = drive_context[dnr]->drive;
+
+        if (!drive->enable) {
+            continue;
+        }
+        if (!drive_thread_drive_ok(drive)) {
+            /* all or nothing, the drives may talk to each other */
+            return;
+        }
+        if (drive_context[dnr]->cpu->last_clk < clk) {
+            drives |= 1 << dnr;
+        }
+    }
+
+    if (drives == 0) {
+        return;
+    }
+
+    if (thread == NULL) {
+        if (thread_failed || drive_thread_start() < 0) {
+            thread_failed = 1;
+            return;
+        }
+    }
+
+    slice_drives = drives;
+    slice_clk = clk;
+    busy = 1;
+    SDL_SemPost(work_sem);
+
+    stats.slices++;
+}
+
+/* Called with `sync_lock' held once the thread is done with its slice.  */
+static void drive_thread_collect(void)
+{
+    jams |= slice_jams;
+    busy = 0;
+}
+
+/* Report the jams on the main thread, as if the drives had run there.  */
+static void drive_thread_report_jams(void)
+{
+    unsigned int dnr, pending;
+
+    LightLock_Lock(&sync_lock);
+    pending = jams;
+    jams = 0;
+    LightLock_Unlock(&sync_lock);
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if (pending & (1 << dnr)) {
+            drivecpu_jam(drive_context[dnr]);
+        }
+    }
+}
+
+static void drive_thread_alarm_handler(CLOCK offset, void *data)
+{
+    CLOCK clk = maincpu_clk - offset;
+
+    if (!drive_thread_enabled) {
+        return;
+    }
+
+    alarm_set(slice_alarm, clk + DRIVE_THREAD_SLICE);
+
+    if (thread_failed || drive_sound_emulation) {
+        return;
+    }
+
+    if (busy) {
+        LightLock_Lock(&sync_lock);
+        if (busy && SDL_SemTryWait(done_sem) != 0) {
+            LightLock_Unlock(&sync_lock);
+            /* still at it, let it be */
+            stats.busy++;
+            return;
+        }
+        drive_thread_collect();
+        LightLock_Unlock(&sync_lock);
+    }
+
+    if (jams) {
+        drive_thread_report_jams();
+    }
+
+    drive_thread_slice(clk);
+}
+
+/* ------------------------------------------------------------------------- */
+
+void drive_thread_init(void)
+{
+    if (slice_alarm == NULL) {
+        slice_alarm = alarm_new(maincpu_alarm_context, "DriveThread",
+                                drive_thread_alarm_handler, NULL);
+    }
+    drive_thread_vsync();
+}
+
+void drive_thread_shutdown(void)
+{
+    if (thread == NULL) {
+        return;
+    }
+
+    drive_thread_sync();
+
+    thread_quit = 1;
+    SDL_SemPost(work_sem);
+    threadJoin(thread, U64_MAX);
+    threadFree(thread);
+    thread = NULL;
+
+    SDL_DestroySemaphore(work_sem);
+    SDL_DestroySemaphore(done_sem);
+    work_sem = done_sem = NULL;
+}
+
+void drive_thread_vsync(void)
+{
+    if (slice_alarm == NULL) {
+        return;
+    }
+
+    /* "DriveThread" is set from the menu thread, which must not touch the
+       alarms; and the main CPU clock may have been changed by a snapshot */
+    if (drive_thread_enabled) {
+        alarm_set(slice_alarm, maincpu_clk + DRIVE_THREAD_SLICE);
+    } else {
+        alarm_unset(slice_alarm);
+    }
+}
+
+void drive_thread_sync(void)
+{
+    uint64_t start;
+
+    if (busy) {
+        LightLock_Lock(&sync_lock);
+        if (busy) {
+            if (SDL_SemTryWait(done_sem) != 0) {
+                start = bench_ticks();
+                SDL_SemWait(done_sem);
+                stats.waits++;
+                stats.wait_ticks += bench_ticks() - start;
+            }
+            drive_thread_collect();
+        }
+        LightLock_Unlock(&sync_lock);
+    }
+
+    /* the menu thread leaves them to the main thread */
+    if (jams && SDL_ThreadID() == -1) {
+        drive_thread_report_jams();
+    }
+}
+
+int drive_thread_is_current(void)
+{
+    return thread != NULL && threadGetCurrent() == thread;
+}
+
+void drive_thread_jam(drive_context_t *drv)
+{
+    slice_jams |= 1 << drv->mynumber;
+}
+
+void drive_thread_get_stats(drive_thread_stats_t *s)
+{
+    *s = stats;
+}
@@ -45,10 +45,12 @@
 #define assert(x)
 
 #include "attach.h"
+#include "bench.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "drive-check.h"
 #include "drive-overflow.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
@@ -187,6 +189,7 @@ int drive_init(void)
     rom_loaded = 1;
 
     drive_overflow_init();
+    drive_thread_init();
 
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive = drive_context[dnr]->drive;
@@ -268,6 +271,8 @@ void drive_shutdown(void)
         return;
     }
 
+    drive_thread_shutdown();
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         if (drive_context[dnr]->drive->type == DRIVE_TYPE_2000 || drive_context[dnr]->drive->type == DRIVE_TYPE_4000) {
             drivecpu65c02_shutdown(drive_context[dnr]);
@@ -340,6 +345,8 @@ int drive_set_disk_drive_type(unsigned int type, struct drive_context_s *drv)
         return -1;
     }
 
+    drive_thread_sync();
+
     drive = drv->drive;
     rotation_rotate_disk(drive);
 
@@ -426,6 +433,8 @@ int drive_enable(drive_context_t *drv)
         return -1;
     }
 
+    drive_thread_sync();
+
     resources_get_int("DriveTrueEmulation", &drive_true_emulation);
 
     /* Always disable kernal traps. */
@@ -464,6 +473,8 @@ void drive_disable(drive_context_t *drv)
 
     drive = drv->drive;
 
+    drive_thread_sync();
+
     /* This must come first, because this might be called before the true
        drive initialization.  */
     drive->enable = 0;
@@ -503,6 +514,8 @@ void drive_cpu_prevent_clk_overflow_all(CLOCK sub)
 {
     unsigned int dnr;
 
+    drive_thread_sync();
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive_t *drive = drive_context[dnr]->drive;
         if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
@@ -516,6 +529,9 @@ void drive_cpu_prevent_clk_overflow_all(CLOCK sub)
 void drive_cpu_trigger_reset(unsigned int dnr)
 {
     drive_t *drive = drive_context[dnr]->drive;
+
+    drive_thread_sync();
+
     if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
         drivecpu65c02_trigger_reset(dnr);
     } else {
@@ -529,6 +545,8 @@ void drive_reset(void)
     unsigned int dnr;
     drive_t *drive;
 
+    drive_thread_sync();
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive = drive_context[dnr]->drive;
 
@@ -794,11 +812,15 @@ void drive_cpu_execute_one(drive_context_t *drv, CLOCK clk_value)
 {
     drive_t *drive = drv->drive;
 
+    BENCH_ENTER(BENCH_DRIVE);
+    /* the drive thread may still be running its part */
+    drive_thread_sync();
     if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
         drivecpu65c02_execute(drv, clk_value);
     } else {
         drivecpu_execute(drv, clk_value);
     }
+    BENCH_LEAVE(BENCH_DRIVE);
 }
 
 void drive_cpu_execute_all(CLOCK clk_value)
@@ -830,6 +852,9 @@ void drive_vsync_hook(void)
 {
     unsigned int dnr;
 
+    drive_thread_sync();
+    drive_thread_vsync();
+
     drive_update_ui_status();
 
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
@@ -40,6 +40,7 @@
 #include "drive.h"
 #include "drivecpu.h"
 #include "drive-check.h"
+#include "drive-thread.h"
 #include "drivemem.h"
 #include "drivetypes.h"
 #include "interrupt.h"
@@ -130,8 +131,16 @@ void drivecpu_setup_context(struct drive_context_s *drv, int i)
 #define LOAD_ZERO(a)      (*drv->cpud->read_func_ptr[0])(drv, (uint16_t)(a))
 #define LOAD_ADDR(a)      (LOAD((a)) | (LOAD((a) + 1) << 8))
 #define LOAD_ZERO_ADDR(a) (LOAD_ZERO((a)) | (LOAD_ZERO((a) + 1) << 8))
-#define STORE(a, b)       (*drv->cpud->store_func_ptr[(a) >> 8])(drv, (uint16_t)(a), (uint8_t)(b))
-#define STORE_ZERO(a, b)  (*drv->cpud->store_func_ptr[0])(drv, (uint16_t)(a), (uint8_t)(b))
+#define STORE(a, b)                                                                  \
+    do {                                                                             \
+        cpu->idle_store = 1;                                                         \
+        (*drv->cpud->store_func_ptr[(a) >> 8])(drv, (uint16_t)(a), (uint8_t)(b));    \
+    } while (0)
+#define STORE_ZERO(a, b)                                                             \
+    do {                                                                             \
+        cpu->idle_store = 1;                                                         \
+        (*drv->cpud->store_func_ptr[0])(drv, (uint16_t)(a), (uint8_t)(b));           \
+    } while (0)
 
 #define JUMP(addr)                                                         \
     do {                                                                   \
@@ -178,6 +187,8 @@ void drivecpu_reset_clk(drive_context_t *drv)
     drv->cpu->last_clk = maincpu_clk;
     drv->cpu->last_exc_cycles = 0;
     drv->cpu->stop_clk = 0;
+    drv->cpu->idle_loop_pc = 0x10000;
+    drv->cpu->idle_passes = 0;
 }
 
 void drivecpu_reset(drive_context_t *drv)
@@ -242,17 +253,22 @@ void drivecpu_init(drive_context_t *drv, int type)
     drivecpu_reset(drv);
 }
 
-inline void drivecpu_wake_up(drive_context_t *drv)
+static inline void drivecpu_wake_up_at(drive_context_t *drv, CLOCK clk)
 {
     /* FIXME: this value could break some programs, or be way too high for
        others.  Maybe we should put it into a user-definable resource.  */
-    if (maincpu_clk - drv->cpu->last_clk > 0xffffff
+    if (clk - drv->cpu->last_clk > 0xffffff
         && *(drv->clk_ptr) > 934639) {
         log_message(drv->drive->log, "Skipping cycles.");
-        drv->cpu->last_clk = maincpu_clk;
+        drv->cpu->last_clk = clk;
     }
 }
 
+inline void drivecpu_wake_up(drive_context_t *drv)
+{
+    drivecpu_wake_up_at(drv, maincpu_clk);
+}
+
 inline void drivecpu_sleep(drive_context_t *drv)
 {
     /* Currently does nothing.  But we might need this hook some day.  */
@@ -362,6 +378,93 @@ inline static int interrupt_check_irq_delay(interrupt_cpu_status_t *cs,
     return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+
+/* Is the drive CPU idle loop detector switched on?  */
+extern int drive_idle_detect;
+
+/* A polling loop is closed by a backward jump of at most this many bytes,
+   takes at most this many cycles per pass, and must have made this many
+   identical passes before it is skipped.  */
+#define DRIVE_IDLE_LOOP_BYTES   32
+#define DRIVE_IDLE_LOOP_CYCLES  256
+#define DRIVE_IDLE_LOOP_PASSES  3
+
+/* Detect the drive CPU waiting in a tight polling loop and skip the passes
+   that cannot see anything new.
+
+   Apart from the VIA timer counters, everything a 1541 loop can read is
+   either constant between two calls of drivecpu_execute() (the IEC bus and
+   ATN only change when the main CPU writes them, and it runs the drive up
+   to that point first), changes from an alarm (VIA interrupt flags), or
+   comes from the spinning disk.  So if a pass through the loop head leaves
+   the registers exactly as the previous one did, without writing memory,
+   touching the disk, reading a timer counter or having an interrupt
+   pending, every further pass will do the same until the next alarm or the
+   end of this time slice.  Whole passes up to that point are skipped, so
+   the loop resumes in the same phase it would have reached.  Loops that
+   read a timer counter (or PB7 driven by timer 1) are never skipped, as
+   the value read changes every cycle without an alarm.  The disk rotation
+   is computed from the drive clock whenever it is looked at, so
+   rotation_rotate_disk() catches up by itself afterwards.  */
+inline static void drivecpu_idle_detect(drive_context_t *drv)
+{
+    drivecpu_context_t *cpu = drv->cpu;
+    drive_t *drive = drv->drive;
+    mos6510_regs_t *regs = &(cpu->cpu_regs);
+    unsigned int pc = regs->pc;
+    unsigned int last_pc = cpu->idle_last_pc;
+    CLOCK clk, period, next_clk;
+
+    cpu->idle_last_pc = pc;
+
+    /* Only a short backward jump can close the loop; returns from
+       subroutines called inside it are ignored.  */
+    if (pc >= last_pc || last_pc - pc > DRIVE_IDLE_LOOP_BYTES) {
+        return;
+    }
+
+    clk = *(drv->clk_ptr);
+    period = clk - cpu->idle_loop_clk;
+
+    if (pc != cpu->idle_loop_pc
+        || period != cpu->idle_period
+        || period > DRIVE_IDLE_LOOP_CYCLES
+        || cpu->idle_store
+        || drive->rotation_polled
+        || drive->timer_polled
+        || drive->attach_clk != (CLOCK)0
+        || drive->attach_detach_clk != (CLOCK)0
+        || cpu->int_status->global_pending_int != IK_NONE
+        || regs->a != cpu->idle_regs.a
+        || regs->x != cpu->idle_regs.x
+        || regs->y != cpu->idle_regs.y
+        || regs->sp != cpu->idle_regs.sp
+        || regs->p != cpu->idle_regs.p
+        || regs->n != cpu->idle_regs.n
+        || regs->z != cpu->idle_regs.z) {
+        /* something changed, watch this loop afresh */
+        cpu->idle_loop_pc = pc;
+        cpu->idle_passes = 0;
+    } else if (++cpu->idle_passes >= DRIVE_IDLE_LOOP_PASSES) {
+        next_clk = alarm_context_next_pending_clk(cpu->alarm_context);
+        if (next_clk > cpu->stop_clk) {
+            next_clk = cpu->stop_clk;
+        }
+        if (next_clk > clk + period) {
+            clk += (next_clk - clk) / period * period;
+            *(drv->clk_ptr) = clk;
+        }
+    }
+
+    cpu->idle_loop_clk = clk;
+    cpu->idle_period = period;
+    cpu->idle_regs = *regs;
+    cpu->idle_store = 0;
+    drive->rotation_polled = 0;
+    drive->timer_polled = 0;
+}
+
 /* MPi: For some reason MSVC is generating a compiler fatal error when optimising this function? */
 #ifdef _MSC_VER
 #pragma optimize("",off)
@@ -386,7 +489,13 @@ void drivecpu_execute(drive_context_t *drv, CLOCK clk_value)
 
     cpu = drv->cpu;
 
-    drivecpu_wake_up(drv);
+    /* the drive thread runs up to the clock of its slice and must not look
+       at the main CPU, which has gone on */
+    if (drive_thread_is_current()) {
+        drivecpu_wake_up_at(drv, clk_value);
+    } else {
+        drivecpu_wake_up(drv);
+    }
 
     /* Calculate number of main CPU clocks to emulate */
     if (clk_value > cpu->last_clk) {
@@ -452,6 +561,13 @@ void drivecpu_execute(drive_context_t *drv, CLOCK clk_value)
 #define bank_base (cpu->d_bank_base)
 
 #include "6510core-c.h"
+
+        if (drive_idle_detect
+            && (drv->drive->type == DRIVE_TYPE_1540
+                || drv->drive->type == DRIVE_TYPE_1541
+                || drv->drive->type == DRIVE_TYPE_1541II)) {
+            drivecpu_idle_detect(drv);
+        }
     }
 
     cpu->last_clk = clk_value;
@@ -477,6 +593,25 @@ static void drivecpu_set_bank_base(void *context)
 
 /* Inlining this fuction makes no sense and would only bloat the code.  */
 static void drive_jam(drive_context_t *drv)
+{
+    /* the drive thread leaves it to the main thread, see drive-thread.c */
+    if (drive_thread_is_current()) {
+        drive_thread_jam(drv);
+        CLK++;
+        return;
+    }
+
+    switch (drivecpu_jam(drv)) {
+        case JAM_RESET:
+        case JAM_HARD_RESET:
+        case JAM_MONITOR:
+            break;
+        default:
+            CLK++;
+    }
+}
+
+unsigned int drivecpu_jam(drive_context_t *drv)
 {
     unsigned int tmp;
     char *dname = "  Drive";
@@ -547,9 +682,8 @@ static void drive_jam(drive_context_t *drv)
         case JAM_MONITOR:
             //monitor_startup(drv->cpu->monspace);
             break;
-        default:
-            CLK++;
     }
+    return tmp;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -31,6 +31,7 @@
 
 #include "diskconstants.h"
 #include "diskimage.h"
+#include "drive-thread.h"
 #include "drive.h"
 #include "driveimage.h"
 #include "drivetypes.h"
@@ -137,6 +138,8 @@ int drive_image_attach(disk_image_t *image, unsigned int unit)
     dnr = unit - 8;
     drive = drive_context[dnr]->drive;
 
+    drive_thread_sync();
+
     if (drive_check_image_format(image->type, dnr) < 0) {
         return -1;
     }
@@ -162,6 +165,10 @@ int drive_image_attach(disk_image_t *image, unsigned int unit)
             return -1;
     }
 
+    /* drive_enable() attaches the same image again */
+    if (drive->image != image) {
+        drive->image_serial++;
+    }
     drive->image = image;
     drive->image->gcr = drive->gcr;
     drive->image->p64 = (void*)drive->p64;
@@ -196,6 +203,8 @@ int drive_image_detach(disk_image_t *image, unsigned int unit)
     dnr = unit - 8;
     drive = drive_context[dnr]->drive;
 
+    drive_thread_sync();
+
     if (drive->image != NULL) {
         switch (image->type) {
             case DISK_IMAGE_TYPE_D64:
@@ -233,6 +242,7 @@ int drive_image_detach(disk_image_t *image, unsigned int unit)
     drive->P64_image_loaded = 0;
     drive->read_only = 0;
     drive->image = NULL;
+    drive->image_serial++;
     drive_set_half_track(drive->current_half_track, drive->side, drive);
 
     return 0;
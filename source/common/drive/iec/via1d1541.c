@@ -65,6 +65,9 @@ void via1d1541_store(drive_context_t *ctxptr, uint16_t addr, uint8_t data)
 
 uint8_t via1d1541_read(drive_context_t *ctxptr, uint16_t addr)
 {
+    if (viacore_read_is_timed(ctxptr->via1d1541, addr)) {
+        ctxptr->drive->timer_polled = 1;
+    }
     return viacore_read(ctxptr->via1d1541, addr);
 }
 
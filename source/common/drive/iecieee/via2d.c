@@ -128,6 +128,9 @@ void via2d_store(drive_context_t *ctxptr, uint16_t addr, uint8_t data)
 
 uint8_t via2d_read(drive_context_t *ctxptr, uint16_t addr)
 {
+    if (viacore_read_is_timed(ctxptr->via2, addr)) {
+        ctxptr->drive->timer_polled = 1;
+    }
     return viacore_read(ctxptr->via2, addr);
 }
 
@@ -1066,6 +1066,8 @@ void rotation_rotate_disk(drive_t *dptr)
         return;
     }
 
+    dptr->rotation_polled = 1;
+
     if (dptr->complicated_image_loaded) {
         /* stuff that needs complex and slow emulation */
         if (dptr->P64_image_loaded) {
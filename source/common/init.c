@@ -29,6 +29,7 @@
 
 #include "archdep.h"
 #include "attach.h"
+#include "bench.h"
 //#include "cmdline.h"
 #include "console.h"
 #include "debug.h"
@@ -47,6 +48,8 @@
 #include "palette.h"
 #include "ram.h"
 #include "resources.h"
+#include "rewind.h"
+#include "runahead.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "signals.h"
@@ -103,6 +106,20 @@ int init_resources(void)
         init_resource_fail("vsync");
         return -1;
     }
+#ifdef VICE_BENCH
+    if (bench_resources_init() < 0) {
+        init_resource_fail("bench");
+        return -1;
+    }
+#endif
+    if (rewind_resources_init() < 0) {
+        init_resource_fail("rewind");
+        return -1;
+    }
+    if (runahead_resources_init() < 0) {
+        init_resource_fail("run-ahead");
+        return -1;
+    }
     if (sound_resources_init() < 0) {
         init_resource_fail("sound");
         return -1;
@@ -57,6 +57,8 @@
 #include "network.h"
 //#include "printer.h"
 #include "resources.h"
+#include "rewind.h"
+#include "runahead.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "sound.h"
@@ -338,6 +340,9 @@ void machine_shutdown(void)
 
     network_shutdown();
 
+    rewind_shutdown();
+    runahead_shutdown();
+
     autostart_resources_shutdown();
     sound_resources_shutdown();
     video_resources_shutdown();
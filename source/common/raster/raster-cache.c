@@ -33,6 +33,7 @@
 #include "raster-cache.h"
 #include "raster-sprite-status.h"
 
+raster_cache_stats_t raster_cache_stats;
 
 void raster_cache_new(raster_cache_t *cache, raster_sprite_status_t *status)
 {
@@ -62,3 +63,13 @@ void raster_cache_realloc(raster_cache_t **cache, unsigned int screen_height)
 {
     *cache = lib_realloc(*cache, sizeof(raster_cache_t) * screen_height);
 }
+
+void raster_cache_get_stats(raster_cache_stats_t *stats)
+{
+    *stats = raster_cache_stats;
+}
+
+void raster_cache_reset_stats(void)
+{
+    memset(&raster_cache_stats, 0, sizeof(raster_cache_stats));
+}
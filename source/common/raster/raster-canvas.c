@@ -35,6 +35,8 @@
 #include "machine.h"
 #include "raster-canvas.h"
 #include "raster.h"
+#include "screenshot.h"
+#include "video-thread.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -107,10 +109,16 @@ inline static void refresh_canvas(raster_t *raster)
 
 void raster_canvas_handle_end_of_frame(raster_t *raster)
 {
+    uint8_t *draw_buffer;
+
     if (video_disabled_mode) {
         return;
     }
 
+    if (screenshot_is_recording()) {
+        screenshot_record_frame(raster->canvas, raster->skip_frame);
+    }
+
     if (raster->skip_frame) {
         return;
     }
@@ -120,7 +128,13 @@ void raster_canvas_handle_end_of_frame(raster_t *raster)
     }
 
  //   if (raster->dont_cache) {
-        video_canvas_refresh_all(raster->canvas);
+        draw_buffer = raster->canvas->draw_buffer->draw_buffer;
+        video_thread_refresh_frame(raster->canvas);
+        if (raster->canvas->draw_buffer->draw_buffer != draw_buffer) {
+            /* handed to the video thread; the other draw buffer holds an
+               older frame, described by the other cache */
+            raster_swap_cache(raster);
+        }
  //   } else {
  //       refresh_canvas(raster);
  //   }
@@ -82,17 +82,17 @@ inline static int fill_sprite_cache(raster_t *raster, raster_cache_t *cache, uns
             sxe = sprite->x + (sprite->x_expanded ? 48 : 24);
             sxs = sprite->x;
 
+            /* where it was drawn before, which has to be drawn again
+               whatever has changed (the expansion, for one) */
+            if (sprite_cache->visible) {
+                sxe1 = (sprite_cache->x + (sprite_cache->x_expanded ? 48 : 24));
+                sxs1 = sprite_cache->x;
+            } else {
+                sxe1 = sxe;
+                sxs1 = sxs;
+            }
+
             if (sprite->x != sprite_cache->x) {
-                if (sprite_cache->visible) {
-                    sxe1 = (sprite_cache->x + (sprite_cache->x_expanded ? 48 : 24));
-                    sxs1 = sprite_cache->x;
-                    if (sxs1 < sxs) {
-                        sxs = sxs1;
-                    }
-                    if (sxe1 > sxe) {
-                        sxe = sxe1;
-                    }
-                }
                 sprite_cache->x = sprite->x;
                 r = 1;
             }
@@ -140,6 +140,12 @@ inline static int fill_sprite_cache(raster_t *raster, raster_cache_t *cache, uns
             if (r) {
                 unsigned int cxs = 0, cxe = 0;
 
+                if (sxs1 < sxs) {
+                    sxs = sxs1;
+                }
+                if (sxe1 > sxe) {
+                    sxe = sxe1;
+                }
                 if (sxs > 0) {
                     cxs = (unsigned int)sxs;
                 }
@@ -156,7 +162,7 @@ inline static int fill_sprite_cache(raster_t *raster, raster_cache_t *cache, uns
                 unsigned int cxs = 0, cxe = 0;
 
                 sprite_cache->visible = 0;
-                sxe = sprite_cache->x + (sprite_cache->x_expanded ? 24 : 48);
+                sxe = sprite_cache->x + (sprite_cache->x_expanded ? 48 : 24);
 
                 if (sprite_cache->x > 0) {
                     cxs = sprite_cache->x;
@@ -198,6 +204,52 @@ static void draw_sprites_when_cache_enabled(raster_t *raster,
         = raster->sprite_status->sprite_background_collisions;
 }
 
+/* The span from fill_sprite_cache() already covers the whole width of
+   each sprite, 24 or 48 pixels from `x', in the same pixel coordinates
+   the columns are mapped from below (with the X scroll in `gfx_x').  Lines
+   that move a sprite with `x_shift' have changes and are never drawn from
+   the cache.  The VIC-II only draws past the span at the repeat positions
+   near the right edge (see SPRITE_REPEAT_PIXELS_END in vicii-sprites.c),
+   where the last pixel is repeated up to 7 more times, so that much more
+   is drawn again on the right.  */
+#define SPRITE_SPAN_MARGIN  7
+
+/* Widen [`start_char'; `end_char'] to the columns under the pixels
+   [`xs'; `xe'] the sprites changed.  Returns nonzero if it has to be the
+   whole line, as sprites near the right edge may wrap around to the
+   left.  */
+static int sprite_span_to_chars(raster_t *raster,
+                                unsigned int xs, unsigned int xe,
+                                unsigned int *start_char,
+                                unsigned int *end_char)
+{
+    int gfx_x, cs, ce, last;
+
+    if (xe + SPRITE_SPAN_MARGIN >= raster->geometry->screen_size.width) {
+        return 1;
+    }
+
+    gfx_x = (int)raster->geometry->gfx_position.x + raster->xsmooth;
+    last = (int)raster->geometry->text_size.width - 1;
+
+    cs = (int)xs - gfx_x;
+    ce = ((int)xe + SPRITE_SPAN_MARGIN - gfx_x) / 8;
+    cs = (cs < 0) ? 0 : cs / 8;
+    if (ce > last) {
+        ce = last;
+    }
+
+    if (cs <= ce) {
+        if (*start_char > (unsigned int)cs) {
+            *start_char = (unsigned int)cs;
+        }
+        if (*end_char < (unsigned int)ce) {
+            *end_char = (unsigned int)ce;
+        }
+    }
+    return 0;
+}
+
 static int update_for_minor_changes_sprite(raster_t *raster,
                                            unsigned int *changed_start,
                                            unsigned int *changed_end)
@@ -207,7 +259,7 @@ static int update_for_minor_changes_sprite(raster_t *raster,
     unsigned int sprite_changed_start, sprite_changed_end;
     unsigned int changed_start_char, changed_end_char;
     int sprites_need_update;
-    int needs_update;
+    int needs_update, full_line;
 
     video_mode = raster_line_get_real_mode(raster);
 
@@ -219,21 +271,34 @@ static int update_for_minor_changes_sprite(raster_t *raster,
     sprites_need_update = fill_sprite_cache(raster, cache,
                                             &sprite_changed_start,
                                             &sprite_changed_end);
-    /* If sprites have changed, do not bother trying to reduce the amount
-       of recalculated data, but simply redraw everything.  */
+
+    /* If sprites have changed, the graphics under them are drawn again
+       along with the columns that have changed themselves, and then all
+       the sprites over them.  The rest of the line still shows the same
+       graphics and sprites.  */
+    full_line = sprites_need_update
+                && sprite_span_to_chars(raster, sprite_changed_start,
+                                        sprite_changed_end,
+                                        &changed_start_char,
+                                        &changed_end_char);
+
     needs_update = raster_modes_fill_cache(raster->modes,
                                            video_mode,
                                            cache,
                                            &changed_start_char,
                                            &changed_end_char,
-                                           sprites_need_update);
+                                           full_line);
+    needs_update |= sprites_need_update;
 
     if (needs_update) {
-        raster_modes_draw_line_cached(raster->modes,
-                                      video_mode,
-                                      cache,
-                                      changed_start_char,
-                                      changed_end_char);
+        /* no columns if only sprites in the borders have changed */
+        if (changed_start_char <= changed_end_char) {
+            raster_modes_draw_line_cached(raster->modes,
+                                          video_mode,
+                                          cache,
+                                          changed_start_char,
+                                          changed_end_char);
+        }
 
         /* Fill the space between the border and the graphics with the
            background color (necessary if xsmooth is > 0).  */
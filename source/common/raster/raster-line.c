@@ -292,10 +292,30 @@ inline static void fill_background(raster_t *raster)
     }
 }
 
+/* Count a line drawn with the cache enabled, see raster_cache_stats_t.  */
+inline static void count_cached_line(unsigned int video_mode, int major,
+                                     int needs_update,
+                                     unsigned int changed_start,
+                                     unsigned int changed_end)
+{
+    if (video_mode >= RASTER_CACHE_STATS_MODES) {
+        video_mode = RASTER_CACHE_STATS_MODES - 1;
+    }
+    if (major) {
+        raster_cache_stats.misses[video_mode]++;
+    } else if (needs_update) {
+        raster_cache_stats.partial[video_mode]++;
+        raster_cache_stats.partial_pixels += changed_end - changed_start + 1;
+    } else {
+        raster_cache_stats.hits[video_mode]++;
+    }
+}
+
 static void handle_visible_line_with_cache(raster_t *raster)
 {
-    int needs_update;
-    unsigned int changed_start, changed_end;
+    int needs_update, major;
+    unsigned int changed_start = 0, changed_end = 0;
+    unsigned int video_mode;
     raster_cache_t *cache;
 
     cache = &raster->cache[raster->current_line];
@@ -305,7 +325,6 @@ static void handle_visible_line_with_cache(raster_t *raster)
     /* check_for_major_changes_and_update() is embedded here because of some
        VAC++ bug.  */
     {
-        unsigned int video_mode;
         int line;
 
         video_mode = raster_line_get_real_mode(raster);
@@ -381,6 +400,7 @@ static void handle_visible_line_with_cache(raster_t *raster)
             needs_update = 0;
         }
     }
+    major = needs_update;
 
     if (!needs_update) {
         /* There are no `major' changes: try to do some optimization.  */
@@ -389,6 +409,8 @@ static void handle_visible_line_with_cache(raster_t *raster)
                                                 &changed_end);
     }
 
+    count_cached_line(video_mode, major, needs_update, changed_start, changed_end);
+
     if (needs_update) {
         add_line_to_area(raster->update_area, map_current_line_to_area(raster),
                          changed_start, changed_end);
@@ -632,6 +654,7 @@ static void handle_visible_line_with_changes(raster_t *raster)
 inline static void handle_visible_line(raster_t *raster)
 {
     if (raster->changes->have_on_this_line) {
+        raster_cache_stats.uncached++;
         handle_visible_line_with_changes(raster);
     } else {
         if (raster->cache_enabled
@@ -639,6 +662,7 @@ inline static void handle_visible_line(raster_t *raster)
             && !raster->open_right_border) {     /* FIXME: shortcut! */
             handle_visible_line_with_cache(raster);
         } else {
+            raster_cache_stats.uncached++;
             handle_visible_line_without_cache(raster);
         }
     }
@@ -51,6 +51,7 @@
 #include "screenshot.h"
 #include "types.h"
 #include "util.h"
+#include "video-thread.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -80,6 +81,10 @@ static int raster_draw_buffer_alloc(video_canvas_t *canvas,
 
 static void raster_draw_buffer_free(video_canvas_t *canvas)
 {
+    video_thread_sync();
+    lib_free(canvas->draw_buffer->draw_buffer_back);
+    canvas->draw_buffer->draw_buffer_back = NULL;
+
     if (canvas->video_draw_buffer_callback) {
         canvas->video_draw_buffer_callback->draw_buffer_free(canvas, canvas->draw_buffer->draw_buffer);
         return;
@@ -239,6 +244,8 @@ int raster_init(raster_t *raster,
     raster->display_ystart = raster->display_ystop = 0;
 
     raster->cache = NULL;
+    raster->cache_back = NULL;
+    raster->cache_back_lines = 0;
     raster->cache_enabled = 0;
     raster->dont_cache = 1;
     raster->dont_cache_all = 0;
@@ -329,10 +336,29 @@ void raster_mode_change(void)
 }
 
 
+static void raster_free_cache_back(raster_t *raster)
+{
+    unsigned int i;
+
+    if (raster->cache_back == NULL) {
+        return;
+    }
+
+    for (i = 0; i < raster->cache_back_lines; i++) {
+        raster_cache_destroy(&(raster->cache_back)[i], raster->sprite_status);
+    }
+    lib_free(raster->cache_back);
+    raster->cache_back = NULL;
+    raster->cache_back_lines = 0;
+}
+
 void raster_new_cache(raster_t *raster, unsigned int screen_height)
 {
     unsigned int i;
 
+    /* made again when it is next needed */
+    raster_free_cache_back(raster);
+
     for (i = 0; i < screen_height; i++) {
         raster_cache_new(&(raster->cache)[i], raster->sprite_status);
     }
@@ -475,6 +501,46 @@ void raster_force_repaint(raster_t *raster)
 {
     raster->dont_cache = 1;
     raster->num_cached_lines = 0;
+    raster->dont_cache_back = 1;
+    raster->num_cached_lines_back = 0;
+}
+
+/* The draw buffer has been swapped with the other one (see
+   video-thread.c), so swap the cache for the one describing what is in
+   there.  Each buffer keeps being drawn only where its own contents are
+   out of date.  */
+void raster_swap_cache(raster_t *raster)
+{
+    struct raster_cache_s *cache;
+    unsigned int lines = raster->geometry->screen_size.height;
+    unsigned int i, num_cached_lines;
+    int dont_cache;
+
+    if (raster->cache == NULL) {
+        return;
+    }
+
+    if (raster->cache_back == NULL) {
+        raster->cache_back = lib_malloc(sizeof(raster_cache_t) * lines);
+        for (i = 0; i < lines; i++) {
+            raster_cache_new(&(raster->cache_back)[i], raster->sprite_status);
+        }
+        raster->cache_back_lines = lines;
+        raster->dont_cache_back = 1;
+        raster->num_cached_lines_back = 0;
+    }
+
+    cache = raster->cache;
+    raster->cache = raster->cache_back;
+    raster->cache_back = cache;
+
+    dont_cache = raster->dont_cache;
+    raster->dont_cache = raster->dont_cache_back;
+    raster->dont_cache_back = dont_cache;
+
+    num_cached_lines = raster->num_cached_lines;
+    raster->num_cached_lines = raster->num_cached_lines_back;
+    raster->num_cached_lines_back = num_cached_lines;
 }
 
 void raster_set_title(raster_t *raster, const char *name)
@@ -554,6 +620,7 @@ void raster_shutdown(raster_t *raster)
         raster_destroy_cache(raster, raster->geometry->screen_size.height);
         lib_free(raster->cache);
     }
+    raster_free_cache_back(raster);
 
     if (raster->modes) {
         raster_modes_shutdown(raster->modes);
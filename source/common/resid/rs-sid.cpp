@@ -26,6 +26,18 @@
 
 #include "rs-sid.h"
 #include <math.h>
+#include <string.h>
+
+// Vectorized FIR convolution: ARMv6 dual 16 bit multiply-accumulate on the
+// 3DS, SSE2 on x86.  The SMLAD version gives the same output as the plain
+// loop (checked against a C model of the instruction), but its speed on the
+// ARM11 has not been measured; BenchMicro=resid prints both on the 3DS.
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_UNALIGNED) && !defined(WORDS_BIGENDIAN)
+#define RESID_CONVOLVE_SMLAD
+#elif defined(__SSE2__)
+#define RESID_CONVOLVE_SSE2
+#include <emmintrin.h>
+#endif
 
 #ifndef round
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
@@ -860,6 +872,118 @@ int SID::clock_interpolate(cycle_count& delta_t, short* buf, int n, int interlea
 }
 
 
+// ----------------------------------------------------------------------------
+// FIR convolution, 16 bit samples times 16 bit coefficients summed in 32 bits.
+//
+// The vectorized versions add the products in a different order, which
+// gives the same sum as 32 bit sums wrap around; the result is the same as
+// the plain one, bit for bit.
+// ----------------------------------------------------------------------------
+typedef int (*convolve_func)(const short* a, const short* b, int n);
+
+static int convolve_plain(const short* a, const short* b, int n)
+{
+  int out = 0;
+  for (int i = 0; i < n; i++) {
+    out += a[i]*b[i];
+  }
+  return out;
+}
+
+#if defined(RESID_CONVOLVE_SMLAD)
+// Two 16 bit samples in one word, the first one in the lower half.
+static inline unsigned int load_pair(const short* p)
+{
+  unsigned int w;
+  memcpy(&w, p, 4);
+  return w;
+}
+
+// acc + a.lo*b.lo + a.hi*b.hi
+static inline int smlad(unsigned int a, unsigned int b, int acc)
+{
+  int out;
+  __asm__ ("smlad %0, %1, %2, %3" : "=r" (out) : "r" (a), "r" (b), "r" (acc));
+  return out;
+}
+
+static int convolve_simd(const short* a, const short* b, int n)
+{
+  int out0 = 0, out1 = 0;
+  int i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    out0 = smlad(load_pair(a + i), load_pair(b + i), out0);
+    out1 = smlad(load_pair(a + i + 2), load_pair(b + i + 2), out1);
+    out0 = smlad(load_pair(a + i + 4), load_pair(b + i + 4), out0);
+    out1 = smlad(load_pair(a + i + 6), load_pair(b + i + 6), out1);
+  }
+  for (; i < n; i++) {
+    out0 += a[i]*b[i];
+  }
+  return out0 + out1;
+}
+
+static const char* convolve_simd_name = "ARMv6 SMLAD";
+#elif defined(RESID_CONVOLVE_SSE2)
+static int convolve_simd(const short* a, const short* b, int n)
+{
+  __m128i acc = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+  int i, out;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + i)),
+                                            _mm_loadu_si128((const __m128i*)(b + i))));
+    acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + i + 8)),
+                                              _mm_loadu_si128((const __m128i*)(b + i + 8))));
+  }
+  if (i + 8 <= n) {
+    acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(a + i)),
+                                            _mm_loadu_si128((const __m128i*)(b + i))));
+    i += 8;
+  }
+  acc = _mm_add_epi32(acc, acc1);
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  out = _mm_cvtsi128_si32(acc);
+
+  for (; i < n; i++) {
+    out += a[i]*b[i];
+  }
+  return out;
+}
+
+static const char* convolve_simd_name = "SSE2";
+#endif
+
+#if defined(RESID_CONVOLVE_SMLAD) || defined(RESID_CONVOLVE_SSE2)
+static convolve_func convolve = convolve_simd;
+#else
+static convolve_func convolve = convolve_plain;
+#endif
+
+bool SID::enable_simd(bool enable)
+{
+#if defined(RESID_CONVOLVE_SMLAD) || defined(RESID_CONVOLVE_SSE2)
+  convolve = enable ? convolve_simd : convolve_plain;
+  return true;
+#else
+  convolve = convolve_plain;
+  return !enable;
+#endif
+}
+
+const char* SID::convolution_name()
+{
+#if defined(RESID_CONVOLVE_SMLAD) || defined(RESID_CONVOLVE_SSE2)
+  if (convolve == convolve_simd) {
+    return convolve_simd_name;
+  }
+#endif
+  return "plain";
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling - cycle based with audio resampling.
 //
@@ -927,10 +1051,7 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     short* sample_start = sample + sample_index - fir_N - 1 + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+    int v1 = convolve(sample_start, fir_start, fir_N);
 
     // Use next FIR table, wrap around to first FIR table using
     // next sample.
@@ -941,10 +1062,7 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
     fir_start = fir + fir_offset*fir_N;
 
     // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int k = 0; k < fir_N; k++) {
-      v2 += sample_start[k]*fir_start[k];
-    }
+    int v2 = convolve(sample_start, fir_start, fir_N);
 
     // Linear interpolation.
     // fir_offset_rmd is equal for all samples, it can thus be factorized out:
@@ -1002,10 +1120,7 @@ int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int int
     short* sample_start = sample + sample_index - fir_N + RINGSIZE;
 
     // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
-    }
+    int v = convolve(sample_start, fir_start, fir_N);
 
     v >>= FIR_SHIFT;
 
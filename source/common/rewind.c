@@ -0,0 +1,436 @@
+/*
+ * rewind.c - Rewind buffer of in-memory snapshots
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Every "RewindInterval" frames a memory snapshot of the machine is taken
+   and kept in a ring of "RewindDepth" steps.  Every REWIND_KEYFRAME_STEPS
+   steps the snapshot is stored as it is (a keyframe); the steps in between
+   only store the difference to their keyframe, XORed and run length
+   encoded, which for a C64 is a few KB instead of the ~70 KB of a full
+   snapshot.  When the steps and the scratch buffers used to take and
+   restore them use more than "RewindBudget" KB the oldest keyframe and its
+   steps are dropped.
+
+   Disk images, ROMs and settings are not part of the steps; taking one
+   does not write the disk images back (see drive-snapshot.c).  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "bench.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "network.h"
+#include "resources.h"
+#include "rewind.h"
+#include "types.h"
+#include "vsync.h"
+
+typedef struct rewind_step_s {
+    /* the snapshot, or for a delta step its difference to the keyframe */
+    uint8_t *data;
+    size_t size;
+
+    /* size of the snapshot itself */
+    size_t raw_size;
+
+    /* ring index of the keyframe this step is relative to, its own index
+       for a keyframe */
+    int keyframe;
+} rewind_step_t;
+
+static log_t rewind_log = LOG_ERR;
+
+static rewind_step_t *ring = NULL;
+static int ring_first, ring_count;
+static size_t ring_bytes;
+
+/* newest keyframe and the number of steps taken since */
+static int last_keyframe = -1;
+static int keyframe_age;
+
+/* scratch buffers for snapshots and their encoding */
+static uint8_t *snap_buffer = NULL;
+static size_t snap_buffer_size;
+static uint8_t *code_buffer = NULL;
+static size_t code_buffer_size;
+
+static int frame_counter;
+static int step_back_pending;
+
+static rewind_stats_t stats;
+
+/* ------------------------------------------------------------------------- */
+
+static int rewind_enabled;
+static int rewind_interval;
+static int rewind_depth;
+static int rewind_budget;
+
+static int set_rewind_enabled(int val, void *param)
+{
+    rewind_enabled = val ? 1 : 0;
+    if (!rewind_enabled) {
+        rewind_reset();
+    }
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1 || val > 250) {
+        return -1;
+    }
+    rewind_interval = val;
+    return 0;
+}
+
+static int set_rewind_depth(int val, void *param)
+{
+    if (val < REWIND_DEPTH_MIN || val > 3000) {
+        return -1;
+    }
+    if (val != rewind_depth) {
+        rewind_reset();
+    }
+    rewind_depth = val;
+    return 0;
+}
+
+static int set_rewind_budget(int val, void *param)
+{
+    if (val < 256) {
+        return -1;
+    }
+    rewind_budget = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "Rewind", 0, RES_EVENT_NO, NULL,
+      &rewind_enabled, set_rewind_enabled, NULL },
+    { "RewindInterval", 5, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    { "RewindDepth", 100, RES_EVENT_NO, NULL,
+      &rewind_depth, set_rewind_depth, NULL },
+    { "RewindBudget", 2048, RES_EVENT_NO, NULL,
+      &rewind_budget, set_rewind_budget, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void buffer_reserve(uint8_t **buffer, size_t *buffer_size, size_t size)
+{
+    if (*buffer_size < size) {
+        *buffer = lib_realloc(*buffer, size);
+        *buffer_size = size;
+    }
+}
+
+/* The delta of a snapshot is its XOR with the keyframe (bytes past the end
+   of the keyframe taken as 0), encoded as a sequence of
+     0x00-0x7f          followed by 1-128 literal bytes,
+     0x80-0xff, lo      a run of 1-32768 zero bytes.  */
+#define REWIND_CODE_SIZE(size)  ((size) + (size) / 3 + 4)
+
+static size_t delta_encode(uint8_t *out, const uint8_t *cur, size_t size,
+                           const uint8_t *key, size_t key_size)
+{
+    size_t i = 0, n, pos = 0, lit;
+    size_t common = size < key_size ? size : key_size;
+
+#define DELTA(x) ((uint8_t)((x) < common ? cur[x] ^ key[x] : cur[x]))
+
+    while (i < size) {
+        n = 0;
+        while (i + n < common && n < 0x8000 && cur[i + n] == key[i + n]) {
+            n++;
+        }
+        if (i + n >= common) {
+            while (i + n < size && n < 0x8000 && cur[i + n] == 0) {
+                n++;
+            }
+        }
+        if (n >= 2 || (n == 1 && i + 1 == size)) {
+            out[pos++] = (uint8_t)(0x80 | ((n - 1) >> 8));
+            out[pos++] = (uint8_t)((n - 1) & 0xff);
+            i += n;
+            continue;
+        }
+
+        lit = 0;
+        while (i < size && lit < 128) {
+            if (DELTA(i) == 0 && i + 1 < size && DELTA(i + 1) == 0) {
+                break;
+            }
+            out[pos + 1 + lit++] = DELTA(i);
+            i++;
+        }
+        out[pos] = (uint8_t)(lit - 1);
+        pos += 1 + lit;
+    }
+
+#undef DELTA
+
+    return pos;
+}
+
+static void delta_decode(uint8_t *out, size_t size, const uint8_t *code,
+                         size_t code_size, const uint8_t *key, size_t key_size)
+{
+    size_t i = 0, pos = 0, n;
+
+    if (size <= key_size) {
+        memcpy(out, key, size);
+    } else {
+        memcpy(out, key, key_size);
+        memset(out + key_size, 0, size - key_size);
+    }
+
+    while (pos < code_size) {
+        if (code[pos] & 0x80) {
+            i += (((code[pos] & 0x7f) << 8) | code[pos + 1]) + 1;
+            pos += 2;
+        } else {
+            n = code[pos++] + 1;
+            while (n-- > 0) {
+                out[i++] ^= code[pos++];
+            }
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void drop_step(int index)
+{
+    lib_free(ring[index].data);
+    ring[index].data = NULL;
+    ring_bytes -= ring[index].size;
+}
+
+/* Drop the oldest step, together with the steps depending on it.  */
+static void drop_oldest(void)
+{
+    do {
+        if (ring_first == last_keyframe) {
+            last_keyframe = -1;
+        }
+        drop_step(ring_first);
+        ring_first = (ring_first + 1) % rewind_depth;
+        ring_count--;
+    } while (ring_count > 0 && ring[ring_first].keyframe != ring_first);
+}
+
+static void rewind_capture(void)
+{
+    uint64_t start = bench_ticks();
+    rewind_step_t *step;
+    size_t size;
+    int index;
+
+    if (ring == NULL) {
+        ring = lib_calloc(rewind_depth, sizeof(rewind_step_t));
+    }
+    if (rewind_log == LOG_ERR) {
+        rewind_log = log_open("Rewind");
+    }
+
+    if (machine_write_snapshot_memory(&snap_buffer, &size, &snap_buffer_size) < 0) {
+        log_error(rewind_log, "Cannot take snapshot, rewind disabled.");
+        resources_set_int("Rewind", 0);
+        return;
+    }
+
+    if (ring_count == rewind_depth) {
+        drop_oldest();
+    }
+
+    index = (ring_first + ring_count) % rewind_depth;
+    step = &ring[index];
+    step->raw_size = size;
+
+    if (last_keyframe < 0 || keyframe_age >= REWIND_KEYFRAME_STEPS - 1) {
+        step->data = lib_malloc(size);
+        memcpy(step->data, snap_buffer, size);
+        step->size = size;
+        step->keyframe = index;
+        last_keyframe = index;
+        keyframe_age = 0;
+    } else {
+        rewind_step_t *key = &ring[last_keyframe];
+
+        buffer_reserve(&code_buffer, &code_buffer_size, REWIND_CODE_SIZE(size));
+        step->size = delta_encode(code_buffer, snap_buffer, size, key->data, key->raw_size);
+        step->data = lib_malloc(step->size);
+        memcpy(step->data, code_buffer, step->size);
+        step->keyframe = last_keyframe;
+        keyframe_age++;
+    }
+
+    ring_count++;
+    ring_bytes += step->size;
+
+    stats.captures++;
+    stats.raw_bytes += size;
+    stats.stored_bytes += step->size;
+
+    while (ring_bytes + snap_buffer_size + code_buffer_size > (size_t)rewind_budget * 1024
+           && ring_count > 0) {
+        drop_oldest();
+    }
+
+    stats.capture_ticks += bench_ticks() - start;
+}
+
+static void rewind_restore(void)
+{
+    rewind_step_t *step;
+    const uint8_t *data;
+    int index, newest;
+
+    index = (ring_first + ring_count - 1) % rewind_depth;
+    step = &ring[index];
+
+    if (step->keyframe == index) {
+        data = step->data;
+    } else {
+        rewind_step_t *key = &ring[step->keyframe];
+
+        buffer_reserve(&snap_buffer, &snap_buffer_size, step->raw_size);
+        delta_decode(snap_buffer, step->raw_size, step->data, step->size, key->data, key->raw_size);
+        data = snap_buffer;
+    }
+
+    vsync_suspend_speed_eval();
+    if (machine_read_snapshot_memory(data, step->raw_size) < 0) {
+        log_error(rewind_log, "Cannot restore snapshot, rewind disabled.");
+        resources_set_int("Rewind", 0);
+        return;
+    }
+
+    /* the step is used up, the next one goes further back */
+    drop_step(index);
+    ring_count--;
+
+    if (ring_count == 0) {
+        last_keyframe = -1;
+    } else {
+        newest = (ring_first + ring_count - 1) % rewind_depth;
+        last_keyframe = ring[newest].keyframe;
+        keyframe_age = (newest - last_keyframe + rewind_depth) % rewind_depth;
+    }
+}
+
+static void rewind_capture_trap(uint16_t addr, void *data)
+{
+    rewind_capture();
+}
+
+static void rewind_restore_trap(uint16_t addr, void *data)
+{
+    if (ring_count > 0) {
+        rewind_restore();
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+void rewind_vsync(void)
+{
+    if (!rewind_enabled || network_connected()) {
+        return;
+    }
+
+    /* snapshots need the CPU registers, so they are taken from a trap; the
+       machine has only one trap slot, don't overwrite someone else's */
+    if (maincpu_int_status->global_pending_int & IK_TRAP) {
+        return;
+    }
+
+    if (step_back_pending > 0) {
+        step_back_pending--;
+        frame_counter = 0;
+        if (ring_count > 0) {
+            interrupt_maincpu_trigger_trap(rewind_restore_trap, NULL);
+        } else {
+            step_back_pending = 0;
+        }
+        return;
+    }
+
+    if (++frame_counter >= rewind_interval) {
+        frame_counter = 0;
+        interrupt_maincpu_trigger_trap(rewind_capture_trap, NULL);
+    }
+}
+
+void rewind_step_back(void)
+{
+    if (rewind_enabled) {
+        step_back_pending++;
+    }
+}
+
+void rewind_reset(void)
+{
+    if (ring != NULL) {
+        while (ring_count > 0) {
+            drop_oldest();
+        }
+        lib_free(ring);
+        ring = NULL;
+    }
+    ring_first = ring_count = 0;
+    ring_bytes = 0;
+    last_keyframe = -1;
+    keyframe_age = 0;
+    frame_counter = 0;
+    step_back_pending = 0;
+
+    lib_free(snap_buffer);
+    snap_buffer = NULL;
+    snap_buffer_size = 0;
+    lib_free(code_buffer);
+    code_buffer = NULL;
+    code_buffer_size = 0;
+}
+
+void rewind_shutdown(void)
+{
+    rewind_reset();
+}
+
+void rewind_get_stats(rewind_stats_t *s)
+{
+    *s = stats;
+    s->steps = (unsigned int)ring_count;
+    s->bytes = ring_bytes;
+}
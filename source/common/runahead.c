@@ -0,0 +1,247 @@
+/*
+ * runahead.c - Run-ahead input latency reduction
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With "RunAhead" set to N, each frame goes like this:
+
+   - the real frame is emulated with sound but is not drawn, and its vsync
+     reads the input and keeps the speed as usual;
+   - the machine state is saved to memory;
+   - N more frames are emulated with the same input, without sound or
+     synchronization, and only the last one is drawn;
+   - the saved state is restored.
+
+   So what is shown is N frames into the future, which hides N frames of
+   input latency as long as the program doesn't react to input sooner.
+
+   Saving and restoring are done from CPU traps, like the snapshot menu
+   does, so the CPU registers are exported.  Disk images are not part of
+   the state, so writes to a disk done while running ahead are repeated
+   when the real frames get there.  As long as the disks stay in the
+   drives, only the drive CPU, chip and head state is saved and restored
+   (see drive-snapshot.c).  If restoring fails, the machine goes on from
+   wherever it got to and run-ahead is disabled.  */
+
+#include "vice.h"
+
+#include "bench.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "network.h"
+#include "resources.h"
+#include "runahead.h"
+#include "sound.h"
+#include "types.h"
+#include "vice-event.h"
+
+#define RUNAHEAD_MAX_FRAMES     4
+
+#define RUNAHEAD_IDLE           0
+#define RUNAHEAD_SAVING         1
+#define RUNAHEAD_AHEAD          2
+#define RUNAHEAD_RESTORING      3
+
+static log_t runahead_log = LOG_ERR;
+
+static int runahead_state = RUNAHEAD_IDLE;
+
+/* frames to run ahead in this round and the ones done so far */
+static int ahead_frames;
+static int ahead_count;
+
+/* whether the frame to be shown is to be skipped, as decided by vsync */
+static int skip_shown_frame;
+
+/* the saved machine state */
+static uint8_t *state_buffer = NULL;
+static size_t state_size;
+static size_t state_buffer_size;
+
+/* a trap that was pending when ours was triggered */
+static void (*chained_trap_func)(uint16_t, void *) = NULL;
+static void *chained_trap_data;
+
+static uint64_t start_ticks;
+static runahead_stats_t stats;
+
+/* ------------------------------------------------------------------------- */
+
+static int runahead;
+
+static int set_runahead(int val, void *param)
+{
+    if (val < 0 || val > RUNAHEAD_MAX_FRAMES) {
+        return -1;
+    }
+    runahead = val;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RunAhead", 0, RES_EVENT_NO, NULL,
+      &runahead, set_runahead, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int runahead_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+void runahead_shutdown(void)
+{
+    lib_free(state_buffer);
+    state_buffer = NULL;
+    state_buffer_size = 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The machine has only one trap slot; a trap that is already pending is
+   run from ours.  */
+static void runahead_trigger_trap(void (*trap_func)(uint16_t, void *))
+{
+    interrupt_cpu_status_t *cs = maincpu_int_status;
+
+    if (cs->global_pending_int & IK_TRAP) {
+        chained_trap_func = cs->trap_func;
+        chained_trap_data = cs->trap_data;
+    } else {
+        chained_trap_func = NULL;
+    }
+    interrupt_maincpu_trigger_trap(trap_func, NULL);
+}
+
+static void runahead_chained_trap(uint16_t addr)
+{
+    void (*trap_func)(uint16_t, void *) = chained_trap_func;
+
+    if (trap_func != NULL) {
+        chained_trap_func = NULL;
+        trap_func(addr, chained_trap_data);
+    }
+}
+
+static void runahead_save_trap(uint16_t addr, void *data)
+{
+    uint64_t now;
+
+    /* whatever the other trap does (load a snapshot, take a rewind step)
+       belongs to the real frame */
+    runahead_chained_trap(addr);
+
+    start_ticks = bench_ticks();
+
+    if (machine_write_snapshot_memory(&state_buffer, &state_size, &state_buffer_size) < 0) {
+        if (runahead_log == LOG_ERR) {
+            runahead_log = log_open("RunAhead");
+        }
+        log_error(runahead_log, "Cannot save the machine state, run-ahead disabled.");
+        runahead_state = RUNAHEAD_IDLE;
+        resources_set_int("RunAhead", 0);
+        return;
+    }
+    sound_runahead_begin();
+
+    now = bench_ticks();
+    stats.state_ticks += now - start_ticks;
+
+    ahead_count = 0;
+    runahead_state = RUNAHEAD_AHEAD;
+}
+
+static void runahead_restore_trap(uint16_t addr, void *data)
+{
+    uint64_t restore_start = bench_ticks(), now;
+
+    if (machine_read_snapshot_memory(state_buffer, state_size) < 0) {
+        if (runahead_log == LOG_ERR) {
+            runahead_log = log_open("RunAhead");
+        }
+        log_error(runahead_log, "Cannot restore the machine state, run-ahead disabled.");
+        resources_set_int("RunAhead", 0);
+    }
+    sound_runahead_end();
+
+    runahead_state = RUNAHEAD_IDLE;
+
+    now = bench_ticks();
+    stats.frames++;
+    stats.ticks += now - start_ticks;
+    stats.state_ticks += now - restore_start;
+    if (now - start_ticks > stats.max_ticks) {
+        stats.max_ticks = now - start_ticks;
+    }
+
+    runahead_chained_trap(addr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int runahead_vsync(int *skip_next_frame)
+{
+    if (runahead_state != RUNAHEAD_AHEAD) {
+        return 0;
+    }
+
+    ahead_count++;
+    if (ahead_count < ahead_frames) {
+        /* draw only the last one */
+        *skip_next_frame = (ahead_count + 1 < ahead_frames) ? 1 : skip_shown_frame;
+    } else {
+        /* that was the one shown, back to the real frame, which isn't */
+        runahead_state = RUNAHEAD_RESTORING;
+        runahead_trigger_trap(runahead_restore_trap);
+        *skip_next_frame = 1;
+    }
+
+    return 1;
+}
+
+int runahead_frame_done(int skip_next_frame)
+{
+    if (runahead == 0 || runahead_state != RUNAHEAD_IDLE) {
+        return skip_next_frame;
+    }
+
+    /* a reset would be undone by the restore, and events and network
+       play must only see the real frames */
+    if ((maincpu_int_status->global_pending_int & IK_RESET)
+        || network_connected()
+        || event_record_active()
+        || event_playback_active()) {
+        return skip_next_frame;
+    }
+
+    ahead_frames = runahead;
+    skip_shown_frame = skip_next_frame;
+    runahead_state = RUNAHEAD_SAVING;
+    runahead_trigger_trap(runahead_save_trap);
+
+    return (ahead_frames > 1) ? 1 : skip_shown_frame;
+}
+
+void runahead_get_stats(runahead_stats_t *s)
+{
+    *s = stats;
+}
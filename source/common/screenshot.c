@@ -34,7 +34,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "videoarch.h"
+
 //#include "gfxoutput.h"
+#include "bench.h"
 #include "lib.h"
 #include "log.h"
 #include "machine.h"
@@ -42,12 +45,13 @@
 #include "resources.h"
 #include "screenshot.h"
 #include "uiapi.h"
+#include "vice3ds.h"
 #include "video.h"
 
-/*
 static log_t screenshot_log = LOG_ERR;
+
+/*
 static gfxoutputdrv_t *recording_driver;
-static struct video_canvas_s *recording_canvas;
 
 static int reopen = 0;
 static char *reopen_recording_drivername;
@@ -61,9 +65,8 @@ static char *reopen_filename;
  */
 int screenshot_init(void)
 {
-/*
-	// Setup logging system.
     screenshot_log = log_open("Screenshot");
+/*
     recording_driver = NULL;
     recording_canvas = NULL;
 
@@ -78,6 +81,7 @@ int screenshot_init(void)
  */
 void screenshot_shutdown(void)
 {
+    screenshot_stop_recording();
 /*
 	if (reopen_recording_drivername != NULL) {
         lib_free(reopen_recording_drivername);
@@ -187,20 +191,471 @@ static int screenshot_save_core(screenshot_t *screenshot, gfxoutputdrv_t *drv,
 */
 
 /*-----------------------------------------------------------------------*/
+/* Video recording
+
+   There are no graphics output drivers in this port, so recording goes
+   straight to an uncompressed AVI: the frames as 8 bit DIBs holding the
+   draw buffer as it is (palette indices) and the sound as 16 bit PCM.
+
+   The emulation only copies the finished draw buffer into a free slot of
+   a ring at the end of a frame, one memcpy, and the samples written by
+   sound_flush() into a sample ring.  A thread of its own takes them from
+   there and writes the file, so the emulation never waits for the SD
+   card.  If the writer falls behind and no slot is free, the frame is
+   recorded as a repeat of the one before, which keeps the video in step
+   with the sound.
+
+   Each ring has one writer and one reader, and each index is only ever
+   changed by one of them, so no lock is needed.  */
+
+#define RECORD_FRAME_SLOTS      4
+
+/* samples (not frames of samples) in the sound ring, a power of 2 */
+#define RECORD_SOUND_SAMPLES    0x10000
+
+#define RECORD_THREAD_STACKSIZE (32 * 1024)
+#define RECORD_THREAD_PRIORITY  VICE3DS_PRIO_WRITER
+#define RECORD_THREAD_CORE      2
+
+/* An AVI file has to stay below 1 GB, a longer recording is continued in
+   `name-2.avi' and so on.  */
+#define AVI_MAX_SIZE            (1000 * 1024 * 1024)
+
+/* the headers are rewritten at the end, padded to this size */
+#define AVI_HEADER_SIZE         4096
+
+#define AVIF_HASINDEX           0x10
+#define AVIF_ISINTERLEAVED      0x100
+#define AVIIF_KEYFRAME          0x10
+
+typedef struct record_frame_s {
+    /* the displayed lines of the draw buffer */
+    uint8_t *data;
+
+    /* vsyncs before this frame that had no new frame */
+    unsigned int repeats;
+} record_frame_t;
+
+typedef struct avi_file_s {
+    FILE *fd;
+    int part;
+    int error;
+
+    /* bytes in the `movi' list after the fourcc */
+    uint32_t movi_size;
+
+    uint32_t frames;
+    uint32_t sound_bytes;
+    uint32_t max_chunk;
+
+    /* the `idx1' chunk, written at the end */
+    uint8_t *index;
+    uint32_t index_used;
+    uint32_t index_size;
+} avi_file_t;
+
+static struct video_canvas_s *recording_canvas = NULL;
+static char *recording_filename = NULL;
+
+static Thread record_thread = NULL;
+static SDL_sem *record_sem = NULL;
+static int record_quit;
+
+/* geometry of the recorded frames */
+static unsigned int rec_width;
+static unsigned int rec_height;
+static unsigned int rec_x_offset;
+static unsigned int rec_y_offset;
+static unsigned int rec_line_size;
+static uint8_t rec_palette[256 * 4];
+
+/* `frame_head' is advanced by the emulation, `frame_tail' by the writer */
+static record_frame_t frames[RECORD_FRAME_SLOTS];
+static unsigned int frame_head;
+static unsigned int frame_tail;
+static int frame_filled;
+static unsigned int frame_repeats;
+
+/* same for `sound_head' and `sound_tail'; the format is set with the
+   first samples */
+static int16_t *sound_ring = NULL;
+static unsigned int sound_head;
+static unsigned int sound_tail;
+static int sound_channels;
+static int sound_rate;
+
+static avi_file_t avi;
+
+static screenshot_record_stats_t record_stats;
+
+static unsigned int ring_load(unsigned int *index)
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
 
-int screenshot_save(const char *drvname, const char *filename,
-                    struct video_canvas_s *canvas)
+static void ring_store(unsigned int *index, unsigned int value)
 {
-/*
-    screenshot_t screenshot;
-    gfxoutputdrv_t *drv;
-    int result;
-    // printf("screenshot_save(%s, %s, ...)\n", drvname, filename);
-    if ((drv = gfxoutput_get_driver(drvname)) == NULL) {
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *put_le16(uint8_t *p, unsigned int value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_fourcc(uint8_t *p, const char *fourcc)
+{
+    memcpy(p, fourcc, 4);
+    return p + 4;
+}
+
+static void avi_write_header(void)
+{
+    static uint8_t hdr[AVI_HEADER_SIZE];
+    uint8_t *p = hdr;
+    uint32_t frame_size = rec_width * rec_height;
+    uint32_t cycles_per_frame = (uint32_t)machine_get_cycles_per_frame();
+    uint32_t cycles_per_second = (uint32_t)machine_get_cycles_per_second();
+    uint32_t fps = cycles_per_second / cycles_per_frame + 1;
+    unsigned int block_align = sound_channels * 2;
+    uint32_t video_strl = 4 + 8 + 56 + 8 + 40 + 256 * 4;
+    uint32_t audio_strl = 4 + 8 + 56 + 8 + 16;
+    uint32_t hdrl = 4 + 8 + 56 + 8 + video_strl;
+
+    if (sound_channels) {
+        hdrl += 8 + audio_strl;
+    }
+
+    memset(hdr, 0, sizeof(hdr));
+
+    /* the RIFF size is patched in by avi_close() */
+    p = put_fourcc(p, "RIFF");
+    p = put_le32(p, 0);
+    p = put_fourcc(p, "AVI ");
+
+    p = put_fourcc(p, "LIST");
+    p = put_le32(p, hdrl);
+    p = put_fourcc(p, "hdrl");
+
+    p = put_fourcc(p, "avih");
+    p = put_le32(p, 56);
+    p = put_le32(p, (uint32_t)(1000000.0 * cycles_per_frame / cycles_per_second + 0.5));
+    p = put_le32(p, frame_size * fps + sound_rate * block_align);
+    p = put_le32(p, 0);
+    p = put_le32(p, AVIF_HASINDEX | AVIF_ISINTERLEAVED);
+    p = put_le32(p, avi.frames);
+    p = put_le32(p, 0);
+    p = put_le32(p, sound_channels ? 2 : 1);
+    p = put_le32(p, avi.max_chunk);
+    p = put_le32(p, rec_width);
+    p = put_le32(p, rec_height);
+    p += 16;
+
+    /* video stream */
+    p = put_fourcc(p, "LIST");
+    p = put_le32(p, video_strl);
+    p = put_fourcc(p, "strl");
+
+    p = put_fourcc(p, "strh");
+    p = put_le32(p, 56);
+    p = put_fourcc(p, "vids");
+    p = put_fourcc(p, "DIB ");
+    p = put_le32(p, 0);
+    p = put_le16(p, 0);
+    p = put_le16(p, 0);
+    p = put_le32(p, 0);
+    p = put_le32(p, cycles_per_frame);
+    p = put_le32(p, cycles_per_second);
+    p = put_le32(p, 0);
+    p = put_le32(p, avi.frames);
+    p = put_le32(p, frame_size);
+    p = put_le32(p, 0xffffffff);
+    p = put_le32(p, 0);
+    p = put_le16(p, 0);
+    p = put_le16(p, 0);
+    p = put_le16(p, rec_width);
+    p = put_le16(p, rec_height);
+
+    /* BITMAPINFOHEADER, bottom up, with the palette */
+    p = put_fourcc(p, "strf");
+    p = put_le32(p, 40 + 256 * 4);
+    p = put_le32(p, 40);
+    p = put_le32(p, rec_width);
+    p = put_le32(p, rec_height);
+    p = put_le16(p, 1);
+    p = put_le16(p, 8);
+    p = put_le32(p, 0);
+    p = put_le32(p, frame_size);
+    p = put_le32(p, 0);
+    p = put_le32(p, 0);
+    p = put_le32(p, 256);
+    p = put_le32(p, 0);
+    memcpy(p, rec_palette, 256 * 4);
+    p += 256 * 4;
+
+    /* sound stream */
+    if (sound_channels) {
+        p = put_fourcc(p, "LIST");
+        p = put_le32(p, audio_strl);
+        p = put_fourcc(p, "strl");
+
+        p = put_fourcc(p, "strh");
+        p = put_le32(p, 56);
+        p = put_fourcc(p, "auds");
+        p = put_le32(p, 0);
+        p = put_le32(p, 0);
+        p = put_le16(p, 0);
+        p = put_le16(p, 0);
+        p = put_le32(p, 0);
+        p = put_le32(p, block_align);
+        p = put_le32(p, sound_rate * block_align);
+        p = put_le32(p, 0);
+        p = put_le32(p, avi.sound_bytes / block_align);
+        p = put_le32(p, sound_rate * block_align);
+        p = put_le32(p, 0xffffffff);
+        p = put_le32(p, block_align);
+        p += 8;
+
+        /* PCMWAVEFORMAT */
+        p = put_fourcc(p, "strf");
+        p = put_le32(p, 16);
+        p = put_le16(p, 1);
+        p = put_le16(p, sound_channels);
+        p = put_le32(p, sound_rate);
+        p = put_le32(p, sound_rate * block_align);
+        p = put_le16(p, block_align);
+        p = put_le16(p, 16);
+    }
+
+    p = put_fourcc(p, "JUNK");
+    p = put_le32(p, (uint32_t)(AVI_HEADER_SIZE - (p - hdr) - 4));
+
+    fseek(avi.fd, 0, SEEK_SET);
+    fwrite(hdr, 1, AVI_HEADER_SIZE, avi.fd);
+}
+
+static int avi_open(void)
+{
+    uint8_t movi[12];
+    char *name;
+    const char *ext;
+
+    if (avi.part == 0) {
+        name = lib_stralloc(recording_filename);
+    } else {
+        ext = strrchr(recording_filename, '.');
+        if (ext == NULL) {
+            ext = recording_filename + strlen(recording_filename);
+        }
+        name = lib_msprintf("%.*s-%d%s", (int)(ext - recording_filename),
+                            recording_filename, avi.part + 1, ext);
+    }
+
+    avi.fd = fopen(name, "wb");
+    if (avi.fd == NULL) {
+        log_error(screenshot_log, "Cannot open `%s'.", name);
+        lib_free(name);
+        avi.error = 1;
         return -1;
     }
+    lib_free(name);
+
+    avi.movi_size = 0;
+    avi.frames = 0;
+    avi.sound_bytes = 0;
+    avi.max_chunk = 0;
+    avi.index_used = 0;
+
+    avi_write_header();
+
+    /* the list size is patched in by avi_close() */
+    put_fourcc(movi, "LIST");
+    put_le32(movi + 4, 0);
+    put_fourcc(movi + 8, "movi");
+    fwrite(movi, 1, sizeof(movi), avi.fd);
+
+    return 0;
+}
+
+/* Write the chunk header and index entry, the data follows.  */
+static void avi_chunk(const char *fourcc, uint32_t size)
+{
+    uint8_t chunk[8];
+
+    if (avi.index_used + 16 > avi.index_size) {
+        avi.index_size = avi.index_size ? avi.index_size * 2 : 64 * 1024;
+        avi.index = lib_realloc(avi.index, avi.index_size);
+    }
+    put_fourcc(avi.index + avi.index_used, fourcc);
+    put_le32(avi.index + avi.index_used + 4, size ? AVIIF_KEYFRAME : 0);
+    put_le32(avi.index + avi.index_used + 8, avi.movi_size + 4);
+    put_le32(avi.index + avi.index_used + 12, size);
+    avi.index_used += 16;
+
+    put_fourcc(chunk, fourcc);
+    put_le32(chunk + 4, size);
+    fwrite(chunk, 1, sizeof(chunk), avi.fd);
+
+    avi.movi_size += 8 + size;
+    if (size > avi.max_chunk) {
+        avi.max_chunk = size;
+    }
+}
+
+static void avi_close(void)
+{
+    uint8_t size[4];
+    uint8_t idx1[8];
+
+    if (avi.fd == NULL) {
+        return;
+    }
+
+    put_fourcc(idx1, "idx1");
+    put_le32(idx1 + 4, avi.index_used);
+    fwrite(idx1, 1, sizeof(idx1), avi.fd);
+    fwrite(avi.index, 1, avi.index_used, avi.fd);
+
+    avi_write_header();
+
+    put_le32(size, AVI_HEADER_SIZE + 12 + avi.movi_size + 8 + avi.index_used - 8);
+    fseek(avi.fd, 4, SEEK_SET);
+    fwrite(size, 1, sizeof(size), avi.fd);
+
+    put_le32(size, 4 + avi.movi_size);
+    fseek(avi.fd, AVI_HEADER_SIZE + 4, SEEK_SET);
+    fwrite(size, 1, sizeof(size), avi.fd);
+
+    if (ferror(avi.fd)) {
+        avi.error = 1;
+    }
+    if (fclose(avi.fd) != 0) {
+        avi.error = 1;
+    }
+    avi.fd = NULL;
+
+    if (avi.error) {
+        log_error(screenshot_log, "Writing the recording failed.");
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void record_write_sound(void)
+{
+    unsigned int head = ring_load(&sound_head);
+    unsigned int n = head - sound_tail;
+    unsigned int pos = sound_tail & (RECORD_SOUND_SAMPLES - 1);
+    unsigned int part;
+
+    if (n == 0 || avi.fd == NULL) {
+        ring_store(&sound_tail, head);
+        return;
+    }
+
+    part = RECORD_SOUND_SAMPLES - pos;
+    if (part > n) {
+        part = n;
+    }
+
+    avi_chunk("01wb", n * 2);
+    fwrite(sound_ring + pos, 2, part, avi.fd);
+    fwrite(sound_ring, 2, n - part, avi.fd);
+    avi.sound_bytes += n * 2;
+
+    ring_store(&sound_tail, head);
+}
+
+static void record_write_frame(const record_frame_t *frame)
+{
+    uint32_t size = rec_width * rec_height;
+    uint64_t start = bench_ticks();
+    unsigned int i, y;
+
+    if (avi.fd != NULL
+        && AVI_HEADER_SIZE + 12 + avi.movi_size + avi.index_used
+           + (frame->repeats + 1) * (8 + 16) + size + RECORD_SOUND_SAMPLES * 2 + 8 + 16 > AVI_MAX_SIZE) {
+        avi_close();
+        avi.part++;
+        avi_open();
+    }
+    if (avi.fd == NULL) {
+        return;
+    }
+
+    /* an empty chunk repeats the frame before */
+    for (i = 0; i < frame->repeats; i++) {
+        avi_chunk("00db", 0);
+    }
+
+    avi_chunk("00db", size);
+    for (y = rec_height; y-- > 0; ) {
+        fwrite(frame->data + y * rec_line_size + rec_x_offset, 1, rec_width, avi.fd);
+    }
+    avi.frames += frame->repeats + 1;
+
+    record_stats.write_ticks += bench_ticks() - start;
+}
 
-    if (recording_driver == drv) {
+static void record_thread_func(void *data)
+{
+    unsigned int head;
+    int quit;
+
+    while (1) {
+        SDL_SemWait(record_sem);
+
+        /* everything published before the quit is written */
+        quit = __atomic_load_n(&record_quit, __ATOMIC_ACQUIRE);
+        head = ring_load(&frame_head);
+        while (frame_tail != head) {
+            record_write_frame(&frames[frame_tail % RECORD_FRAME_SLOTS]);
+            ring_store(&frame_tail, frame_tail + 1);
+            record_write_sound();
+        }
+        if (quit) {
+            break;
+        }
+    }
+}
+
+static void record_free(void)
+{
+    int i;
+
+    for (i = 0; i < RECORD_FRAME_SLOTS; i++) {
+        lib_free(frames[i].data);
+        frames[i].data = NULL;
+    }
+    lib_free(sound_ring);
+    sound_ring = NULL;
+    lib_free(avi.index);
+    avi.index = NULL;
+    avi.index_size = 0;
+    lib_free(recording_filename);
+    recording_filename = NULL;
+}
+
+static int record_start(const char *filename, struct video_canvas_s *canvas)
+{
+    screenshot_t screenshot;
+    unsigned int i;
+    palette_entry_t *entry;
+
+    if (recording_canvas != NULL) {
         ui_error("Sorry. Multiple recording is not supported.");
         return -1;
     }
@@ -210,25 +665,80 @@ int screenshot_save(const char *drvname, const char *filename,
         return -1;
     }
 
-    if (drv->record != NULL) {
-        recording_driver = drv;
-        recording_canvas = canvas;
-
-        reopen_recording_drivername = lib_stralloc(drvname);
-        reopen_recording_canvas = canvas;
-        reopen_filename = lib_stralloc(filename);
+    rec_width = screenshot.max_width & ~3;
+    rec_height = screenshot.last_displayed_line - screenshot.first_displayed_line + 1;
+    rec_x_offset = screenshot.x_offset;
+    rec_y_offset = screenshot.first_displayed_line;
+    rec_line_size = screenshot.draw_buffer_line_size;
+
+    memset(rec_palette, 0, sizeof(rec_palette));
+    for (i = 0; i < screenshot.palette->num_entries && i < 256; i++) {
+        entry = &screenshot.palette->entries[i];
+        rec_palette[i * 4] = entry->blue;
+        rec_palette[i * 4 + 1] = entry->green;
+        rec_palette[i * 4 + 2] = entry->red;
     }
 
-    result = screenshot_save_core(&screenshot, drv, filename);
+    for (i = 0; i < RECORD_FRAME_SLOTS; i++) {
+        frames[i].data = lib_malloc(rec_height * rec_line_size);
+    }
+    sound_ring = lib_malloc(RECORD_SOUND_SAMPLES * sizeof(int16_t));
+
+    frame_head = frame_tail = 0;
+    frame_filled = 0;
+    frame_repeats = 0;
+    sound_head = sound_tail = 0;
+    sound_channels = 0;
+    sound_rate = 0;
+    memset(&record_stats, 0, sizeof(record_stats));
+
+    memset(&avi, 0, sizeof(avi));
+    recording_filename = lib_stralloc(filename);
+    if (avi_open() < 0) {
+        record_free();
+        return -1;
+    }
 
-    if (result < 0) {
-        recording_driver = NULL;
-        recording_canvas = NULL;
+    record_quit = 0;
+    record_sem = SDL_CreateSemaphore(0);
+    if (record_sem != NULL) {
+        record_thread = threadCreate(record_thread_func, NULL, RECORD_THREAD_STACKSIZE,
+                                     RECORD_THREAD_PRIORITY,
+                                     isN3DS() ? RECORD_THREAD_CORE : -2, false);
     }
-*/
+    if (record_thread == NULL) {
+        log_error(screenshot_log, "Cannot start the recording thread.");
+        if (record_sem != NULL) {
+            SDL_DestroySemaphore(record_sem);
+            record_sem = NULL;
+        }
+        fclose(avi.fd);
+        avi.fd = NULL;
+        record_free();
+        return -1;
+    }
+
+    log_message(screenshot_log, "Recording %ux%u to `%s'.", rec_width, rec_height, filename);
+
+    /* from here on the frame and sound hooks copy */
+    recording_canvas = canvas;
+
     return 0;
 }
 
+/*-----------------------------------------------------------------------*/
+
+int screenshot_save(const char *drvname, const char *filename,
+                    struct video_canvas_s *canvas)
+{
+    if (strcmp(drvname, "AVI") == 0) {
+        return record_start(filename, canvas);
+    }
+
+    log_error(screenshot_log, "No `%s' screenshot driver.", drvname);
+    return -1;
+}
+
 #ifdef FEATURE_CPUMEMHISTORY
 int memmap_screenshot_save(const char *drvname, const char *filename, int x_size, int y_size, uint8_t *gfx, uint8_t *palette)
 {
@@ -250,46 +760,119 @@ int memmap_screenshot_save(const char *drvname, const char *filename, int x_size
 
 int screenshot_record(void)
 {
-/*
-    screenshot_t screenshot;
-
-    if (recording_driver == NULL) {
+    if (recording_canvas == NULL) {
         return 0;
     }
 
-    // Retrive framebuffer and screen geometry.
-    if (recording_canvas != NULL) {
-        if (machine_screenshot(&screenshot, recording_canvas) < 0) {
-            log_error(screenshot_log, "Retrieving screen geometry failed.");
-            return -1;
-        }
+    if (frame_filled) {
+        frames[frame_head % RECORD_FRAME_SLOTS].repeats = frame_repeats;
+        frame_repeats = 0;
+        frame_filled = 0;
+        ring_store(&frame_head, frame_head + 1);
+        SDL_SemPost(record_sem);
+        record_stats.frames++;
     } else {
-        // should not happen
-        log_error(screenshot_log, "Canvas is unknown.");
-        return -1;
+        frame_repeats++;
+        record_stats.repeats++;
     }
 
-    return screenshot_save_core(&screenshot, NULL, NULL);
-*/
-	return 0;
+    return 0;
 }
 
-void screenshot_stop_recording(void)
+void screenshot_record_frame(struct video_canvas_s *canvas, int skipped)
 {
-/*
-    if (recording_driver != NULL && recording_driver->close != NULL) {
-        recording_driver->close(NULL);
+    draw_buffer_t *draw_buffer;
+
+    if (canvas != recording_canvas || skipped) {
+        return;
     }
 
-    recording_driver = NULL;
+    draw_buffer = canvas->draw_buffer;
+    if (draw_buffer->draw_buffer_width != rec_line_size
+        || draw_buffer->draw_buffer_height < rec_y_offset + rec_height) {
+        log_message(screenshot_log, "Screen geometry changed, recording stopped.");
+        screenshot_stop_recording();
+        return;
+    }
+
+    if (frame_head - ring_load(&frame_tail) == RECORD_FRAME_SLOTS) {
+        /* the writer is behind, this one becomes a repeat */
+        record_stats.dropped++;
+        return;
+    }
+
+    memcpy(frames[frame_head % RECORD_FRAME_SLOTS].data,
+           draw_buffer->draw_buffer + rec_y_offset * rec_line_size,
+           rec_height * rec_line_size);
+    frame_filled = 1;
+}
+
+void screenshot_record_sound(const int16_t *samples, int nr, int channels, int rate)
+{
+    unsigned int n, pos, part;
+
+    if (recording_canvas == NULL || nr <= 0) {
+        return;
+    }
+
+    if (sound_channels == 0) {
+        sound_channels = channels;
+        sound_rate = rate;
+    } else if (channels != sound_channels || rate != sound_rate) {
+        record_stats.sound_dropped += nr;
+        return;
+    }
+
+    n = (unsigned int)(nr * channels);
+    if (RECORD_SOUND_SAMPLES - (sound_head - ring_load(&sound_tail)) < n) {
+        record_stats.sound_dropped += nr;
+        return;
+    }
+
+    pos = sound_head & (RECORD_SOUND_SAMPLES - 1);
+    part = RECORD_SOUND_SAMPLES - pos;
+    if (part > n) {
+        part = n;
+    }
+    memcpy(sound_ring + pos, samples, part * sizeof(int16_t));
+    memcpy(sound_ring, samples + part, (n - part) * sizeof(int16_t));
+    ring_store(&sound_head, sound_head + n);
+}
+
+void screenshot_stop_recording(void)
+{
+    if (recording_canvas == NULL) {
+        return;
+    }
     recording_canvas = NULL;
-*/
+
+    __atomic_store_n(&record_quit, 1, __ATOMIC_RELEASE);
+    SDL_SemPost(record_sem);
+    threadJoin(record_thread, U64_MAX);
+    threadFree(record_thread);
+    record_thread = NULL;
+    SDL_DestroySemaphore(record_sem);
+    record_sem = NULL;
+
+    /* the thread is gone, the rest is written from here */
+    record_write_sound();
+    avi_close();
+
+    log_message(screenshot_log, "Recorded %u frames, %u repeated, %u dropped.",
+                record_stats.frames + record_stats.repeats,
+                record_stats.repeats, record_stats.dropped);
+
+    record_free();
 }
 
 int screenshot_is_recording(void)
 {
-	return 0;
-//	return (recording_driver == NULL ? 0 : 1);
+    return recording_canvas != NULL;
+}
+
+void screenshot_record_get_stats(screenshot_record_stats_t *stats)
+{
+    *stats = record_stats;
 }
 
 void screenshot_prepare_reopen(void)
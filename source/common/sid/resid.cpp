@@ -59,7 +59,10 @@ extern "C" {
 extern char *strcpy(char *s1, char *s2);
 #endif
 
+#include <stdio.h>
+
 #include "sid.h" /* sid_engine_t */
+#include "bench.h"
 #include "lib.h"
 #include "log.h"
 #include "resid.h"
@@ -83,25 +86,27 @@ struct sound_s
 
     /* resid sid implementation */
     reSID::SID *sid;
+
+    /* temporary buffer, one per chip as the chips may be rendered on
+       different threads */
+    short *buf;
+    int blen;
 };
 
 typedef struct sound_s sound_t;
 
 /* manage temporary buffers. if the requested size is smaller or equal to the
  * size of the already allocated buffer, reuse it.  */
-static short *buf = NULL;
-static int blen = 0;
-
-static short *getbuf(int len)
+static short *getbuf(sound_t *psid, int len)
 {
-    if ((buf == NULL) || (blen < len)) {
-        if (buf) {
-            lib_free(buf);
+    if ((psid->buf == NULL) || (psid->blen < len)) {
+        if (psid->buf) {
+            lib_free(psid->buf);
         }
-        blen = len;
-        buf = (short *)lib_calloc(len, 1);
+        psid->blen = len;
+        psid->buf = (short *)lib_calloc(len, 1);
     }
-    return buf;
+    return psid->buf;
 }
 
 static sound_t *resid_open(uint8_t *sidstate)
@@ -111,6 +116,8 @@ static sound_t *resid_open(uint8_t *sidstate)
 
     psid = new sound_t;
     psid->sid = new reSID::SID;
+    psid->buf = NULL;
+    psid->blen = 0;
 
     for (i = 0x00; i <= 0x18; i++) {
         psid->sid->write(i, sidstate[i]);
@@ -221,11 +228,11 @@ static int resid_init(sound_t *psid, int speed, int cycles_per_sec, int factor)
         break;
       case 2:
         method = SAMPLE_RESAMPLE;
-        sprintf(method_text, "resampling, pass to %dHz", (int)passband);
+        sprintf(method_text, "resampling, pass to %dHz, %s FIR", (int)passband, reSID::SID::convolution_name());
         break;
       case 3:
         method = SAMPLE_RESAMPLE_FASTMEM;
-        sprintf(method_text, "fast resampling, pass to %dHz", (int)passband);
+        sprintf(method_text, "fast resampling, pass to %dHz, %s FIR", (int)passband, reSID::SID::convolution_name());
         break;
     }
 
@@ -246,13 +253,12 @@ static int resid_init(sound_t *psid, int speed, int cycles_per_sec, int factor)
 
 static void resid_close(sound_t *psid)
 {
+    if (psid->buf) {
+        lib_free(psid->buf);
+    }
+
     delete psid->sid;
     delete psid;
-
-    if (buf) {
-        lib_free(buf);
-        buf = NULL;
-    }
 }
 
 static uint8_t resid_read(sound_t *psid, uint16_t addr)
@@ -279,7 +285,7 @@ static int resid_calculate_samples(sound_t *psid, short *pbuf, int nr,
     if (psid->factor == 1000) {
         return psid->sid->clock(*delta_t, pbuf, nr, interleave);
     }
-    tmp_buf = getbuf(2 * nr * psid->factor / 1000);
+    tmp_buf = getbuf(psid, 2 * nr * psid->factor / 1000);
     retval = psid->sid->clock(*delta_t, tmp_buf, nr * psid->factor / 1000, interleave) * 1000 / psid->factor;
     memcpy(pbuf, tmp_buf, 2 * nr);
     return retval;
@@ -369,6 +375,79 @@ static void resid_state_write(sound_t *psid, sid_snapshot_state_t *sid_state)
     psid->sid->write_state((const reSID::SID::State)state);
 }
 
+#ifdef VICE_BENCH
+#define BENCH_RESID_CLOCK   985248
+#define BENCH_RESID_RATE    44100
+
+/* One SID playing three voices through the filter for one emulated second
+   in every sampling method, the resampling ones with the plain and the
+   vectorized FIR convolution.  */
+void resid_bench(void)
+{
+    static const char * const method_names[4] = { "fast", "interpolate", "resample", "resample_fastmem" };
+    static const sampling_method methods[4] = {
+        SAMPLE_FAST, SAMPLE_INTERPOLATE, SAMPLE_RESAMPLE, SAMPLE_RESAMPLE_FASTMEM
+    };
+    static const uint8_t regs[0x19] = {
+        0x00, 0x1c, 0x00, 0x08, 0x41, 0x09, 0xa0,   /* pulse */
+        0x00, 0x0e, 0x00, 0x00, 0x21, 0x28, 0xc8,   /* sawtooth */
+        0x00, 0x38, 0x00, 0x00, 0x11, 0x00, 0xf4,   /* triangle */
+        0x00, 0x40, 0xf3, 0x1f                      /* low pass filter, full volume */
+    };
+    int len = BENCH_RESID_RATE + 16;
+    short *out[2];
+    double ns[2];
+    int m, k, i, n[2], kernels, identical;
+
+    out[0] = (short *)lib_calloc(len, sizeof(short));
+    out[1] = (short *)lib_calloc(len, sizeof(short));
+
+    for (m = 0; m < 4; m++) {
+        kernels = (methods[m] == SAMPLE_RESAMPLE || methods[m] == SAMPLE_RESAMPLE_FASTMEM)
+                  && reSID::SID::enable_simd(true) ? 2 : 1;
+
+        for (k = 0; k < kernels; k++) {
+            reSID::SID *sid = new reSID::SID;
+            cycle_count delta_t = BENCH_RESID_CLOCK;
+            uint64_t start;
+
+            reSID::SID::enable_simd(k == 1);
+            sid->set_chip_model(MOS6581);
+            sid->set_sampling_parameters(BENCH_RESID_CLOCK, methods[m], BENCH_RESID_RATE);
+            for (i = 0; i < 0x19; i++) {
+                sid->write(i, regs[i]);
+            }
+
+            n[k] = 0;
+            start = bench_ticks();
+            while (delta_t > 0 && n[k] < len) {
+                n[k] += sid->clock(delta_t, out[k] + n[k], len - n[k]);
+            }
+            ns[k] = (double)(bench_ticks() - start) * 1e9 / bench_ticks_per_second();
+            delete sid;
+        }
+        reSID::SID::enable_simd(true);
+
+        if (kernels == 1) {
+            log_message(LOG_DEFAULT, "resid: %-16s %.3f ms per emulated second",
+                        method_names[m], ns[0] / 1e6);
+            printf("BENCH resid method=%s ms_per_second=%.3f samples=%d\n",
+                   method_names[m], ns[0] / 1e6, n[0]);
+            continue;
+        }
+        identical = n[0] == n[1] && !memcmp(out[0], out[1], n[0] * sizeof(short));
+        log_message(LOG_DEFAULT, "resid: %-16s plain %.3f, %s %.3f ms per emulated second%s",
+                    method_names[m], ns[0] / 1e6, reSID::SID::convolution_name(), ns[1] / 1e6,
+                    identical ? "" : ", OUTPUT DIFFERS");
+        printf("BENCH resid method=%s kernel=%s plain_ms_per_second=%.3f simd_ms_per_second=%.3f speedup=%.2f samples=%d identical=%d\n",
+               method_names[m], reSID::SID::convolution_name(), ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1], n[1], identical);
+    }
+
+    lib_free(out[0]);
+    lib_free(out[1]);
+}
+#endif
+
 sid_engine_t resid_hooks =
 {
     resid_open,
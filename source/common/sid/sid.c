@@ -539,6 +539,51 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     return tmp_nr;
 }
 
+int sid_sound_machine_calculate_chip_samples(sound_t *psid, int16_t *pbuf, int nr, int *delta_t)
+{
+    return sid_engine.calculate_samples(psid, pbuf, nr, 1, delta_t);
+}
+
+/* Same mix as sid_sound_machine_calculate_samples(), from one buffer per
+   chip.  */
+void sid_sound_machine_mix_chip_samples(int16_t **chip_buf, int16_t *pbuf, int nr, int soc, int scc)
+{
+    int i;
+
+    if (soc == 1) {
+        for (i = 0; i < nr; i++) {
+            pbuf[i] = (scc == 1) ? chip_buf[0][i] : sound_audio_mix(chip_buf[1][i], chip_buf[0][i]);
+            if (scc >= 3) {
+                pbuf[i] = sound_audio_mix(pbuf[i], chip_buf[2][i]);
+            }
+            if (scc == 4) {
+                pbuf[i] = sound_audio_mix(pbuf[i], chip_buf[3][i]);
+            }
+        }
+        return;
+    }
+
+    for (i = 0; i < nr; i++) {
+        switch (scc) {
+            case 1:
+                pbuf[i * 2] = pbuf[(i * 2) + 1] = chip_buf[0][i];
+                break;
+            case 2:
+                pbuf[i * 2] = chip_buf[0][i];
+                pbuf[(i * 2) + 1] = chip_buf[1][i];
+                break;
+            case 3:
+                pbuf[i * 2] = sound_audio_mix(chip_buf[0][i], chip_buf[2][i]);
+                pbuf[(i * 2) + 1] = sound_audio_mix(chip_buf[1][i], chip_buf[2][i]);
+                break;
+            default:
+                pbuf[i * 2] = sound_audio_mix(chip_buf[0][i], chip_buf[2][i]);
+                pbuf[(i * 2) + 1] = sound_audio_mix(chip_buf[1][i], chip_buf[3][i]);
+                break;
+        }
+    }
+}
+
 void sid_sound_machine_prevent_clk_overflow(sound_t *psid, CLOCK sub)
 {
     sid_engine.prevent_clk_overflow(psid, sub);
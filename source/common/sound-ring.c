@@ -0,0 +1,229 @@
+/*
+ * sound-ring.c - Handing samples to pulling sound devices.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Sound devices with `pull' set in their sound_device_t don't have
+   sound_flush() push samples at them, which had it wait for the device
+   whenever its buffers were full.  The samples go into this ring instead,
+   and the device takes them out with sound_ring_pull() when it needs them,
+   from its own thread or audio callback.
+
+   There is one producer (the emulation, in sound_flush()) and one consumer
+   (the device), so the ring needs no locks: `head' is only advanced by the
+   producer and `tail' only by the consumer, each with a release store
+   after the samples are copied, and read by the other side with an
+   acquire load.
+
+   sound_ring_bufferspace() reports the space below the latency target
+   rather than the free space, so the speed adjustment and vsync delay in
+   sound_flush() keep the ring at about that fill.  The ring itself is
+   twice as large, and only drops samples if more than that is written.  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "sound-ring.h"
+#include "types.h"
+
+typedef struct sound_ring_s {
+    int16_t *buf;
+    unsigned int size;      /* in frames, a power of two */
+    unsigned int target;
+    int channels;
+
+    unsigned int head;
+    unsigned int tail;
+
+    /* the last frame pulled, repeated on underruns */
+    int16_t last[2];
+} sound_ring_t;
+
+static sound_ring_t ring;
+
+static sound_ring_stats_t stats;
+
+static log_t sound_ring_log = LOG_ERR;
+
+static unsigned int ring_load(unsigned int *index)
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static void ring_store(unsigned int *index, unsigned int value)
+{
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/* ------------------------------------------------------------------------- */
+
+int sound_ring_open(int target, int channels, int rate)
+{
+    unsigned int size = 256;
+    int16_t *buf;
+
+    if (sound_ring_log == LOG_ERR) {
+        sound_ring_log = log_open("SoundRing");
+    }
+
+    sound_ring_close();
+
+    if (target < 1 || channels < 1 || channels > 2) {
+        return -1;
+    }
+    while (size < (unsigned int)target * 2) {
+        size <<= 1;
+    }
+
+    ring.size = size;
+    ring.target = (unsigned int)target;
+    ring.channels = channels;
+    ring.head = ring.tail = 0;
+    ring.last[0] = ring.last[1] = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.fill_min = size;
+    stats.size = size;
+    stats.target = ring.target;
+    stats.rate = rate;
+
+    /* the device may already be pulling, it sees the ring from here on */
+    buf = lib_calloc(size * channels, sizeof(int16_t));
+    __atomic_store_n(&ring.buf, buf, __ATOMIC_RELEASE);
+
+    log_message(sound_ring_log, "%u frames, latency target %d ms.",
+                size, (int)(1000.0 * target / rate));
+    return 0;
+}
+
+/* The device must not pull any more.  */
+void sound_ring_close(void)
+{
+    if (ring.buf == NULL) {
+        return;
+    }
+
+    if (stats.pulls > 0) {
+        log_message(sound_ring_log, "%u pulls, %u underruns (%u frames), %u frames dropped, average fill %.1f ms.",
+                    stats.pulls, stats.underruns, stats.underrun_frames, stats.overrun_frames,
+                    1000.0 * stats.fill_sum / stats.pulls / stats.rate);
+    }
+
+    lib_free(ring.buf);
+    ring.buf = NULL;
+}
+
+int sound_ring_write(int16_t *pbuf, size_t nr)
+{
+    unsigned int frames, head, space, pos, part;
+
+    if (ring.buf == NULL) {
+        return -1;
+    }
+
+    frames = (unsigned int)nr / ring.channels;
+    head = ring.head;
+    space = ring.size - (head - ring_load(&ring.tail));
+
+    if (frames > space) {
+        stats.overrun_frames += frames - space;
+        frames = space;
+    }
+
+    pos = head & (ring.size - 1);
+    part = ring.size - pos;
+    if (part > frames) {
+        part = frames;
+    }
+    memcpy(ring.buf + pos * ring.channels, pbuf, part * ring.channels * sizeof(int16_t));
+    memcpy(ring.buf, pbuf + part * ring.channels, (frames - part) * ring.channels * sizeof(int16_t));
+    ring_store(&ring.head, head + frames);
+
+    stats.written += frames;
+    return 0;
+}
+
+int sound_ring_bufferspace(void)
+{
+    unsigned int fill = ring.head - ring_load(&ring.tail);
+
+    return (fill < ring.target) ? (int)(ring.target - fill) : 0;
+}
+
+int sound_ring_pull(int16_t *pbuf, size_t nr)
+{
+    int16_t *buf = __atomic_load_n(&ring.buf, __ATOMIC_ACQUIRE);
+    unsigned int want, tail, fill, frames, pos, part, i;
+    int c;
+
+    if (buf == NULL) {
+        memset(pbuf, 0, nr * sizeof(int16_t));
+        return 0;
+    }
+
+    want = (unsigned int)nr / ring.channels;
+    tail = ring.tail;
+    fill = ring_load(&ring.head) - tail;
+    frames = (want < fill) ? want : fill;
+
+    pos = tail & (ring.size - 1);
+    part = ring.size - pos;
+    if (part > frames) {
+        part = frames;
+    }
+    memcpy(pbuf, buf + pos * ring.channels, part * ring.channels * sizeof(int16_t));
+    memcpy(pbuf + part * ring.channels, buf, (frames - part) * ring.channels * sizeof(int16_t));
+    ring_store(&ring.tail, tail + frames);
+
+    if (frames > 0) {
+        for (c = 0; c < ring.channels; c++) {
+            ring.last[c] = pbuf[(frames - 1) * ring.channels + c];
+        }
+    }
+    for (i = frames; i < want; i++) {
+        for (c = 0; c < ring.channels; c++) {
+            pbuf[i * ring.channels + c] = ring.last[c];
+        }
+    }
+
+    stats.pulls++;
+    stats.pulled += frames;
+    if (frames < want) {
+        stats.underruns++;
+        stats.underrun_frames += want - frames;
+    }
+    if (fill < stats.fill_min) {
+        stats.fill_min = fill;
+    }
+    if (fill > stats.fill_max) {
+        stats.fill_max = fill;
+    }
+    stats.fill_sum += fill;
+
+    return (int)(frames * ring.channels);
+}
+
+void sound_ring_get_stats(sound_ring_stats_t *s)
+{
+    *s = stats;
+}
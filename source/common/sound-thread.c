@@ -0,0 +1,223 @@
+/*
+ * sound-thread.c - Rendering the sound chips on worker threads.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* A small pool of worker threads the sound chips can be rendered on, see
+   sound_queue_flush() in sound.c.  The caller hands out a number of jobs,
+   does its own share of them and then waits for the workers to finish
+   theirs.  Job `j' goes to worker `j % n - 1', where `n' is the number of
+   workers in use plus one, and the jobs for which that is -1 are done by
+   the caller.
+
+   There is one core to spare on the New 3DS, so one worker is started on
+   it; without it everything is done by the calling thread as before.  */
+
+#include "vice.h"
+
+#include "bench.h"
+#include "log.h"
+#include "sound-thread.h"
+#include "types.h"
+#include "vice3ds.h"
+
+#define SOUND_THREAD_WORKERS    1
+
+#define SOUND_THREAD_STACKSIZE  (64 * 1024)
+#define SOUND_THREAD_PRIORITY   VICE3DS_PRIO_SOUND
+#define SOUND_THREAD_CORE       2
+
+typedef struct sound_worker_s {
+    Thread thread;
+    SDL_sem *work_sem;
+    SDL_sem *done_sem;
+
+    /* the first job this worker does */
+    int first;
+} sound_worker_t;
+
+static log_t sound_thread_log = LOG_ERR;
+
+static sound_worker_t workers[SOUND_THREAD_WORKERS];
+
+/* number of workers running */
+static int workers_started = 0;
+
+/* set if the workers could not be started; the jobs then run on the
+   calling thread */
+static int thread_failed = 0;
+
+static int thread_quit = 0;
+
+/* the jobs, written by the calling thread before posting `work_sem' */
+static void (*run_job)(int);
+static int run_jobs;
+static int run_stride;
+
+static sound_thread_stats_t stats;
+
+/* ------------------------------------------------------------------------- */
+
+static void sound_thread_jobs(int first)
+{
+    int j;
+
+    for (j = first; j < run_jobs; j += run_stride) {
+        run_job(j);
+    }
+}
+
+static void sound_thread_func(void *data)
+{
+    sound_worker_t *worker = (sound_worker_t *)data;
+
+    while (1) {
+        SDL_SemWait(worker->work_sem);
+        if (thread_quit) {
+            break;
+        }
+        sound_thread_jobs(worker->first);
+        SDL_SemPost(worker->done_sem);
+    }
+}
+
+static int sound_thread_start(void)
+{
+    sound_worker_t *worker;
+    int i;
+
+    if (sound_thread_log == LOG_ERR) {
+        sound_thread_log = log_open("SoundThread");
+    }
+
+    if (!isN3DS()) {
+        log_message(sound_thread_log, "Needs a New 3DS, sound chips are rendered on the main thread.");
+        return -1;
+    }
+
+    for (i = 0; i < SOUND_THREAD_WORKERS; i++) {
+        worker = &workers[i];
+        worker->first = i + 1;
+        worker->work_sem = SDL_CreateSemaphore(0);
+        worker->done_sem = SDL_CreateSemaphore(0);
+        if (worker->work_sem == NULL || worker->done_sem == NULL) {
+            log_error(sound_thread_log, "Cannot create semaphores.");
+            break;
+        }
+        worker->thread = threadCreate(sound_thread_func, worker, SOUND_THREAD_STACKSIZE,
+                                      SOUND_THREAD_PRIORITY, SOUND_THREAD_CORE, false);
+        if (worker->thread == NULL) {
+            log_error(sound_thread_log, "Cannot start sound thread %d.", i);
+            break;
+        }
+        workers_started++;
+    }
+
+    if (workers_started < SOUND_THREAD_WORKERS) {
+        if (worker->work_sem != NULL) {
+            SDL_DestroySemaphore(worker->work_sem);
+        }
+        if (worker->done_sem != NULL) {
+            SDL_DestroySemaphore(worker->done_sem);
+        }
+        worker->work_sem = worker->done_sem = NULL;
+        sound_thread_shutdown();
+        return -1;
+    }
+
+    log_message(sound_thread_log, "%d sound thread(s) started.", workers_started);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void sound_thread_run(void (*job)(int), int jobs)
+{
+    int i, used;
+    uint64_t start;
+
+    stats.runs++;
+    stats.jobs += jobs;
+
+    if (workers_started == 0 && !thread_failed && jobs > 1) {
+        if (sound_thread_start() < 0) {
+            thread_failed = 1;
+        }
+    }
+
+    used = jobs - 1;
+    if (used > workers_started) {
+        used = workers_started;
+    }
+
+    if (used <= 0) {
+        for (i = 0; i < jobs; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    run_job = job;
+    run_jobs = jobs;
+    run_stride = used + 1;
+    for (i = 0; i < used; i++) {
+        SDL_SemPost(workers[i].work_sem);
+    }
+
+    sound_thread_jobs(0);
+    stats.thread_jobs += jobs - (jobs + used) / run_stride;
+
+    for (i = 0; i < used; i++) {
+        if (SDL_SemTryWait(workers[i].done_sem) != 0) {
+            start = bench_ticks();
+            SDL_SemWait(workers[i].done_sem);
+            stats.waits++;
+            stats.wait_ticks += bench_ticks() - start;
+        }
+    }
+}
+
+void sound_thread_shutdown(void)
+{
+    int i;
+
+    if (workers_started == 0) {
+        return;
+    }
+
+    thread_quit = 1;
+    for (i = 0; i < workers_started; i++) {
+        SDL_SemPost(workers[i].work_sem);
+        threadJoin(workers[i].thread, U64_MAX);
+        threadFree(workers[i].thread);
+        workers[i].thread = NULL;
+
+        SDL_DestroySemaphore(workers[i].work_sem);
+        SDL_DestroySemaphore(workers[i].done_sem);
+        workers[i].work_sem = workers[i].done_sem = NULL;
+    }
+    workers_started = 0;
+    thread_quit = 0;
+}
+
+void sound_thread_get_stats(sound_thread_stats_t *s)
+{
+    *s = stats;
+}
@@ -41,6 +41,7 @@
 #endif
 
 #include "archdep.h"
+#include "bench.h"
 #include "clkguard.h"
 //#include "cmdline.h"
 #include "debug.h"
@@ -51,6 +52,9 @@
 #include "maincpu.h"
 //#include "monitor.h"
 #include "resources.h"
+#include "screenshot.h"
+#include "sound-ring.h"
+#include "sound-thread.h"
 #include "sound.h"
 #include "types.h"
 #include "uiapi.h"
@@ -158,10 +162,12 @@ static sound_register_devices_t sound_register_devices[] = {
        since the list will be searched top-down, and the dummy driver always
        works, no files will be created accidently */
     { "dummy", sound_init_dummy_device, SOUND_PLAYBACK_DEVICE },
-/* 3DS
+    { "nulltimed", sound_init_nulltimed_device, SOUND_PLAYBACK_DEVICE },
+
     { "fs", sound_init_fs_device, SOUND_RECORD_DEVICE },
-    { "dump", sound_init_dump_device, SOUND_RECORD_DEVICE },
     { "wav", sound_init_wav_device, SOUND_RECORD_DEVICE },
+/* 3DS
+    { "dump", sound_init_dump_device, SOUND_RECORD_DEVICE },
     { "voc", sound_init_voc_device, SOUND_RECORD_DEVICE },
     { "iff", sound_init_iff_device, SOUND_RECORD_DEVICE },
     { "aiff", sound_init_aiff_device, SOUND_RECORD_DEVICE },
@@ -518,7 +524,11 @@ static int set_volume(int val, void *param)
 }
 
 static const resource_string_t resources_string[] = {
+#ifdef VICE_BENCH
+    { "SoundDeviceName", "dummy", RES_EVENT_NO, NULL,
+#else
     { "SoundDeviceName", "ndsp", RES_EVENT_NO, NULL,
+#endif
       &device_name, set_device_name, NULL },
     { "SoundDeviceArg", "", RES_EVENT_NO, NULL,
       &device_arg, set_device_arg, NULL },
@@ -529,6 +539,22 @@ static const resource_string_t resources_string[] = {
     RESOURCE_STRING_LIST_END
 };
 
+static int lazy_clock_enabled;
+static int sid_threads_enabled;
+
+/* writes already queued are played by the next sound_run_sound() */
+static int set_lazy_clock_enabled(int val, void *param)
+{
+    lazy_clock_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static int set_sid_threads_enabled(int val, void *param)
+{
+    sid_threads_enabled = val ? 1 : 0;
+    return 0;
+}
+
 static const resource_int_t resources_int[] = {
     { "Sound", 1, RES_EVENT_SAME, NULL,
       (void *)&playback_enabled, set_playback_enabled, NULL },
@@ -546,6 +572,10 @@ static const resource_int_t resources_int[] = {
       (void *)&volume, set_volume, NULL },
     { "SoundOutput", ARCHDEP_SOUND_OUTPUT_MODE, RES_EVENT_NO, NULL,
       (void *)&output_option, set_output_option, NULL },
+    { "SoundLazyClock", 1, RES_EVENT_NO, NULL,
+      (void *)&lazy_clock_enabled, set_lazy_clock_enabled, NULL },
+    { "SoundSidThreads", 0, RES_EVENT_NO, NULL,
+      (void *)&sid_threads_enabled, set_sid_threads_enabled, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -719,6 +749,11 @@ typedef struct {
     /* pointer to playback device structure in use */
     sound_device_t *playdev;
 
+    /* write() and bufferspace() of the playback device, or those of the
+       ring if the device pulls */
+    int (*write)(int16_t *pbuf, size_t nr);
+    int (*bufferspace)(void);
+
     /* pointer to playback device structure in use */
     sound_device_t *recdev;
 
@@ -795,6 +830,213 @@ static void enablesound(void)
     }
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* With "SoundLazyClock" enabled, writes to the SIDs are not played right
+   away but queued with the clock they were made at.  Once the sound is
+   needed (at the end of the frame, or for a read or a write to any other
+   chip) the queue is flushed: every SID plays all of it on its own,
+   running up to the clock of each write and doing those meant for it,
+   into a buffer of its own.  The buffers are then mixed as
+   sound_machine_calculate_samples() would have.
+
+   Each SID is run in the same steps as without the queue, including the
+   stops at the writes to the other SIDs, so the result is the same to the
+   last bit; see sound_queue_bench().  What is saved is the way through
+   sound_run_sound() and the mixing for every write.  Reads still flush
+   the queue, as the SID returns the value last on its bus for the write
+   only registers and OSC3/ENV3 need the voice brought up to date; the
+   pots of the first SID are read without asking the SID.
+
+   The SIDs don't depend on each other, so with "SoundSidThreads" they are
+   rendered in parallel by sound_thread_run().  Dumping sound devices and
+   other sound chips need the writes as they come, and the queue is not
+   used with them.  */
+
+#define SOUND_QUEUE_SIZE 1024
+
+typedef struct sound_queue_entry_s {
+    CLOCK clk;
+    uint16_t addr;
+    uint8_t val;
+    uint8_t chipno;
+} sound_queue_entry_t;
+
+static sound_queue_entry_t sound_queue[SOUND_QUEUE_SIZE];
+static int sound_queue_len = 0;
+
+/* the clock sound_queue_flush() runs the chips to */
+static CLOCK sound_queue_end;
+
+/* a mono buffer for each chip, where each chip renders to (its buffer,
+   or the sound buffer itself if there is nothing to mix), the samples put
+   in it, and whether it overflowed */
+static int16_t *sound_queue_buf[SOUND_SIDS_MAX];
+static int16_t *sound_queue_out[SOUND_SIDS_MAX];
+static int sound_queue_nr[SOUND_SIDS_MAX];
+static int sound_queue_overflow[SOUND_SIDS_MAX];
+
+static int sound_queue_usable(void)
+{
+    int i;
+
+    if ((!lazy_clock_enabled && !sid_threads_enabled) || !cycle_based
+        || !playback_enabled || (suspend_time > 0 && disabletime)
+        || snddata.playdev == NULL || snddata.playdev->dump
+        || sound_calls[0]->calculate_chip_samples == NULL
+        || sound_calls[0]->mix_chip_samples == NULL) {
+        return 0;
+    }
+
+    for (i = 1; i < (offset >> 5); i++) {
+        if (sound_calls[i]->chip_enabled) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Queue a write for sound_store().  Returns 0 if it has to be done right
+   away instead.  */
+static int sound_queue_store(uint16_t addr, uint8_t val, int chipno)
+{
+    sound_queue_entry_t *entry;
+
+    if (addr >= 0x20 || sound_queue_len == SOUND_QUEUE_SIZE || !sound_queue_usable()) {
+        return 0;
+    }
+
+    /* writes to chips that aren't there are queued too, sound_store()
+       would have run the others up to them */
+    entry = &sound_queue[sound_queue_len++];
+    entry->clk = maincpu_clk;
+    entry->addr = addr;
+    entry->val = val;
+    entry->chipno = (uint8_t)chipno;
+    return 1;
+}
+
+/* Play the queue on chip `c', one of the sound_thread_run() jobs.  */
+static void sound_queue_render_chip(int c)
+{
+    sound_t *psid = snddata.psid[c];
+    int16_t *buf = sound_queue_out[c];
+    int space = SOUND_BUFSIZE - snddata.bufptr;
+    CLOCK clk = snddata.lastclk;
+    CLOCK until;
+    int i, nr = 0, delta_t;
+
+    sound_queue_overflow[c] = 0;
+    for (i = 0; i <= sound_queue_len; i++) {
+        until = (i < sound_queue_len) ? sound_queue[i].clk : sound_queue_end;
+        delta_t = until - clk;
+        /* writes in the same cycle: nothing to run */
+        if (delta_t > 0) {
+            nr += sound_calls[0]->calculate_chip_samples(psid, buf + nr, space - nr, &delta_t);
+            if (delta_t) {
+                sound_queue_overflow[c] = 1;
+            }
+        }
+        clk = until;
+        if (i < sound_queue_len && sound_queue[i].chipno == c) {
+            sound_machine_store(psid, sound_queue[i].addr, sound_queue[i].val);
+        }
+    }
+    sound_queue_nr[c] = nr;
+}
+
+/* Play the queued writes and run the chips up to `end', mixing the result
+   into `pbuf'.  Returns the number of samples, and sets `*delta_t' if the
+   buffer overflowed.  */
+static int sound_queue_flush(int16_t *pbuf, CLOCK end, int *delta_t)
+{
+    int c, nr;
+    int scc = snddata.sound_chip_channels;
+
+    if (scc == 1 && snddata.sound_output_channels == 1) {
+        sound_queue_out[0] = pbuf;
+    } else {
+        for (c = 0; c < scc; c++) {
+            if (sound_queue_buf[c] == NULL) {
+                sound_queue_buf[c] = lib_malloc(SOUND_BUFSIZE * sizeof(int16_t));
+            }
+            sound_queue_out[c] = sound_queue_buf[c];
+        }
+    }
+
+    sound_queue_end = end;
+    if (sid_threads_enabled) {
+        sound_thread_run(sound_queue_render_chip, scc);
+    } else {
+        for (c = 0; c < scc; c++) {
+            sound_queue_render_chip(c);
+        }
+    }
+    sound_queue_len = 0;
+
+    /* the last chip calculate_samples() ran had the say */
+    nr = sound_queue_nr[scc > 1 ? 1 : 0];
+    if (sound_queue_out[0] != pbuf) {
+        sound_calls[0]->mix_chip_samples(sound_queue_buf, pbuf, nr,
+                                         snddata.sound_output_channels, scc);
+    }
+
+    *delta_t = 0;
+    for (c = 0; c < scc; c++) {
+        *delta_t |= sound_queue_overflow[c];
+    }
+    return nr;
+}
+
+/* Scale `nr' frames of new samples to the "SoundVolume".  */
+static void sound_apply_volume(int16_t *bufferptr, int nr)
+{
+    int i;
+
+    if (!amp) {
+        memset(bufferptr, 0, nr * snddata.sound_output_channels * sizeof(int16_t));
+    } else if (amp != 4096) {
+        for (i = 0; i < (nr * snddata.sound_output_channels); i++) {
+            bufferptr[i] = bufferptr[i] * amp / 4096;
+        }
+    }
+}
+
+/* Play the queued writes up to the last one, as sound_store() would have
+   done without the queue.  The samples go to the buffer at the volume
+   sound_run_sound() plays them at; after run-ahead they are dropped
+   again.  */
+static void sound_queue_catch_up(void)
+{
+    int16_t *bufferptr;
+    int delta_t, nr;
+    CLOCK end;
+
+    if (sound_queue_len == 0) {
+        return;
+    }
+
+    end = sound_queue[sound_queue_len - 1].clk;
+    bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+    nr = sound_queue_flush(bufferptr, end, &delta_t);
+    sound_apply_volume(bufferptr, nr);
+    snddata.bufptr += nr;
+    snddata.lastclk = end;
+}
+
+static void sound_queue_discard(void)
+{
+    int c;
+
+    sound_queue_len = 0;
+    sound_thread_shutdown();
+
+    for (c = 0; c < SOUND_SIDS_MAX; c++) {
+        lib_free(sound_queue_buf[c]);
+        sound_queue_buf[c] = NULL;
+    }
+}
+
 /* close sid device and show error dialog */
 static int sound_error(const char *msg)
 {
@@ -866,7 +1108,7 @@ static void fill_buffer(int size, int rise)
         }
     }
 
-    i = snddata.playdev->write(p, size * snddata.sound_output_channels);
+    i = snddata.write(p, size * snddata.sound_output_channels);
     if (i) {
         sound_error("write to sound device failed (1)");
     }
@@ -1062,6 +1304,17 @@ int sound_open(void)
         snddata.fragnr = fragnr;
         snddata.bufsize = fragsize * fragnr;
         snddata.bufptr = 0;
+        if (pdev->pull) {
+            if (sound_ring_open(snddata.bufsize, snddata.sound_output_channels, speed) < 0) {
+                sound_error("cannot set up the sound ring.");
+                return 1;
+            }
+            snddata.write = sound_ring_write;
+            snddata.bufferspace = sound_ring_bufferspace;
+        } else {
+            snddata.write = pdev->write;
+            snddata.bufferspace = pdev->bufferspace;
+        }
         /* log_message isn't guarenteed to handle "%f" */
         sprintf(frag_str, "%.1f", (1000.0 * fragsize / speed));
         log_message(sound_log,
@@ -1078,9 +1331,9 @@ int sound_open(void)
         sid_state_changed = FALSE;
 
         /* Fill up the sound hardware buffer. */
-        if (pdev->bufferspace) {
+        if (snddata.bufferspace) {
             /* Fill to bufsize - fragsize. */
-            j = pdev->bufferspace() - snddata.fragsize;
+            j = snddata.bufferspace() - snddata.fragsize;
             if (j > 0) {
                 /* Whole fragments. */
                 j -= j % snddata.fragsize;
@@ -1154,6 +1407,10 @@ void sound_close(void)
         }
         snddata.playdev = NULL;
     }
+    /* the device has stopped pulling */
+    sound_ring_close();
+    snddata.write = NULL;
+    snddata.bufferspace = NULL;
 
     if (snddata.recdev) {
         log_message(sound_log, "Closing recording device `%s'", snddata.recdev->name);
@@ -1163,6 +1420,7 @@ void sound_close(void)
         snddata.recdev = NULL;
     }
 
+    sound_queue_discard();
     sid_close();
 
     snddata.prevused = snddata.prevfill = 0;
@@ -1204,12 +1462,18 @@ static int sound_run_sound(void)
     if (cycle_based) {
         delta_t = maincpu_clk - snddata.lastclk;
         bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
-        nr = sound_machine_calculate_samples(snddata.psid,
-                                             bufferptr,
-                                             SOUND_BUFSIZE - snddata.bufptr,
-                                             snddata.sound_output_channels,
-                                             snddata.sound_chip_channels,
-                                             &delta_t);
+        BENCH_ENTER(BENCH_SOUND);
+        if (sound_queue_len > 0) {
+            nr = sound_queue_flush(bufferptr, maincpu_clk, &delta_t);
+        } else {
+            nr = sound_machine_calculate_samples(snddata.psid,
+                                                 bufferptr,
+                                                 SOUND_BUFSIZE - snddata.bufptr,
+                                                 snddata.sound_output_channels,
+                                                 snddata.sound_chip_channels,
+                                                 &delta_t);
+        }
+        BENCH_LEAVE(BENCH_SOUND);
         if (delta_t) {
             if (overflow_warning_count < 25) {
                 log_warning(sound_log, "%s", "Sound buffer overflow (cycle based)");
@@ -1236,22 +1500,18 @@ static int sound_run_sound(void)
 //#endif
         }
         bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+        BENCH_ENTER(BENCH_SOUND);
         sound_machine_calculate_samples(snddata.psid,
                                         bufferptr,
                                         nr,
                                         snddata.sound_output_channels,
                                         snddata.sound_chip_channels,
                                         &delta_t);
+        BENCH_LEAVE(BENCH_SOUND);
         snddata.fclk += nr * snddata.clkstep;
     }
 
-    if (!amp) {
-		memset(bufferptr, 0, nr * snddata.sound_output_channels * sizeof(int16_t));
-	} else if (amp != 4096) {
-		for (i = 0; i < (nr * snddata.sound_output_channels); i++) {
-			bufferptr[i] = bufferptr[i] * amp / 4096;
-		}
-	}
+    sound_apply_volume(bufferptr, nr);
 
     snddata.bufptr += nr;
     snddata.lastclk = maincpu_clk;
@@ -1264,6 +1524,8 @@ void sound_reset(void)
 {
     int c;
 
+    sound_queue_catch_up();
+
     snddata.fclk = SOUNDCLK_CONSTANT(maincpu_clk);
     snddata.wclk = maincpu_clk;
     snddata.lastclk = maincpu_clk;
@@ -1282,6 +1544,9 @@ static void prevent_clk_overflow_callback(CLOCK sub, void *data)
     snddata.lastclk -= sub;
     snddata.fclk -= SOUNDCLK_CONSTANT(sub);
     snddata.wclk -= sub;
+    for (c = 0; c < sound_queue_len; c++) {
+        sound_queue[c].clk -= sub;
+    }
     for (c = 0; c < snddata.sound_chip_channels; c++) {
         if (snddata.psid[c]) {
             sound_machine_prevent_clk_overflow(snddata.psid[c], sub);
@@ -1351,8 +1616,8 @@ double sound_flush()
     }
 
     /* adjust speed */
-    if (snddata.playdev->bufferspace) {
-        space = snddata.playdev->bufferspace();
+    if (snddata.bufferspace) {
+        space = snddata.bufferspace();
         if (space < 0 || space > snddata.bufsize) {
             log_warning(sound_log, "fragment problems %d %d", space, snddata.bufsize);
             sound_error("fragment problems.");
@@ -1442,7 +1707,7 @@ double sound_flush()
 
     if (nr) {
         /* Flush buffer, all channels are already mixed into it. */
-        if (snddata.playdev->write(snddata.buffer, nr * snddata.sound_output_channels)) {
+        if (snddata.write(snddata.buffer, nr * snddata.sound_output_channels)) {
             // this happens a lot on 3ds
             // do not show an error but rather re-init sound
             // sound_error("write to sound device failed (2)");
@@ -1457,6 +1722,8 @@ double sound_flush()
                 return 0;
             }
         }
+
+        screenshot_record_sound(snddata.buffer, nr, snddata.sound_output_channels, sample_rate);
     }
 
     /* "No Limit" speed support: nuke the accumulated buffer. */
@@ -1474,7 +1741,7 @@ double sound_flush()
         }
     }
 
-    if (snddata.playdev->bufferspace
+    if (snddata.bufferspace
         && (cycle_based || speed_adjustment_setting == SOUND_ADJUST_EXACT))
     {
         /* finetune VICE timer */
@@ -1482,7 +1749,7 @@ double sound_flush()
            of getting interrupted before vsync delay calculation. */
         /* Aim for utilization of bufsize - fragsize. */
         int remspace =
-            snddata.playdev->bufferspace() - snddata.bufptr;
+            snddata.bufferspace() - snddata.bufptr;
         /* Return delay in seconds. */
         return (double)remspace / sample_rate;
     }
@@ -1497,11 +1764,11 @@ void sound_suspend(void)
         return;
     }
 
-    if (snddata.playdev->write && !snddata.issuspended
+    if (snddata.write && !snddata.issuspended
         && snddata.playdev->need_attenuation) {
         /* fill buffer, but avoid overwriting */
-        if (!snddata.playdev->bufferspace
-            || snddata.playdev->bufferspace() >= snddata.fragsize) {
+        if (!snddata.bufferspace
+            || snddata.bufferspace() >= snddata.fragsize) {
             fill_buffer(snddata.fragsize, -1);
         } else {
             log_warning(sound_log, "Buffer full during suspend");
@@ -1534,7 +1801,7 @@ void sound_resume(void)
             snddata.issuspended = 0;
         }
 
-        if (snddata.playdev->write && !snddata.issuspended
+        if (snddata.write && !snddata.issuspended
             && snddata.playdev->need_attenuation) {
             fill_buffer(snddata.fragsize, 1);
         }
@@ -1616,6 +1883,10 @@ void sound_store(uint16_t addr, uint8_t val, int chipno)
 {
     int i;
 
+    if (sound_queue_store(addr, val, chipno)) {
+        return;
+    }
+
     if (sound_run_sound()) {
         return;
     }
@@ -1668,9 +1939,142 @@ void sound_snapshot_prepare(void)
 
 void sound_snapshot_finish(void)
 {
+    /* writes made while loading, as if they had been played right away */
+    sound_queue_catch_up();
     snddata.lastclk = maincpu_clk;
 }
 
+static int runahead_bufptr;
+static soundclk_t runahead_fclk;
+static CLOCK runahead_wclk;
+static CLOCK runahead_lastclk;
+
+void sound_runahead_begin(void)
+{
+    sound_run_sound();
+
+    runahead_bufptr = snddata.bufptr;
+    runahead_fclk = snddata.fclk;
+    runahead_wclk = snddata.wclk;
+    runahead_lastclk = snddata.lastclk;
+}
+
+void sound_runahead_end(void)
+{
+    sound_queue_catch_up();
+
+    if (snddata.bufptr > runahead_bufptr) {
+        snddata.bufptr = runahead_bufptr;
+    }
+    snddata.fclk = runahead_fclk;
+    snddata.wclk = runahead_wclk;
+    snddata.lastclk = runahead_lastclk;
+}
+
+#ifdef VICE_BENCH
+
+#define BENCH_QUEUE_FRAMES  100
+#define BENCH_QUEUE_WRITES  25
+#define BENCH_QUEUE_CYCLES  19656
+
+/* Play BENCH_QUEUE_FRAMES frames of made up writes to freshly opened SIDs
+   and put the samples in `out'.  `mode' is 0 to play every write right
+   away, 1 to queue them and 2 to queue them and use the sound threads.
+   Returns the number of samples, or -1.  */
+static int sound_queue_bench_run(int mode, int16_t *out, int len, double *ns)
+{
+    CLOCK base = maincpu_clk;
+    uint32_t seed = 1;
+    uint16_t addr;
+    uint8_t val;
+    uint64_t start;
+    int f, w, nr, n = 0;
+
+    lazy_clock_enabled = (mode == 1);
+    sid_threads_enabled = (mode == 2);
+
+    sid_close();
+    if (sid_open() != 0 || sid_init() != 0) {
+        return -1;
+    }
+    snddata.bufptr = 0;
+
+    start = bench_ticks();
+    for (f = 0; f < BENCH_QUEUE_FRAMES; f++) {
+        for (w = 0; w < BENCH_QUEUE_WRITES; w++) {
+            seed = seed * 1103515245 + 12345;
+            addr = (uint16_t)((seed >> 16) % 0x19);
+            val = (uint8_t)(seed >> 24);
+            if (addr == 0x18) {
+                val |= 0x0f;
+            }
+            maincpu_clk = base + f * BENCH_QUEUE_CYCLES
+                          + w * (BENCH_QUEUE_CYCLES / BENCH_QUEUE_WRITES) + ((seed >> 8) & 63);
+            sound_store(addr, val, (int)((seed >> 4) % snddata.sound_chip_channels));
+        }
+        maincpu_clk = base + (f + 1) * BENCH_QUEUE_CYCLES;
+        sound_run_sound();
+
+        nr = snddata.bufptr * snddata.sound_output_channels;
+        if (n + nr <= len) {
+            memcpy(out + n, snddata.buffer, nr * sizeof(int16_t));
+        }
+        n += nr;
+        snddata.bufptr = 0;
+    }
+    *ns = (double)(bench_ticks() - start) * 1e9 / bench_ticks_per_second();
+
+    maincpu_clk = base;
+    return n;
+}
+
+void sound_queue_bench(void)
+{
+    int lazy = lazy_clock_enabled, threads = sid_threads_enabled;
+    int len = BENCH_QUEUE_FRAMES * 2048 * SOUND_CHANNELS_MAX;
+    int16_t *out[3];
+    double ns[3];
+    int n[3], identical[3];
+    int m, modes;
+
+    if (sound_run_sound() != 0 || !cycle_based) {
+        log_message(sound_log, "sidqueue: needs sound and a cycle based SID engine.");
+        printf("BENCH sidqueue skipped=1\n");
+        return;
+    }
+
+    modes = (snddata.sound_chip_channels > 1) ? 3 : 2;
+    for (m = 0; m < modes; m++) {
+        out[m] = lib_malloc(len * sizeof(int16_t));
+        n[m] = sound_queue_bench_run(m, out[m], len, &ns[m]);
+        identical[m] = n[m] > 0 && n[m] <= len && n[m] == n[0]
+                       && !memcmp(out[m], out[0], n[m] * sizeof(int16_t));
+    }
+
+    lazy_clock_enabled = lazy;
+    sid_threads_enabled = threads;
+    sid_close();
+    sid_open();
+    sid_init();
+
+    log_message(sound_log, "sidqueue: %d SID(s), direct %.3f ms, queued %.3f ms%s",
+                snddata.sound_chip_channels, ns[0] / 1e6, ns[1] / 1e6,
+                identical[1] ? "" : ", OUTPUT DIFFERS");
+    printf("BENCH sidqueue chips=%d writes=%d direct_ms=%.3f queued_ms=%.3f speedup=%.2f samples=%d identical=%d",
+           snddata.sound_chip_channels, BENCH_QUEUE_FRAMES * BENCH_QUEUE_WRITES,
+           ns[0] / 1e6, ns[1] / 1e6, ns[0] / ns[1], n[0], identical[1]);
+    if (modes > 2) {
+        printf(" threads_ms=%.3f threads_identical=%d", ns[2] / 1e6, identical[2]);
+    }
+    printf("\n");
+
+    for (m = 0; m < modes; m++) {
+        lib_free(out[m]);
+    }
+}
+
+#endif
+
 void sound_dac_init(sound_dac_t *dac, int speed)
 {
     /* 20 dB/Decade high pass filter, cutoff at 5 Hz. For DC offset filtering. */
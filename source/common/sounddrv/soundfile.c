@@ -0,0 +1,346 @@
+/*
+ * soundfile.c - WAV and raw PCM file sound devices.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The "wav" and "fs" (raw PCM in host byte order) devices write the
+   samples to a file, named by the device argument.  write() only copies
+   them into a ring, and a thread of its own does the file I/O, so a slow
+   SD card never holds up the emulation.  If the thread falls behind by
+   more than the ring holds the newest samples are dropped (and counted).
+
+   Both can be used for recording or as the playback device; played back
+   from a headless run the file can be compared with that of an earlier
+   one to find changes in the generated sound.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "sound.h"
+#include "types.h"
+#include "vice3ds.h"
+
+/* samples (not frames), a power of two: about 3 s of 44.1 kHz stereo */
+#define FILE_RING_SAMPLES       0x40000
+
+#define FILE_THREAD_STACKSIZE   (16 * 1024)
+#define FILE_THREAD_PRIORITY    VICE3DS_PRIO_WRITER
+#define FILE_THREAD_CORE        2
+
+#define WAV_HEADER_SIZE         44
+
+typedef struct sound_file_s {
+    /* set for the "wav" device */
+    int wav;
+    const char *default_name;
+
+    FILE *fd;
+    char *name;
+    int speed;
+    int channels;
+
+    /* sample bytes written to the file, for the WAV header */
+    uint32_t bytes;
+
+    /* `head' is advanced by write(), `tail' by the thread */
+    int16_t *ring;
+    unsigned int head;
+    unsigned int tail;
+    unsigned int dropped;
+
+    Thread thread;
+    SDL_sem *sem;
+    int quit;
+} sound_file_t;
+
+static sound_file_t wav_file = { 1, "vicesnd.wav" };
+static sound_file_t fs_file = { 0, "vicesnd.raw" };
+
+static log_t sound_file_log = LOG_ERR;
+
+static unsigned int ring_load(unsigned int *index)
+{
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static void ring_store(unsigned int *index, unsigned int value)
+{
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+static uint8_t *put_le16(uint8_t *p, unsigned int value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+    return p + 4;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void file_write_header(sound_file_t *file)
+{
+    uint8_t header[WAV_HEADER_SIZE], *p = header;
+
+    memcpy(p, "RIFF", 4);
+    p = put_le32(p + 4, WAV_HEADER_SIZE - 8 + file->bytes);
+    memcpy(p, "WAVEfmt ", 8);
+    p = put_le32(p + 8, 16);
+    p = put_le16(p, 1);     /* PCM */
+    p = put_le16(p, file->channels);
+    p = put_le32(p, file->speed);
+    p = put_le32(p, file->speed * file->channels * 2);
+    p = put_le16(p, file->channels * 2);
+    p = put_le16(p, 16);
+    memcpy(p, "data", 4);
+    put_le32(p + 4, file->bytes);
+
+    fseek(file->fd, 0, SEEK_SET);
+    fwrite(header, 1, WAV_HEADER_SIZE, file->fd);
+    fseek(file->fd, 0, SEEK_END);
+}
+
+/* write what is in the ring to the file */
+static void file_write_ring(sound_file_t *file)
+{
+    unsigned int head = ring_load(&file->head);
+    unsigned int n = head - file->tail;
+    unsigned int pos = file->tail & (FILE_RING_SAMPLES - 1);
+    unsigned int part = FILE_RING_SAMPLES - pos;
+
+    if (n == 0) {
+        return;
+    }
+    if (part > n) {
+        part = n;
+    }
+    fwrite(file->ring + pos, sizeof(int16_t), part, file->fd);
+    fwrite(file->ring, sizeof(int16_t), n - part, file->fd);
+    file->bytes += n * sizeof(int16_t);
+
+    ring_store(&file->tail, head);
+}
+
+static void file_thread_func(void *data)
+{
+    sound_file_t *file = (sound_file_t *)data;
+    int quit;
+
+    while (1) {
+        SDL_SemWait(file->sem);
+
+        /* everything written before the quit goes into the file */
+        quit = __atomic_load_n(&file->quit, __ATOMIC_ACQUIRE);
+        file_write_ring(file);
+        if (quit) {
+            break;
+        }
+    }
+}
+
+static void file_free(sound_file_t *file)
+{
+    if (file->sem != NULL) {
+        SDL_DestroySemaphore(file->sem);
+        file->sem = NULL;
+    }
+    if (file->fd != NULL) {
+        fclose(file->fd);
+        file->fd = NULL;
+    }
+    lib_free(file->ring);
+    file->ring = NULL;
+    lib_free(file->name);
+    file->name = NULL;
+}
+
+static int file_init(sound_file_t *file, const char *param, int *speed, int *channels)
+{
+    if (sound_file_log == LOG_ERR) {
+        sound_file_log = log_open("SoundFile");
+    }
+
+    file->name = lib_stralloc(param ? param : file->default_name);
+    file->fd = fopen(file->name, "wb");
+    if (file->fd == NULL) {
+        log_error(sound_file_log, "Cannot create `%s'.", file->name);
+        file_free(file);
+        return -1;
+    }
+
+    file->speed = *speed;
+    file->channels = *channels;
+    file->bytes = 0;
+    file->head = file->tail = 0;
+    file->dropped = 0;
+    file->quit = 0;
+    file->ring = lib_malloc(FILE_RING_SAMPLES * sizeof(int16_t));
+
+    if (file->wav) {
+        file_write_header(file);
+    }
+
+    file->sem = SDL_CreateSemaphore(0);
+    if (file->sem != NULL) {
+        file->thread = threadCreate(file_thread_func, file, FILE_THREAD_STACKSIZE,
+                                    FILE_THREAD_PRIORITY,
+                                    isN3DS() ? FILE_THREAD_CORE : -2, false);
+    }
+    if (file->thread == NULL) {
+        log_error(sound_file_log, "Cannot start the writer thread.");
+        file_free(file);
+        return -1;
+    }
+
+    log_message(sound_file_log, "Writing %s to `%s'.", file->wav ? "WAV" : "raw PCM", file->name);
+    return 0;
+}
+
+static int file_write(sound_file_t *file, int16_t *pbuf, size_t nr)
+{
+    unsigned int head = file->head;
+    unsigned int space = FILE_RING_SAMPLES - (head - ring_load(&file->tail));
+    unsigned int n = (unsigned int)nr;
+    unsigned int pos, part;
+
+    if (n > space) {
+        /* whole frames only */
+        space -= space % file->channels;
+        file->dropped += n - space;
+        n = space;
+    }
+
+    pos = head & (FILE_RING_SAMPLES - 1);
+    part = FILE_RING_SAMPLES - pos;
+    if (part > n) {
+        part = n;
+    }
+    memcpy(file->ring + pos, pbuf, part * sizeof(int16_t));
+    memcpy(file->ring, pbuf + part, (n - part) * sizeof(int16_t));
+    ring_store(&file->head, head + n);
+
+    SDL_SemPost(file->sem);
+    return 0;
+}
+
+static void file_close(sound_file_t *file)
+{
+    if (file->thread == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&file->quit, 1, __ATOMIC_RELEASE);
+    SDL_SemPost(file->sem);
+    threadJoin(file->thread, U64_MAX);
+    threadFree(file->thread);
+    file->thread = NULL;
+
+    if (file->wav) {
+        file_write_header(file);
+    }
+
+    log_message(sound_file_log, "Wrote %u bytes to `%s', %u samples dropped.",
+                file->bytes, file->name, file->dropped);
+    file_free(file);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int wav_init(const char *param, int *speed, int *fragsize, int *fragnr, int *channels)
+{
+    return file_init(&wav_file, param, speed, channels);
+}
+
+static int wav_write(int16_t *pbuf, size_t nr)
+{
+    return file_write(&wav_file, pbuf, nr);
+}
+
+static void wav_close(void)
+{
+    file_close(&wav_file);
+}
+
+static sound_device_t wav_device =
+{
+    "wav",
+    wav_init,
+    wav_write,
+    NULL,
+    NULL,
+    NULL,
+    wav_close,
+    NULL,
+    NULL,
+    0,
+    2
+};
+
+int sound_init_wav_device(void)
+{
+    return sound_register_device(&wav_device);
+}
+
+static int fs_init(const char *param, int *speed, int *fragsize, int *fragnr, int *channels)
+{
+    return file_init(&fs_file, param, speed, channels);
+}
+
+static int fs_write(int16_t *pbuf, size_t nr)
+{
+    return file_write(&fs_file, pbuf, nr);
+}
+
+static void fs_close(void)
+{
+    file_close(&fs_file);
+}
+
+static sound_device_t fs_device =
+{
+    "fs",
+    fs_init,
+    fs_write,
+    NULL,
+    NULL,
+    NULL,
+    fs_close,
+    NULL,
+    NULL,
+    0,
+    2
+};
+
+int sound_init_fs_device(void)
+{
+    return sound_register_device(&fs_device);
+}
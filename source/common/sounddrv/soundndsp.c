@@ -24,11 +24,26 @@
 #include "vice.h"
 #include "log.h"
 #include "sound.h"
+#include "sound-ring.h"
 #include <string.h>
 #include <3ds.h>
 
 #define CHANNEL 0x08
-#define WAVBUFNR 10
+#define WAVBUFNR 4
+
+/* The DSP calls ndsp_callback() every few milliseconds from its own
+   thread.  Every wave buffer it has finished playing is then refilled
+   from the sound ring and queued again, so the emulation never waits for
+   the DSP.  WAVBUFNR buffers of WAVBUFFRAMES frames are queued at a time,
+   which is the latency of the DSP side on top of the ring.  */
+#define WAVBUFFRAMES 256
+
+/* ndspSetCallback(NULL, NULL) does not wait for a callback that is
+   already running, so the callback holds callback_lock while it touches
+   the wave buffers and the ring, and ndsp_close() takes it before freeing
+   either.  A callback that comes in after that sees ndsp_isinit cleared
+   and returns.  */
+static LightLock callback_lock;
 
 bool		ndsp_isinit = false;
 bool		ndsp_svc_isinit = false;
@@ -37,6 +52,23 @@ int			ndsp_bufsize = 0;
 int			ndsp_activeBuf = 0;
 ndspWaveBuf	ndsp_waveBuf[WAVBUFNR];
 
+/* refill and queue the wave buffers the DSP is done with */
+static void ndsp_callback(void *data)
+{
+	LightLock_Lock(&callback_lock);
+	while (ndsp_isinit && ndsp_waveBuf[ndsp_activeBuf].status == NDSP_WBUF_DONE)
+	{
+		ndspWaveBuf *buf = &ndsp_waveBuf[ndsp_activeBuf];
+
+		sound_ring_pull(buf->data_pcm16, ndsp_bufsize);
+		buf->nsamples = WAVBUFFRAMES;
+		DSP_FlushDataCache(buf->data_pcm16, ndsp_bufsize * sizeof(int16_t));
+		ndspChnWaveBufAdd(CHANNEL, buf);
+		ndsp_activeBuf = (ndsp_activeBuf + 1) % WAVBUFNR;
+	}
+	LightLock_Unlock(&callback_lock);
+}
+
 /* init-routine to be called at device initialization. Should use
    suggested values if possible or return new values if they cannot be
    used */
@@ -48,11 +80,12 @@ static int ndsp_init(const char *param, int *speed, int *fragsize, int *fragnr,
 	if (!ndsp_svc_isinit) {
 		if(ndspInit() < 0) return -1;
 		atexit(ndspExit);
+		LightLock_Init(&callback_lock);
 		ndsp_svc_isinit = true;
 	}
 	if (*channels > 2 || *channels < 1) return -1;
 	ndsp_channels = *channels;
-	ndsp_bufsize = (*fragsize) * (*fragnr);
+	ndsp_bufsize = WAVBUFFRAMES * ndsp_channels;
 	
 	ndsp_activeBuf = 0;
 	memset(ndsp_waveBuf, 0, sizeof(ndsp_waveBuf));
@@ -73,32 +106,10 @@ static int ndsp_init(const char *param, int *speed, int *fragsize, int *fragnr,
 			*channels == 2 ? NDSP_FORMAT_STEREO_PCM16 :
 			NDSP_FORMAT_MONO_PCM16);
 	ndsp_isinit = true;
+	ndspSetCallback(ndsp_callback, NULL);
     return 0;
 }
 
-#define MAXTRY 500
-/* send number of bytes to the soundcard. it is assumed to block if kernel buffer is full */
-static int ndsp_write(int16_t *pbuf, size_t nr)
-{
-//log_3ds("enter %s: %d samples", __func__, nr);
-	int count=0;
-	// block until the active buffer is done playing
-	while (ndsp_waveBuf[ndsp_activeBuf].status != NDSP_WBUF_DONE)
-	{
-		if (++count > MAXTRY) return -1;
-		svcSleepThread(1000 * 1000); // 1/1000 second
-	}
-
-	// set and queue a new buffer
-	memcpy((void *)ndsp_waveBuf[ndsp_activeBuf].data_vaddr, pbuf, nr * sizeof(int16_t));
-	ndsp_waveBuf[ndsp_activeBuf].nsamples = nr / ndsp_channels;
-	ndspChnWaveBufAdd(CHANNEL, &ndsp_waveBuf[ndsp_activeBuf]);
-//	DSP_FlushDataCache(ndsp_waveBuf[ndsp_activeBuf].data_vaddr, nr * sizeof(int16_t));
-	ndsp_activeBuf = (ndsp_activeBuf + 1) % WAVBUFNR;
-
-	return 0;
-}
-
 static int ndsp_suspend()
 {
 //log_3ds("enter %s",__func__);
@@ -118,12 +129,18 @@ static void ndsp_close(void)
 //log_3ds("enter %s",__func__);
 	if(ndsp_isinit == true)
 	{
+		/* wait for a running callback before the ring and the wave
+		   buffers go */
+		LightLock_Lock(&callback_lock);
+		ndspSetCallback(NULL, NULL);
+		ndsp_isinit = false;
+		LightLock_Unlock(&callback_lock);
+
 		ndspChnWaveBufClear(CHANNEL);
 		for (int i = 0 ; i < WAVBUFNR ; i++ )
 		{
 			linearFree((void *)ndsp_waveBuf[i].data_vaddr);
 		}
-		ndsp_isinit = false;
 	}
 }
 
@@ -138,7 +155,7 @@ static sound_device_t ndsp_device =
 	ndsp_init,
     // send number of bytes to the soundcard. it is assumed to block if kernel buffer is full 
     // int (*write)(int16_t *pbuf, size_t nr);
-    ndsp_write,
+    NULL,
     // dump-routine to be called for every write to SID 
     //int (*dump)(uint16_t addr, uint8_t byte, CLOCK clks);
     NULL,
@@ -162,7 +179,10 @@ static sound_device_t ndsp_device =
     0,
     // maximum amount of channels 
     // int max_channels;
-	2
+	2,
+    // takes the samples from the sound ring
+    // int pull;
+    1
 };
 
 int sound_init_ndsp_device(void)
@@ -0,0 +1,148 @@
+/*
+ * soundtimed.c - Sound device that takes the samples in real time and drops them.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The "nulltimed" device plays nothing, but a thread of its own takes the
+   samples from the sound ring at the rate a real device would.  Without
+   sound hardware (benchmarks, headless runs) the emulation is then paced
+   by the sound as usual, and the ring's fill level and underruns (see
+   "BENCH soundring") show how well the sound keeps up.  */
+
+#include "vice.h"
+
+#include "bench.h"
+#include "lib.h"
+#include "log.h"
+#include "sound-ring.h"
+#include "sound.h"
+#include "types.h"
+#include "vice3ds.h"
+
+/* frames taken at a time */
+#define TIMED_CHUNK             256
+
+#define TIMED_THREAD_STACKSIZE  (16 * 1024)
+#define TIMED_THREAD_PRIORITY   VICE3DS_PRIO_TIMED_SOUND
+#define TIMED_THREAD_CORE       2
+
+static Thread thread = NULL;
+static int thread_quit;
+
+/* set while suspended; the clock starts over on resume */
+static int paused;
+static int restart;
+
+static int timed_speed;
+static int timed_channels;
+
+static void timed_thread_func(void *data)
+{
+    int16_t *buf = lib_malloc(TIMED_CHUNK * 2 * sizeof(int16_t));
+    uint64_t tps = bench_ticks_per_second();
+    uint64_t start = bench_ticks(), now, due;
+    uint64_t frames = 0;
+
+    while (!__atomic_load_n(&thread_quit, __ATOMIC_ACQUIRE)) {
+        if (__atomic_exchange_n(&restart, 0, __ATOMIC_ACQ_REL)) {
+            start = bench_ticks();
+            frames = 0;
+        }
+        if (__atomic_load_n(&paused, __ATOMIC_ACQUIRE)) {
+            svcSleepThread(10 * 1000 * 1000);
+            continue;
+        }
+
+        due = start + frames * tps / timed_speed;
+        now = bench_ticks();
+        if (now < due) {
+            svcSleepThread((due - now) * 1000000000ULL / tps);
+            continue;
+        }
+
+        sound_ring_pull(buf, TIMED_CHUNK * timed_channels);
+        frames += TIMED_CHUNK;
+    }
+
+    lib_free(buf);
+}
+
+static int timed_init(const char *param, int *speed, int *fragsize, int *fragnr, int *channels)
+{
+    timed_speed = *speed;
+    timed_channels = *channels;
+    thread_quit = 0;
+    paused = 0;
+    restart = 0;
+
+    thread = threadCreate(timed_thread_func, NULL, TIMED_THREAD_STACKSIZE,
+                          TIMED_THREAD_PRIORITY, isN3DS() ? TIMED_THREAD_CORE : -2, false);
+    if (thread == NULL) {
+        log_error(LOG_DEFAULT, "nulltimed: cannot start the thread.");
+        return -1;
+    }
+    return 0;
+}
+
+static void timed_close(void)
+{
+    if (thread == NULL) {
+        return;
+    }
+
+    __atomic_store_n(&thread_quit, 1, __ATOMIC_RELEASE);
+    threadJoin(thread, U64_MAX);
+    threadFree(thread);
+    thread = NULL;
+}
+
+static int timed_suspend(void)
+{
+    __atomic_store_n(&paused, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int timed_resume(void)
+{
+    __atomic_store_n(&restart, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&paused, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static sound_device_t timed_device =
+{
+    "nulltimed",
+    timed_init,
+    NULL,       /* write, pulls instead */
+    NULL,       /* dump */
+    NULL,       /* flush */
+    NULL,       /* bufferspace, pulls instead */
+    timed_close,
+    timed_suspend,
+    timed_resume,
+    0,          /* need attenuation */
+    2,          /* max channels */
+    1           /* pulls */
+};
+
+int sound_init_nulltimed_device(void)
+{
+    return sound_register_device(&timed_device);
+}
@@ -148,6 +148,21 @@ void store_pixel_YVYU(uint8_t *trg, int32_t y1_, int32_t u1, int32_t v1, int32_t
     trg[3] = (uint8_t)(u1 + 128);
 }
 
+/* With less than 16 colours on a line, the sums of the y, u and v tables
+   the renderer needs for each pixel are looked up from the tables made by
+   render_1x1_pal_update_tables(), indexed by the last four colours seen.
+   The sums are the same, so is the picture.  Lines with other colours are
+   rendered the long way.  */
+static inline int pal_lut_line_ok(const uint8_t *src, unsigned int n)
+{
+    uint8_t colors = 0;
+
+    while (n--) {
+        colors |= *src++;
+    }
+    return (colors & 0xf0) == 0;
+}
+
 /* PAL 1x1 renderers */
 static inline void
 render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *src, uint8_t *trg,
@@ -165,12 +180,14 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     const int32_t *crtable = color_tab->crtable;
     const int32_t *ytablel = color_tab->ytablel;
     const int32_t *ytableh = color_tab->ytableh;
+    const int32_t *ytable3 = color_tab->ytable3;
+    const int32_t *uvpair, *p0, *p1;
     const uint8_t *tmpsrc;
     uint8_t *tmptrg;
-    unsigned int x, y;
+    unsigned int x, y, win;
     int32_t *line, l1, l2, u1, u2, v1, v2, unew, vnew;
     uint8_t cl0, cl1, cl2, cl3;
-    int off, off_flip;
+    int off, off_flip, lut = color_tab->pal_lut_updated;
 
     /* ensure starting on even coords */
     if ((xt & 1) && xs > 0) {
@@ -189,21 +206,36 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     if (ys & 1) {
         cbtable = yuvtarget ? color_tab->cutable : color_tab->cbtable;
         crtable = yuvtarget ? color_tab->cvtable : color_tab->crtable;
+        uvpair = yuvtarget ? color_tab->cuvpair : color_tab->cbcrpair;
     } else {
         cbtable = yuvtarget ? color_tab->cutable_odd : color_tab->cbtable_odd;
         crtable = yuvtarget ? color_tab->cvtable_odd : color_tab->crtable_odd;
+        uvpair = yuvtarget ? color_tab->cuvpair_odd : color_tab->cbcrpair_odd;
     }
 
     /* prepare previous (delay-)line */
-    for (x = 0; x < width; x++) {
-        cl0 = tmpsrc[0];
-        cl1 = tmpsrc[1];
-        cl2 = tmpsrc[2];
-        cl3 = tmpsrc[3];
-        tmpsrc += 1;
-        line[0] = (cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3]);
-        line[1] = (crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3]);
-        line += 2;
+    if (lut && pal_lut_line_ok(tmpsrc, width + 3)) {
+        win = (tmpsrc[0] << 8) | (tmpsrc[1] << 4) | tmpsrc[2];
+        for (x = 0; x < width; x++) {
+            win = ((win << 4) | tmpsrc[3]) & 0xffff;
+            tmpsrc += 1;
+            p0 = uvpair + ((win >> 8) << 1);
+            p1 = uvpair + ((win & 0xff) << 1);
+            line[0] = p0[0] + p1[0];
+            line[1] = p0[1] + p1[1];
+            line += 2;
+        }
+    } else {
+        for (x = 0; x < width; x++) {
+            cl0 = tmpsrc[0];
+            cl1 = tmpsrc[1];
+            cl2 = tmpsrc[2];
+            cl3 = tmpsrc[3];
+            tmpsrc += 1;
+            line[0] = (cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3]);
+            line[1] = (crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3]);
+            line += 2;
+        }
     }
 
     width >>= 1;
@@ -221,44 +253,82 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
             off_flip = off;
             cbtable = yuvtarget ? color_tab->cutable_odd : color_tab->cbtable_odd;
             crtable = yuvtarget ? color_tab->cvtable_odd : color_tab->crtable_odd;
+            uvpair = yuvtarget ? color_tab->cuvpair_odd : color_tab->cbcrpair_odd;
         } else {
             off_flip = 1 << 5;
             cbtable = yuvtarget ? color_tab->cutable : color_tab->cbtable;
             crtable = yuvtarget ? color_tab->cvtable : color_tab->crtable;
+            uvpair = yuvtarget ? color_tab->cuvpair : color_tab->cbcrpair;
         }
 
-        /* one scanline */
-        for (x = 0; x < width; x++) {
-            cl0 = tmpsrc[0];
-            cl1 = tmpsrc[1];
-            cl2 = tmpsrc[2];
-            cl3 = tmpsrc[3];
-            tmpsrc += 1;
-            l1 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
-            u1 = (unew + line[0]) * off_flip;
-            v1 = (vnew + line[1]) * off_flip;
-            line[0] = unew;
-            line[1] = vnew;
-            line += 2;
-
-            cl0 = tmpsrc[0];
-            cl1 = tmpsrc[1];
-            cl2 = tmpsrc[2];
-            cl3 = tmpsrc[3];
-            tmpsrc += 1;
-            l2 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
-            unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
-            vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
-            u2 = (unew + line[0]) * off_flip;
-            v2 = (vnew + line[1]) * off_flip;
-            line[0] = unew;
-            line[1] = vnew;
-            line += 2;
-
-            store_func(tmptrg, l1, u1, v1, l2, u2, v2);
-            tmptrg += pixelstride;
+        if (lut && pal_lut_line_ok(tmpsrc, (width << 1) + 3)) {
+            win = (tmpsrc[0] << 8) | (tmpsrc[1] << 4) | tmpsrc[2];
+
+            /* one scanline */
+            for (x = 0; x < width; x++) {
+                win = ((win << 4) | tmpsrc[3]) & 0xffff;
+                tmpsrc += 1;
+                p0 = uvpair + ((win >> 8) << 1);
+                p1 = uvpair + ((win & 0xff) << 1);
+                l1 = ytable3[win & 0xfff];
+                unew = p0[0] + p1[0];
+                vnew = p0[1] + p1[1];
+                u1 = (unew + line[0]) * off_flip;
+                v1 = (vnew + line[1]) * off_flip;
+                line[0] = unew;
+                line[1] = vnew;
+                line += 2;
+
+                win = ((win << 4) | tmpsrc[3]) & 0xffff;
+                tmpsrc += 1;
+                p0 = uvpair + ((win >> 8) << 1);
+                p1 = uvpair + ((win & 0xff) << 1);
+                l2 = ytable3[win & 0xfff];
+                unew = p0[0] + p1[0];
+                vnew = p0[1] + p1[1];
+                u2 = (unew + line[0]) * off_flip;
+                v2 = (vnew + line[1]) * off_flip;
+                line[0] = unew;
+                line[1] = vnew;
+                line += 2;
+
+                store_func(tmptrg, l1, u1, v1, l2, u2, v2);
+                tmptrg += pixelstride;
+            }
+        } else {
+            /* one scanline */
+            for (x = 0; x < width; x++) {
+                cl0 = tmpsrc[0];
+                cl1 = tmpsrc[1];
+                cl2 = tmpsrc[2];
+                cl3 = tmpsrc[3];
+                tmpsrc += 1;
+                l1 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
+                unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
+                vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+                u1 = (unew + line[0]) * off_flip;
+                v1 = (vnew + line[1]) * off_flip;
+                line[0] = unew;
+                line[1] = vnew;
+                line += 2;
+
+                cl0 = tmpsrc[0];
+                cl1 = tmpsrc[1];
+                cl2 = tmpsrc[2];
+                cl3 = tmpsrc[3];
+                tmpsrc += 1;
+                l2 = ytablel[cl1] + ytableh[cl2] + ytablel[cl3];
+                unew = cbtable[cl0] + cbtable[cl1] + cbtable[cl2] + cbtable[cl3];
+                vnew = crtable[cl0] + crtable[cl1] + crtable[cl2] + crtable[cl3];
+                u2 = (unew + line[0]) * off_flip;
+                v2 = (vnew + line[1]) * off_flip;
+                line[0] = unew;
+                line[1] = vnew;
+                line += 2;
+
+                store_func(tmptrg, l1, u1, v1, l2, u2, v2);
+                tmptrg += pixelstride;
+            }
         }
 
         src += pitchs;
@@ -266,6 +336,30 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     }
 }
 
+void render_1x1_pal_update_tables(video_render_color_tables_t *color_tab)
+{
+    unsigned int a, b, c, i;
+
+    for (a = 0; a < 16; a++) {
+        for (b = 0; b < 16; b++) {
+            i = ((a << 4) | b) << 1;
+            color_tab->cbcrpair[i] = color_tab->cbtable[a] + color_tab->cbtable[b];
+            color_tab->cbcrpair[i + 1] = color_tab->crtable[a] + color_tab->crtable[b];
+            color_tab->cbcrpair_odd[i] = color_tab->cbtable_odd[a] + color_tab->cbtable_odd[b];
+            color_tab->cbcrpair_odd[i + 1] = color_tab->crtable_odd[a] + color_tab->crtable_odd[b];
+            color_tab->cuvpair[i] = color_tab->cutable[a] + color_tab->cutable[b];
+            color_tab->cuvpair[i + 1] = color_tab->cvtable[a] + color_tab->cvtable[b];
+            color_tab->cuvpair_odd[i] = color_tab->cutable_odd[a] + color_tab->cutable_odd[b];
+            color_tab->cuvpair_odd[i + 1] = color_tab->cvtable_odd[a] + color_tab->cvtable_odd[b];
+            for (c = 0; c < 16; c++) {
+                color_tab->ytable3[(a << 8) | (b << 4) | c] =
+                    color_tab->ytablel[a] + color_tab->ytableh[b] + color_tab->ytablel[c];
+            }
+        }
+    }
+    color_tab->pal_lut_updated = 1;
+}
+
 void
 render_UYVY_1x1_pal(video_render_color_tables_t *color_tab,
                     const uint8_t *src, uint8_t *trg,
@@ -0,0 +1,437 @@
+/*
+ * rendersimd.c - Word parallel 1x1, 2x2 and scale2x renderers
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* These produce exactly the same output as the renderers in render1x1.c,
+   render2x2.c and renderscale2x.c, but work on whole words: four source
+   pixels are fetched with one load, two 16 bit pixels are packed into one
+   store, and scale2x decides both target pixels of a source pixel at once.
+   They need a little endian CPU that can access words at any address, see
+   video_render_main() for when they are used.  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "rendersimd.h"
+#include "types.h"
+
+/* unaligned word access, a single instruction where the CPU allows it */
+static inline uint32_t load_word(const uint8_t *p)
+{
+    uint32_t w;
+
+    memcpy(&w, p, 4);
+    return w;
+}
+
+static inline void store_word(uint8_t *p, uint32_t w)
+{
+    memcpy(p, &w, 4);
+}
+
+static inline void store_half(uint8_t *p, uint32_t w)
+{
+    uint16_t h = (uint16_t)w;
+
+    memcpy(p, &h, 2);
+}
+
+/* two 16 bit pixels in one word, the first one at the lower address */
+#define PACK16(c0, c1) (((c0) & 0xffff) | ((c1) << 16))
+
+/* ------------------------------------------------------------------------- */
+/* 1x1 */
+
+void render_16_1x1_simd(const video_render_color_tables_t *color_tab, const uint8_t *src, uint8_t *trg,
+                        unsigned int width, const unsigned int height,
+                        const unsigned int xs, const unsigned int ys,
+                        const unsigned int xt, const unsigned int yt,
+                        const unsigned int pitchs, const unsigned int pitcht)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    const uint8_t *tmpsrc;
+    uint8_t *tmptrg;
+    unsigned int x, y;
+    uint32_t w;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 1);
+    for (y = 0; y < height; y++) {
+        tmpsrc = src;
+        tmptrg = trg;
+        for (x = 0; x + 4 <= width; x += 4) {
+            w = load_word(tmpsrc);
+            store_word(tmptrg, PACK16(colortab[w & 0xff], colortab[(w >> 8) & 0xff]));
+            store_word(tmptrg + 4, PACK16(colortab[(w >> 16) & 0xff], colortab[w >> 24]));
+            tmpsrc += 4;
+            tmptrg += 8;
+        }
+        for (; x < width; x++) {
+            store_half(tmptrg, colortab[*tmpsrc++]);
+            tmptrg += 2;
+        }
+        src += pitchs;
+        trg += pitcht;
+    }
+}
+
+void render_32_1x1_simd(const video_render_color_tables_t *color_tab, const uint8_t *src, uint8_t *trg,
+                        unsigned int width, const unsigned int height,
+                        const unsigned int xs, const unsigned int ys,
+                        const unsigned int xt, const unsigned int yt,
+                        const unsigned int pitchs, const unsigned int pitcht)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    const uint8_t *tmpsrc;
+    uint32_t *tmptrg;
+    unsigned int x, y;
+    uint32_t w;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 2);
+    for (y = 0; y < height; y++) {
+        tmpsrc = src;
+        tmptrg = (uint32_t *)trg;
+        for (x = 0; x + 8 <= width; x += 8) {
+            w = load_word(tmpsrc);
+            tmptrg[0] = colortab[w & 0xff];
+            tmptrg[1] = colortab[(w >> 8) & 0xff];
+            tmptrg[2] = colortab[(w >> 16) & 0xff];
+            tmptrg[3] = colortab[w >> 24];
+            w = load_word(tmpsrc + 4);
+            tmptrg[4] = colortab[w & 0xff];
+            tmptrg[5] = colortab[(w >> 8) & 0xff];
+            tmptrg[6] = colortab[(w >> 16) & 0xff];
+            tmptrg[7] = colortab[w >> 24];
+            tmpsrc += 8;
+            tmptrg += 8;
+        }
+        for (; x < width; x++) {
+            *tmptrg++ = colortab[*tmpsrc++];
+        }
+        src += pitchs;
+        trg += pitcht;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* 2x2 */
+
+/* One line: a half pixel if the target starts at an odd x, `width' source
+   pixels doubled, and a half pixel at the end if `wlast'.  */
+static void render_16_2x2_line(const uint32_t *colortab, const uint8_t *src, uint8_t *trg,
+                               unsigned int wfirst, unsigned int width, unsigned int wlast)
+{
+    unsigned int x;
+    uint32_t w;
+
+    if (wfirst) {
+        store_half(trg, colortab[*src++]);
+        trg += 2;
+    }
+    for (x = 0; x + 4 <= width; x += 4) {
+        w = load_word(src);
+        store_word(trg, colortab[w & 0xff]);
+        store_word(trg + 4, colortab[(w >> 8) & 0xff]);
+        store_word(trg + 8, colortab[(w >> 16) & 0xff]);
+        store_word(trg + 12, colortab[w >> 24]);
+        src += 4;
+        trg += 16;
+    }
+    for (; x < width; x++) {
+        store_word(trg, colortab[*src++]);
+        trg += 4;
+    }
+    if (wlast) {
+        store_half(trg, colortab[*src]);
+    }
+}
+
+static void render_16_2x2_fill(uint32_t color, uint8_t *trg,
+                               unsigned int wfirst, unsigned int width, unsigned int wlast)
+{
+    unsigned int x;
+
+    if (wfirst) {
+        store_half(trg, color);
+        trg += 2;
+    }
+    for (x = 0; x < width; x++) {
+        store_word(trg, color);
+        trg += 4;
+    }
+    if (wlast) {
+        store_half(trg, color);
+    }
+}
+
+void render_16_2x2_simd(const video_render_color_tables_t *color_tab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width, const unsigned int height,
+                        const unsigned int xs, const unsigned int ys,
+                        const unsigned int xt, const unsigned int yt,
+                        const unsigned int pitchs, const unsigned int pitcht,
+                        const unsigned int doublescan, video_render_config_t *config)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    unsigned int y, wfirst, wlast, yys;
+    int readable = config->readable;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 1);
+    yys = (ys << 1) | (yt & 1);
+    wfirst = xt & 1;
+    width -= wfirst;
+    wlast = width & 1;
+    width >>= 1;
+    for (y = yys; y < (yys + height); y++) {
+        if (!(y & 1) || doublescan) {
+            if ((y & 1) && readable && y > yys) { /* copy previous line */
+                memcpy(trg, trg - pitcht, ((width << 1) + wfirst + wlast) << 1);
+            } else {
+                render_16_2x2_line(colortab, src, trg, wfirst, width, wlast);
+            }
+        } else {
+            if (readable && y > yys + 1) { /* copy 2 lines before */
+                memcpy(trg, trg - pitcht * 2, ((width << 1) + wfirst + wlast) << 1);
+            } else {
+                render_16_2x2_fill(colortab[0], trg, wfirst, width, wlast);
+            }
+        }
+        if (y & 1) {
+            src += pitchs;
+        }
+        trg += pitcht;
+    }
+}
+
+static void render_32_2x2_line(const uint32_t *colortab, const uint8_t *src, uint32_t *trg,
+                               unsigned int wfirst, unsigned int width, unsigned int wlast)
+{
+    unsigned int x;
+    uint32_t w, color;
+
+    if (wfirst) {
+        *trg++ = colortab[*src++];
+    }
+    for (x = 0; x + 4 <= width; x += 4) {
+        w = load_word(src);
+        color = colortab[w & 0xff];
+        trg[0] = color;
+        trg[1] = color;
+        color = colortab[(w >> 8) & 0xff];
+        trg[2] = color;
+        trg[3] = color;
+        color = colortab[(w >> 16) & 0xff];
+        trg[4] = color;
+        trg[5] = color;
+        color = colortab[w >> 24];
+        trg[6] = color;
+        trg[7] = color;
+        src += 4;
+        trg += 8;
+    }
+    for (; x < width; x++) {
+        color = colortab[*src++];
+        trg[0] = color;
+        trg[1] = color;
+        trg += 2;
+    }
+    if (wlast) {
+        *trg = colortab[*src];
+    }
+}
+
+void render_32_2x2_simd(const video_render_color_tables_t *color_tab,
+                        const uint8_t *src, uint8_t *trg,
+                        unsigned int width, const unsigned int height,
+                        const unsigned int xs, const unsigned int ys,
+                        const unsigned int xt, const unsigned int yt,
+                        const unsigned int pitchs, const unsigned int pitcht,
+                        const unsigned int doublescan, video_render_config_t *config)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    uint32_t *tmptrg;
+    unsigned int x, y, wfirst, wlast, yys;
+    int readable = config->readable;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 2);
+    yys = (ys << 1) | (yt & 1);
+    wfirst = xt & 1;
+    width -= wfirst;
+    wlast = width & 1;
+    width >>= 1;
+    for (y = yys; y < (yys + height); y++) {
+        if (!(y & 1) || doublescan) {
+            if ((y & 1) && readable && y > yys) { /* copy previous line */
+                memcpy(trg, trg - pitcht, ((width << 1) + wfirst + wlast) << 2);
+            } else {
+                render_32_2x2_line(colortab, src, (uint32_t *)trg, wfirst, width, wlast);
+            }
+        } else {
+            if (readable && y > yys + 1) { /* copy 2 lines before */
+                memcpy(trg, trg - pitcht * 2, ((width << 1) + wfirst + wlast) << 2);
+            } else {
+                tmptrg = (uint32_t *)trg;
+                for (x = 0; x < (width << 1) + wfirst + wlast; x++) {
+                    tmptrg[x] = colortab[0];
+                }
+            }
+        }
+        if (y & 1) {
+            src += pitchs;
+        }
+        trg += pitcht;
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+/* scale2x */
+
+/* Source pixel `e' with `l' and `r' left and right of it, `v1' above it on
+   an even target line and below it on an odd one, `v2' on the other side.
+   The rules of scale2x() in renderscale2x.c for the left (even) target
+   pixel, l == v1 && r != v1 && l != v2, and for the right (odd) one,
+   r == v1 && l != v1 && r != v2, both imply l != r and v1 != v2, so that is
+   checked once for the two.  */
+#define SCALE2X_EVEN(l, e, r, v1, v2) ((v1) != (v2) && (l) != (r) && (l) == (v1) ? (l) : (e))
+#define SCALE2X_ODD(l, e, r, v1, v2)  ((v1) != (v2) && (l) != (r) && (r) == (v1) ? (r) : (e))
+
+void render_16_scale2x_simd(const video_render_color_tables_t *color_tab,
+                            const uint8_t *src, uint8_t *trg,
+                            unsigned int width, const unsigned int height,
+                            const unsigned int xs, const unsigned int ys,
+                            const unsigned int xt, const unsigned int yt,
+                            const unsigned int pitchs, const unsigned int pitcht)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    const uint8_t *tmpsrc, *srcv1, *srcv2;
+    uint8_t *tmptrg;
+    unsigned int x, y, yys;
+    uint8_t l, e, r, v1, v2;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 1);
+    yys = (ys << 1) | (yt & 1);
+
+    for (y = yys; y < (yys + height); y++) {
+        tmpsrc = src;
+        tmptrg = trg;
+        srcv1 = (y & 1 ? tmpsrc + pitchs : tmpsrc - pitchs);
+        srcv2 = (y & 1 ? tmpsrc - pitchs : tmpsrc + pitchs);
+        x = width;
+
+        if ((xt & 1) && x > 0) {
+            store_half(tmptrg, colortab[SCALE2X_ODD(tmpsrc[-1], tmpsrc[0], tmpsrc[1], srcv1[0], srcv2[0])]);
+            tmptrg += 2;
+            tmpsrc++;
+            srcv1++;
+            srcv2++;
+            x--;
+        }
+        for (; x >= 2; x -= 2) {
+            l = tmpsrc[-1];
+            e = tmpsrc[0];
+            r = tmpsrc[1];
+            v1 = *srcv1++;
+            v2 = *srcv2++;
+            if (v1 != v2 && l != r) {
+                store_word(tmptrg, PACK16(colortab[l == v1 ? l : e], colortab[r == v1 ? r : e]));
+            } else {
+                store_word(tmptrg, PACK16(colortab[e], colortab[e]));
+            }
+            tmptrg += 4;
+            tmpsrc++;
+        }
+        if (x > 0) {
+            store_half(tmptrg, colortab[SCALE2X_EVEN(tmpsrc[-1], tmpsrc[0], tmpsrc[1], srcv1[0], srcv2[0])]);
+        }
+
+        if (y & 1) {
+            src += pitchs;
+        }
+
+        trg += pitcht;
+    }
+}
+
+void render_32_scale2x_simd(const video_render_color_tables_t *color_tab,
+                            const uint8_t *src, uint8_t *trg,
+                            unsigned int width, const unsigned int height,
+                            const unsigned int xs, const unsigned int ys,
+                            const unsigned int xt, const unsigned int yt,
+                            const unsigned int pitchs, const unsigned int pitcht)
+{
+    const uint32_t *colortab = color_tab->physical_colors;
+    const uint8_t *tmpsrc, *srcv1, *srcv2;
+    uint32_t *tmptrg;
+    unsigned int x, y, yys;
+    uint32_t color;
+    uint8_t l, e, r, v1, v2;
+
+    src = src + pitchs * ys + xs;
+    trg = trg + pitcht * yt + (xt << 2);
+    yys = (ys << 1) | (yt & 1);
+
+    for (y = yys; y < (yys + height); y++) {
+        tmpsrc = src;
+        tmptrg = (uint32_t *)trg;
+        srcv1 = (y & 1 ? tmpsrc + pitchs : tmpsrc - pitchs);
+        srcv2 = (y & 1 ? tmpsrc - pitchs : tmpsrc + pitchs);
+        x = width;
+
+        if ((xt & 1) && x > 0) {
+            *tmptrg++ = colortab[SCALE2X_ODD(tmpsrc[-1], tmpsrc[0], tmpsrc[1], srcv1[0], srcv2[0])];
+            tmpsrc++;
+            srcv1++;
+            srcv2++;
+            x--;
+        }
+        for (; x >= 2; x -= 2) {
+            l = tmpsrc[-1];
+            e = tmpsrc[0];
+            r = tmpsrc[1];
+            v1 = *srcv1++;
+            v2 = *srcv2++;
+            if (v1 != v2 && l != r) {
+                tmptrg[0] = colortab[l == v1 ? l : e];
+                tmptrg[1] = colortab[r == v1 ? r : e];
+            } else {
+                color = colortab[e];
+                tmptrg[0] = color;
+                tmptrg[1] = color;
+            }
+            tmptrg += 2;
+            tmpsrc++;
+        }
+        if (x > 0) {
+            *tmptrg = colortab[SCALE2X_EVEN(tmpsrc[-1], tmpsrc[0], tmpsrc[1], srcv1[0], srcv2[0])];
+        }
+
+        if (y & 1) {
+            src += pitchs;
+        }
+
+        trg += pitcht;
+    }
+}
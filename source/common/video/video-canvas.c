@@ -38,6 +38,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "lib.h"
 #include "log.h"
@@ -46,6 +47,8 @@
 #include "video-canvas.h"
 #include "video-color.h"
 #include "video-render.h"
+#include "video-sound.h"
+#include "video-thread.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -54,6 +57,9 @@
 #ifndef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
 
 /* called from raster/raster-resources.c:raster_resources_chip_init */
 video_canvas_t *video_canvas_init(void)
@@ -77,6 +83,8 @@ video_canvas_t *video_canvas_init(void)
 void video_canvas_shutdown(video_canvas_t *canvas)
 {
     if (canvas != NULL) {
+        video_thread_sync();
+        video_canvas_dirty_reset(canvas);
         lib_free(canvas->videoconfig);
         lib_free(canvas->draw_buffer);
         video_viewport_title_free(canvas->viewport);
@@ -86,17 +94,290 @@ void video_canvas_shutdown(video_canvas_t *canvas)
     }
 }
 
-void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
-                         int height, int xs, int ys, int xt, int yt,
-                         int pitcht, int depth)
+/* ------------------------------------------------------------------------- */
+/* Dirty lines.
+
+   For each buffer a canvas renders into, a hash is kept of every draw buffer line
+   as it was when it was last rendered there, and only the target lines
+   whose draw buffer lines have changed since are rendered again.  This
+   has to be done per target buffer as the SDL screen on the 3DS is double
+   buffered: each update swaps the surface with the one shown, so it holds
+   the frame before the last one.
+
+   The lines are hashed when the frame is rendered rather than when they
+   are emulated, since the status bar and the menus draw into the draw
+   buffer too.  Only the RGB renderers are handled; the PAL and CRT
+   filters blend the lines into each other.  */
+
+/* targets remembered, at least the two buffers of a double buffered
+   screen */
+#define DIRTY_TARGETS   4
+
+/* runs of changed lines no farther apart than this are merged */
+#define DIRTY_RUN_GAP   8
+
+typedef struct dirty_target_s {
+    uint8_t *trg;
+    uint64_t key;           /* hash of everything else the result depends on */
+    unsigned int used;      /* when last used, to replace the oldest */
+    unsigned int lines;     /* entries in `hash' */
+    uint64_t *hash;         /* per draw buffer line */
+} dirty_target_t;
+
+struct video_canvas_dirty_s {
+    dirty_target_t targets[DIRTY_TARGETS];
+    unsigned int used;
+
+    /* per draw buffer line: changed since last rendered into the target */
+    uint8_t *changed;
+    unsigned int changed_lines;
+};
+
+static video_canvas_dirty_stats_t dirty_stats;
+
+/* 64 bits, so that a changed line is as good as never taken for the one
+   that was there before and left on the screen */
+static uint64_t dirty_hash(uint64_t h, const uint8_t *p, unsigned int n)
+{
+    uint32_t w;
+
+    while (n >= 4) {
+        memcpy(&w, p, 4);
+        h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+        h ^= h >> 29;
+        p += 4;
+        n -= 4;
+    }
+    while (n > 0) {
+        h = (h ^ *p++) * 0x9e3779b97f4a7c15ULL;
+        n--;
+    }
+    return h;
+}
+
+static uint64_t dirty_key(video_canvas_t *canvas, int width, int height,
+                          int xs, int ys, int xt, int yt, int pitcht, int depth)
+{
+    video_render_config_t *config = canvas->videoconfig;
+    int k[14];
+    uint64_t h;
+
+    k[0] = width;
+    k[1] = height;
+    k[2] = xs;
+    k[3] = ys;
+    k[4] = xt;
+    k[5] = yt;
+    k[6] = pitcht;
+    k[7] = depth;
+    k[8] = config->rendermode;
+    k[9] = config->doublescan;
+    k[10] = config->scale2x;
+    k[11] = config->readable;
+    k[12] = config->scalex;
+    k[13] = (int)canvas->draw_buffer->draw_buffer_width;
+
+    h = dirty_hash(0xcbf29ce484222325ULL, (const uint8_t *)k, sizeof(k));
+    return dirty_hash(h, (const uint8_t *)config->color_tables.physical_colors,
+                      sizeof(config->color_tables.physical_colors));
+}
+
+static int dirty_can_track(video_canvas_t *canvas, uint8_t *src)
+{
+    video_render_config_t *config = canvas->videoconfig;
+
+    if (!video_dirty_lines || src == NULL) {
+        return 0;
+    }
+
+    switch (config->rendermode) {
+        case VIDEO_RENDER_RGB_1X1:
+        case VIDEO_RENDER_RGB_1X2:
+        case VIDEO_RENDER_RGB_2X2:
+            return config->scaley == 1 || config->scaley == 2;
+    }
+    return 0;
+}
+
+static dirty_target_t *dirty_target_get(video_canvas_dirty_t *dirty, uint8_t *trg,
+                                        uint64_t key, unsigned int lines)
+{
+    dirty_target_t *t = NULL;
+    int i;
+
+    for (i = 0; i < DIRTY_TARGETS; i++) {
+        if (dirty->targets[i].trg == trg) {
+            t = &dirty->targets[i];
+            break;
+        }
+        if (t == NULL || dirty->targets[i].used < t->used) {
+            t = &dirty->targets[i];
+        }
+    }
+
+    if (t->trg != trg || t->key != key || t->lines != lines) {
+        /* nothing known about what is in there */
+        if (t->lines != lines) {
+            lib_free(t->hash);
+            t->hash = lib_malloc(lines * sizeof(uint64_t));
+            t->lines = lines;
+        }
+        t->trg = NULL;
+        t->key = key;
+    }
+    t->used = ++dirty->used;
+
+    return t;
+}
+
+static int dirty_add_run(video_canvas_run_t *runs, int n, int yt, int height)
+{
+    if (n > 0 && (n == VIDEO_CANVAS_MAX_RUNS
+                  || yt - (runs[n - 1].yt + runs[n - 1].height) <= DIRTY_RUN_GAP)) {
+        runs[n - 1].height = yt + height - runs[n - 1].yt;
+        return n;
+    }
+    runs[n].yt = yt;
+    runs[n].height = height;
+    return n + 1;
+}
+
+/* Render the target lines whose draw buffer lines have changed.  */
+static int dirty_render(video_canvas_t *canvas, uint8_t *src, uint8_t *trg,
+                        int width, int height, int xs, int ys, int xt, int yt,
+                        int pitcht, int depth, video_canvas_run_t *runs)
+{
+    video_render_config_t *config = canvas->videoconfig;
+    int pitchs = (int)canvas->draw_buffer->draw_buffer_width;
+    int lines = (int)canvas->draw_buffer->draw_buffer_height;
+    int scaley = config->scaley;
+    int phase = yt % scaley;
+    int first, last, l0, l1, x0, x1, l, k, rows, rendered = 0;
+    int run_start = -1, run_line = 0, n = 0;
+    video_canvas_dirty_t *dirty;
+    dirty_target_t *t;
+    int valid;
+    uint64_t h;
+
+    /* the draw buffer lines and pixels the renderers read: scale2x looks
+       at the pixels around */
+    first = ys;
+    last = ys + (height - 1 + phase) / scaley;
+    l0 = MAX(first - 1, 0);
+    l1 = MIN(last + 1, lines - 1);
+    x0 = MAX(xs - 1, 0);
+    x1 = MIN(xs + (width + 1) / config->scalex + 1, pitchs);
+
+    if (first < 0 || last >= lines || x1 <= x0) {
+        video_render_area(config, src, trg, width, height, xs, ys, xt, yt,
+                          pitchs, pitcht, depth, canvas->viewport);
+        runs[0].yt = yt;
+        runs[0].height = height;
+        return 1;
+    }
+
+    if (canvas->dirty == NULL) {
+        canvas->dirty = lib_calloc(1, sizeof(video_canvas_dirty_t));
+    }
+    dirty = canvas->dirty;
+
+    t = dirty_target_get(dirty, trg,
+                         dirty_key(canvas, width, height, xs, ys, xt, yt, pitcht, depth),
+                         (unsigned int)lines);
+    valid = (t->trg == trg);
+    t->trg = trg;
+
+    if ((unsigned int)lines > dirty->changed_lines) {
+        lib_free(dirty->changed);
+        dirty->changed = lib_malloc((size_t)lines);
+        dirty->changed_lines = (unsigned int)lines;
+    }
+
+    for (l = l0; l <= l1; l++) {
+        h = dirty_hash(0, src + l * pitchs + x0, (unsigned int)(x1 - x0));
+        dirty->changed[l] = !valid || t->hash[l] != h;
+        t->hash[l] = h;
+    }
+
+    k = 0;
+    for (l = first; l <= last && k < height; l++) {
+        int changed = dirty->changed[l];
+
+        if (config->scale2x && config->rendermode == VIDEO_RENDER_RGB_2X2) {
+            changed |= (l > l0 && dirty->changed[l - 1])
+                       || (l < l1 && dirty->changed[l + 1]);
+        }
+
+        if (changed) {
+            if (run_start < 0) {
+                run_start = k;
+                run_line = l;
+            }
+        } else if (run_start >= 0) {
+            video_render_area(config, src, trg, width, k - run_start,
+                              xs, run_line, xt, yt + run_start,
+                              pitchs, pitcht, depth, canvas->viewport);
+            n = dirty_add_run(runs, n, yt + run_start, k - run_start);
+            rendered += k - run_start;
+            run_start = -1;
+        }
+
+        rows = (l == first) ? scaley - phase : scaley;
+        k = MIN(k + rows, height);
+    }
+    if (run_start >= 0) {
+        video_render_area(config, src, trg, width, height - run_start,
+                          xs, run_line, xt, yt + run_start,
+                          pitchs, pitcht, depth, canvas->viewport);
+        n = dirty_add_run(runs, n, yt + run_start, height - run_start);
+        rendered += height - run_start;
+    }
+
+    dirty_stats.lines_skipped += (unsigned long)(height - rendered);
+
+    return n;
+}
+
+void video_canvas_dirty_reset(video_canvas_t *canvas)
+{
+    video_canvas_dirty_t *dirty = canvas->dirty;
+    int i;
+
+    if (dirty == NULL) {
+        return;
+    }
+    for (i = 0; i < DIRTY_TARGETS; i++) {
+        lib_free(dirty->targets[i].hash);
+    }
+    lib_free(dirty->changed);
+    lib_free(dirty);
+    canvas->dirty = NULL;
+}
+
+void video_canvas_get_dirty_stats(video_canvas_dirty_stats_t *stats)
+{
+    *stats = dirty_stats;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int video_canvas_render(video_canvas_t *canvas, uint8_t *src, uint8_t *trg,
+                        int width, int height, int xs, int ys, int xt, int yt,
+                        int pitcht, int depth, video_canvas_run_t *runs)
 {
     static int lastmode = -1;
     viewport_t *viewport = canvas->viewport;
+    int n;
+
 #ifdef VIDEO_SCALE_SOURCE
     xs /= canvas->videoconfig->scalex;
     ys /= canvas->videoconfig->scaley;
 #endif
 
+    if (width <= 0 || height <= 0) {
+        return 0;
+    }
+
     /* when the color encoding changed, the palette must be recalculated */
     if (viewport->crt_type != lastmode) {
         canvas->videoconfig->color_tables.updated = 0;
@@ -106,10 +387,27 @@ void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
     if (!canvas->videoconfig->color_tables.updated) { /* update colors as necessary */
         video_color_update_palette(canvas);
     }
-    video_render_main(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
-                      trg, width, height, xs, ys, xt, yt,
-                      canvas->draw_buffer->draw_buffer_width, pitcht, depth,
-                      viewport);
+
+    dirty_stats.frames++;
+    dirty_stats.lines += (unsigned long)height;
+
+    if (!dirty_can_track(canvas, src)) {
+        video_render_main(canvas->videoconfig, src, trg, width, height, xs, ys, xt, yt,
+                          canvas->draw_buffer->draw_buffer_width, pitcht, depth,
+                          viewport);
+        runs[0].yt = yt;
+        runs[0].height = height;
+        return 1;
+    }
+
+    video_sound_update(canvas->videoconfig, src, width, height, xs, ys,
+                       canvas->draw_buffer->draw_buffer_width, viewport);
+
+    n = dirty_render(canvas, src, trg, width, height, xs, ys, xt, yt, pitcht, depth, runs);
+    if (n == 0) {
+        dirty_stats.frames_clean++;
+    }
+    return n;
 }
 
 void video_canvas_refresh_all(video_canvas_t *canvas)
@@ -145,6 +443,8 @@ int video_canvas_palette_set(struct video_canvas_s *canvas,
         return 0;
     }
 
+    video_thread_sync();
+
     old_palette = canvas->palette;
 
     if (canvas->created) {
@@ -45,6 +45,7 @@
 #include "log.h"
 #include "machine.h"
 #include "palette.h"
+#include "render1x1pal.h"
 #include "resources.h"
 #include "viewport.h"
 #include "video-canvas.h"
@@ -921,6 +922,8 @@ int video_color_update_palette(struct video_canvas_s *canvas)
 
     video_ycbcr_palette_free(ycbcr);
 
+    render_1x1_pal_update_tables(&canvas->videoconfig->color_tables);
+
     if (palette != NULL) {
         // palette changed, recalc and repaint the keyboard
 		uibottom_must_redraw |= UIB_RECALC_KEYBOARD;
@@ -56,16 +56,16 @@ static void video_render_2x2_main(video_render_config_t *config,
                                   xs, ys, xt, yt, pitchs, pitcht);
                 return;
             case 16:
-                render_16_scale2x(colortab, src, trg, width, height,
-                                  xs, ys, xt, yt, pitchs, pitcht);
+                video_render_kernels->render_16_scale2x(colortab, src, trg, width, height,
+                                                        xs, ys, xt, yt, pitchs, pitcht);
                 return;
             case 24:
                 render_24_scale2x(colortab, src, trg, width, height,
                                   xs, ys, xt, yt, pitchs, pitcht);
                 return;
             case 32:
-                render_32_scale2x(colortab, src, trg, width, height,
-                                  xs, ys, xt, yt, pitchs, pitcht);
+                video_render_kernels->render_32_scale2x(colortab, src, trg, width, height,
+                                                        xs, ys, xt, yt, pitchs, pitcht);
                 return;
         }
     } else {
@@ -75,16 +75,16 @@ static void video_render_2x2_main(video_render_config_t *config,
                                  xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                 return;
             case 16:
-                render_16_2x2_04(colortab, src, trg, width, height,
-                                 xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
+                video_render_kernels->render_16_2x2(colortab, src, trg, width, height,
+                                                    xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                 return;
             case 24:
                 render_24_2x2_04(colortab, src, trg, width, height,
                                  xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                 return;
             case 32:
-                render_32_2x2_04(colortab, src, trg, width, height,
-                                 xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
+                video_render_kernels->render_32_2x2(colortab, src, trg, width, height,
+                                                    xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                 return;
         }
     }
@@ -106,16 +106,16 @@ static void video_render_crt_main(video_render_config_t *config,
                                          xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 16:
-                        render_16_1x1_04(colortab, src, trg, width, height,
-                                         xs, ys, xt, yt, pitchs, pitcht);
+                        video_render_kernels->render_16_1x1(colortab, src, trg, width, height,
+                                                            xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 24:
                         render_24_1x1_04(colortab, src, trg, width, height,
                                          xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 32:
-                        render_32_1x1_04(colortab, src, trg, width, height,
-                                         xs, ys, xt, yt, pitchs, pitcht);
+                        video_render_kernels->render_32_1x1(colortab, src, trg, width, height,
+                                                            xs, ys, xt, yt, pitchs, pitcht);
                         return;
                 }
             }
@@ -168,16 +168,16 @@ static void video_render_crt_main(video_render_config_t *config,
                                           xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 16:
-                        render_16_scale2x(colortab, src, trg, width, height,
-                                          xs, ys, xt, yt, pitchs, pitcht);
+                        video_render_kernels->render_16_scale2x(colortab, src, trg, width, height,
+                                                                xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 24:
                         render_24_scale2x(colortab, src, trg, width, height,
                                           xs, ys, xt, yt, pitchs, pitcht);
                         return;
                     case 32:
-                        render_32_scale2x(colortab, src, trg, width, height,
-                                          xs, ys, xt, yt, pitchs, pitcht);
+                        video_render_kernels->render_32_scale2x(colortab, src, trg, width, height,
+                                                                xs, ys, xt, yt, pitchs, pitcht);
                         return;
                 }
             } else if (delayloop && depth != 8) {
@@ -202,16 +202,16 @@ static void video_render_crt_main(video_render_config_t *config,
                                          xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                         return;
                     case 16:
-                        render_16_2x2_04(colortab, src, trg, width, height,
-                                         xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
+                        video_render_kernels->render_16_2x2(colortab, src, trg, width, height,
+                                                            xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                         return;
                     case 24:
                         render_24_2x2_04(colortab, src, trg, width, height,
                                          xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                         return;
                     case 32:
-                        render_32_2x2_04(colortab, src, trg, width, height,
-                                         xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
+                        video_render_kernels->render_32_2x2(colortab, src, trg, width, height,
+                                                            xs, ys, xt, yt, pitchs, pitcht, doublescan, config);
                         return;
                 }
             }
@@ -36,8 +36,11 @@
 #include "render1x2crt.h"
 #include "render2x2crt.h"
 #include "render2x2ntsc.h"
+#include "render2x2.h"
 #include "render2x2pal.h"
 #include "render2x4crt.h"
+#include "renderscale2x.h"
+#include "rendersimd.h"
 #include "renderyuv.h"
 #include "types.h"
 #include "video-render.h"
@@ -66,6 +69,57 @@ static void (*render_crt_func)(video_render_config_t *, uint8_t *, uint8_t *,
                                int, int, int, int,
                                int, int, int, int, int, viewport_t *);
 
+static const video_render_kernels_t render_kernels_plain = {
+    "plain",
+    render_16_1x1_04, render_32_1x1_04,
+    render_16_2x2_04, render_32_2x2_04,
+    render_16_scale2x, render_32_scale2x
+};
+
+static const video_render_kernels_t render_kernels_simd = {
+    "word parallel",
+    render_16_1x1_simd, render_32_1x1_simd,
+    render_16_2x2_simd, render_32_2x2_simd,
+    render_16_scale2x_simd, render_32_scale2x_simd
+};
+
+const video_render_kernels_t *video_render_kernels = &render_kernels_plain;
+
+static int render_kernels_selected = 0;
+
+/* The word parallel renderers need a little endian CPU that loads and
+   stores words at any address in one go, as ARMv6 and later (the 3DS'
+   ARM11) and x86 do.  */
+static int video_render_simd_supported(void)
+{
+#if defined(WORDS_BIGENDIAN)
+    return 0;
+#elif defined(__ARM_FEATURE_UNALIGNED) || defined(__i386__) || defined(__x86_64__)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+const video_render_kernels_t *video_render_get_kernels(int simd)
+{
+    if (!simd) {
+        return &render_kernels_plain;
+    }
+    return video_render_simd_supported() ? &render_kernels_simd : NULL;
+}
+
+static void video_render_select_kernels(void)
+{
+    video_render_kernels = video_render_get_kernels(1);
+    if (video_render_kernels == NULL) {
+        video_render_kernels = &render_kernels_plain;
+    }
+    render_kernels_selected = 1;
+
+    log_message(LOG_DEFAULT, "Video: using %s renderers.", video_render_kernels->name);
+}
+
 void video_render_initconfig(video_render_config_t *config)
 {
     int i;
@@ -102,9 +156,6 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
                        int width, int height, int xs, int ys, int xt, int yt,
                        int pitchs, int pitcht, int depth, viewport_t *viewport)
 {
-    const video_render_color_tables_t *colortab;
-    int rendermode;
-
 #if 0
     log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
               width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
@@ -116,6 +167,25 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
 
     video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
 
+    video_render_area(config, src, trg, width, height, xs, ys, xt, yt,
+                      pitchs, pitcht, depth, viewport);
+}
+
+void video_render_area(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                       int width, int height, int xs, int ys, int xt, int yt,
+                       int pitchs, int pitcht, int depth, viewport_t *viewport)
+{
+    const video_render_color_tables_t *colortab;
+    int rendermode;
+
+    if (width <= 0) {
+        return; /* some render routines don't like invalid width */
+    }
+
+    if (!render_kernels_selected) {
+        video_render_select_kernels();
+    }
+
     rendermode = config->rendermode;
     colortab = &config->color_tables;
 
@@ -145,16 +215,16 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
                                      xs, ys, xt, yt, pitchs, pitcht);
                     return;
                 case 16:
-                    render_16_1x1_04(colortab, src, trg, width, height,
-                                     xs, ys, xt, yt, pitchs, pitcht);
+                    video_render_kernels->render_16_1x1(colortab, src, trg, width, height,
+                                                        xs, ys, xt, yt, pitchs, pitcht);
                     return;
                 case 24:
                     render_24_1x1_04(colortab, src, trg, width, height,
                                      xs, ys, xt, yt, pitchs, pitcht);
                     return;
                 case 32:
-                    render_32_1x1_04(colortab, src, trg, width, height,
-                                     xs, ys, xt, yt, pitchs, pitcht);
+                    video_render_kernels->render_32_1x1(colortab, src, trg, width, height,
+                                                        xs, ys, xt, yt, pitchs, pitcht);
                     return;
             }
             break;
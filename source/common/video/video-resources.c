@@ -45,6 +45,7 @@
 #include "machine.h"
 #include "resources.h"
 #include "video-color.h"
+#include "video-thread.h"
 #include "video.h"
 #include "viewport.h"
 #include "util.h"
@@ -70,8 +71,29 @@ static resource_int_t resources_hwscale_possible[] =
 };
 #endif
 
+int video_dirty_lines;
+
+static int set_video_dirty_lines(int val, void *param)
+{
+    video_dirty_lines = val ? 1 : 0;
+
+    return 0;
+}
+
+static const resource_int_t resources_int[] =
+{
+    { "VideoDirtyLines", 1, RES_EVENT_NO, NULL,
+      &video_dirty_lines, set_video_dirty_lines, NULL },
+    RESOURCE_INT_LIST_END
+};
+
 int video_resources_init(void)
 {
+    if (resources_register_int(resources_int) < 0
+        || video_thread_resources_init() < 0) {
+        return -1;
+    }
+
 #ifdef HAVE_HWSCALE
 	if (resources_register_int(resources_hwscale_possible) < 0) {
 		return -1;
@@ -0,0 +1,284 @@
+/*
+ * video-thread.c - Rendering and presenting frames on a second host thread.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With "VideoThread" enabled, every canvas gets a second draw buffer.
+   At the end of a frame the draw buffer holding it is handed to the video
+   thread, which renders and shows it, and the emulation goes on drawing
+   the next frame into the other one.  The buffers are swapped, not
+   copied.
+
+   Before handing over a frame the emulation waits for the video thread to
+   be done with the last one, so it never draws into a buffer that is
+   being rendered, and no frame is ever dropped: if the video thread is
+   slower than the emulation, the emulation is held back instead.
+   Everything else that refreshes the canvas (the menus, palette changes
+   and so on) waits for the video thread and renders the usual way.
+
+   The draw buffer the emulation gets holds the frame before the last one,
+   so the raster keeps a cache for each of the two buffers and swaps them
+   along (see raster_swap_cache()).
+
+   The video thread runs on the second core of the New 3DS, which it
+   shares with the other worker threads; it runs while the drive and SID
+   workers are waiting, see VICE3DS_PRIO_VIDEO in vice3ds.h.  It is not
+   used on the Old 3DS.  */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "videoarch.h"
+
+#include "bench.h"
+#include "lib.h"
+#include "log.h"
+#include "resources.h"
+#include "types.h"
+#include "vice3ds.h"
+#include "video-thread.h"
+#include "video.h"
+
+#define VIDEO_THREAD_STACKSIZE  (32 * 1024)
+#define VIDEO_THREAD_PRIORITY   VICE3DS_PRIO_VIDEO
+#define VIDEO_THREAD_CORE       2
+
+static log_t video_thread_log = LOG_ERR;
+
+static Thread thread = NULL;
+static SDL_sem *work_sem = NULL;
+static SDL_sem *done_sem = NULL;
+
+/* set if the thread could not be started; frames are then rendered as
+   usual */
+static int thread_failed = 0;
+
+/* whether the thread has a frame that nobody has waited for yet */
+static int busy = 0;
+
+/* held while waiting for the thread, which the menu thread may do too */
+static LightLock sync_lock;
+
+/* set while the raster refreshes the canvas at the end of a frame */
+static int frame_refresh = 0;
+
+/* the frame: written by the emulation before posting `work_sem' */
+static struct video_canvas_s *frame_canvas;
+static uint8_t *frame_buffer;
+static unsigned int frame_xs, frame_ys, frame_xi, frame_yi, frame_w, frame_h;
+static int thread_quit = 0;
+
+static uint64_t last_present = 0;
+
+static video_thread_stats_t stats;
+
+/* ------------------------------------------------------------------------- */
+
+static int video_thread_enabled;
+
+static int set_video_thread_enabled(int val, void *param)
+{
+    video_thread_sync();
+    video_thread_enabled = val ? 1 : 0;
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "VideoThread", 0, RES_EVENT_NO, NULL,
+      &video_thread_enabled, set_video_thread_enabled, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int video_thread_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void video_thread_func(void *data)
+{
+    uint64_t start, now;
+
+    while (1) {
+        SDL_SemWait(work_sem);
+        if (thread_quit) {
+            break;
+        }
+
+        start = bench_ticks();
+        video_canvas_present(frame_canvas, frame_buffer, frame_xs, frame_ys,
+                             frame_xi, frame_yi, frame_w, frame_h);
+        now = bench_ticks();
+
+        stats.presented++;
+        stats.render_ticks += now - start;
+        if (now - start > stats.max_render_ticks) {
+            stats.max_render_ticks = now - start;
+        }
+        if (last_present != 0) {
+            if (stats.min_interval_ticks == 0 || now - last_present < stats.min_interval_ticks) {
+                stats.min_interval_ticks = now - last_present;
+            }
+            if (now - last_present > stats.max_interval_ticks) {
+                stats.max_interval_ticks = now - last_present;
+            }
+        }
+        last_present = now;
+
+        SDL_SemPost(done_sem);
+    }
+}
+
+static int video_thread_start(void)
+{
+    video_thread_log = log_open("VideoThread");
+
+    if (!isN3DS()) {
+        log_message(video_thread_log, "Needs a New 3DS, frames are rendered on the main thread.");
+        return -1;
+    }
+
+    work_sem = SDL_CreateSemaphore(0);
+    done_sem = SDL_CreateSemaphore(0);
+    if (work_sem == NULL || done_sem == NULL) {
+        log_error(video_thread_log, "Cannot create semaphores.");
+        return -1;
+    }
+    LightLock_Init(&sync_lock);
+
+    thread = threadCreate(video_thread_func, NULL, VIDEO_THREAD_STACKSIZE,
+                          VIDEO_THREAD_PRIORITY, VIDEO_THREAD_CORE, false);
+    if (thread == NULL) {
+        log_error(video_thread_log, "Cannot start the video thread.");
+        return -1;
+    }
+
+    log_message(video_thread_log, "Video thread started.");
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void video_thread_shutdown(void)
+{
+    if (thread == NULL) {
+        return;
+    }
+
+    video_thread_sync();
+
+    thread_quit = 1;
+    SDL_SemPost(work_sem);
+    threadJoin(thread, U64_MAX);
+    threadFree(thread);
+    thread = NULL;
+
+    SDL_DestroySemaphore(work_sem);
+    SDL_DestroySemaphore(done_sem);
+    work_sem = done_sem = NULL;
+}
+
+void video_thread_refresh_frame(struct video_canvas_s *canvas)
+{
+    frame_refresh = 1;
+    video_canvas_refresh_all(canvas);
+    frame_refresh = 0;
+}
+
+int video_thread_refresh(struct video_canvas_s *canvas,
+                         unsigned int xs, unsigned int ys,
+                         unsigned int xi, unsigned int yi,
+                         unsigned int w, unsigned int h)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+    size_t size;
+
+    if (!frame_refresh || !video_thread_enabled || thread_failed
+        || draw_buffer->draw_buffer == NULL
+        || canvas->video_draw_buffer_callback != NULL) {
+        video_thread_sync();
+        return 0;
+    }
+
+    if (thread == NULL) {
+        if (video_thread_start() < 0) {
+            thread_failed = 1;
+            return 0;
+        }
+    }
+
+    /* the last frame must be done before its buffer is drawn into */
+    BENCH_ENTER(BENCH_VIDEO);
+    video_thread_sync();
+    BENCH_LEAVE(BENCH_VIDEO);
+
+    if (draw_buffer->draw_buffer_back == NULL) {
+        /* as raster_draw_buffer_alloc() does */
+        size = draw_buffer->draw_buffer_width * (draw_buffer->draw_buffer_height + 1);
+        draw_buffer->draw_buffer_back = lib_malloc(size);
+        memset(draw_buffer->draw_buffer_back, 0, size);
+    }
+
+    frame_canvas = canvas;
+    frame_buffer = draw_buffer->draw_buffer;
+    frame_xs = xs;
+    frame_ys = ys;
+    frame_xi = xi;
+    frame_yi = yi;
+    frame_w = w;
+    frame_h = h;
+
+    draw_buffer->draw_buffer = draw_buffer->draw_buffer_back;
+    draw_buffer->draw_buffer_back = frame_buffer;
+
+    busy = 1;
+    stats.frames++;
+    SDL_SemPost(work_sem);
+
+    return 1;
+}
+
+void video_thread_sync(void)
+{
+    uint64_t start;
+
+    if (!busy) {
+        return;
+    }
+
+    LightLock_Lock(&sync_lock);
+    if (busy) {
+        if (SDL_SemTryWait(done_sem) != 0) {
+            start = bench_ticks();
+            SDL_SemWait(done_sem);
+            stats.waits++;
+            stats.wait_ticks += bench_ticks() - start;
+        }
+        busy = 0;
+    }
+    LightLock_Unlock(&sync_lock);
+}
+
+void video_thread_get_stats(video_thread_stats_t *s)
+{
+    *s = stats;
+}
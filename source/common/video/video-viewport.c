@@ -32,6 +32,7 @@
 
 #include "lib.h"
 #include "machine.h"
+#include "video-thread.h"
 #include "video.h"
 #include "viewport.h"
 
@@ -63,6 +64,8 @@ void video_viewport_resize(video_canvas_t *canvas, char resize_canvas)
         return;
     }
 
+    video_thread_sync();
+
     geometry = canvas->geometry;
     viewport = canvas->viewport;
 
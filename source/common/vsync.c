@@ -51,9 +51,11 @@ int vsync_frame_counter;
 #include <limits.h>
 #endif
 
+#include "bench.h"
 #include "clkguard.h"
 //#include "cmdline.h"
 #include "debug.h"
+#include "drive-thread.h"
 #include "log.h"
 #include "maincpu.h"
 #include "machine.h"
@@ -62,6 +64,8 @@ int vsync_frame_counter;
 //#endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
+#include "runahead.h"
 #include "sound.h"
 #include "types.h"
 #include "vsync.h"
@@ -69,6 +73,10 @@ int vsync_frame_counter;
 
 /* ------------------------------------------------------------------------- */
 
+/* Maximum number of frames we can skip consecutively when adjusting the
+   refresh rate dynamically.  */
+#define MAX_SKIPPED_FRAMES        10
+
 static int set_timer_speed(int speed);
 
 /* Relative speed of the emulation (%).  0 means "don't limit speed". */
@@ -80,6 +88,13 @@ static int refresh_rate;
 /* "Warp mode".  If nonzero, attempt to run as fast as possible. */
 static int warp_mode_enabled;
 
+/* With the refresh rate on automatic, skip rendering a frame only when it
+   is not expected to be done in time, see frameskip_decide().  */
+static int adaptive_frameskip;
+
+/* Maximum number of frames the above skips in a row. */
+static int adaptive_frameskip_max;
+
 // 3d-slider function (0=off, 1=Slowdown, 2=Speedup)
 int slider3d_func;
 
@@ -121,6 +136,21 @@ static int set_warp_mode(int val, void *param)
 }
 
 
+static int set_adaptive_frameskip(int val, void *param)
+{
+    adaptive_frameskip = val ? 1 : 0;
+    return 0;
+}
+
+static int set_adaptive_frameskip_max(int val, void *param)
+{
+    if (val < 1 || val > MAX_SKIPPED_FRAMES) {
+        return -1;
+    }
+    adaptive_frameskip_max = val;
+    return 0;
+}
+
 /* Vsync-related resources. */
 static const resource_int_t resources_int[] = {
     { "Speed", 100, RES_EVENT_SAME, NULL,
@@ -133,6 +163,10 @@ static const resource_int_t resources_int[] = {
     { "WarpMode", 0, RES_EVENT_STRICT, (resource_value_t)0,
       /* FIXME: maybe RES_EVENT_NO */
       &warp_mode_enabled, set_warp_mode, NULL },
+    { "AdaptiveFrameskip", 0, RES_EVENT_NO, NULL,
+      &adaptive_frameskip, set_adaptive_frameskip, NULL },
+    { "AdaptiveFrameskipMax", 4, RES_EVENT_NO, NULL,
+      &adaptive_frameskip_max, set_adaptive_frameskip_max, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -187,10 +221,6 @@ int vsync_cmdline_options_init(void)
 */
 /* ------------------------------------------------------------------------- */
 
-/* Maximum number of frames we can skip consecutively when adjusting the
-   refresh rate dynamically.  */
-#define MAX_SKIPPED_FRAMES        10
-
 /* Number of frames per second on the real machine. */
 static double refresh_frequency;
 
@@ -213,6 +243,18 @@ static int speed_eval_suspended = 1;
 static int sync_reset = 1;
 static CLOCK speed_eval_prev_clk;
 
+/* host ticks (see bench_ticks()) when the emulation of the current frame
+   started, valid unless the emulation has been paused since */
+static uint64_t frame_work_start;
+static int frame_work_valid = 0;
+
+/* Average host time to emulate a rendered and a skipped frame, and the
+   average deviation from it, in timer units.  */
+static long cost_rendered, dev_rendered;
+static long cost_skipped, dev_skipped;
+
+static vsync_frameskip_stats_t frameskip_stats;
+
 /* Initialize vsync timers and set relative speed of emulation in percent. */
 static int set_timer_speed(int speed)
 {
@@ -251,6 +293,7 @@ static void display_speed(int num_frames)
     speed_index = 100.0 * diff_clk / (cycles_per_sec * diff_sec);
 
     vsyncarch_display_speed(speed_index, frame_rate, warp_mode_enabled);
+    frameskip_stats.actual_fps = frame_rate;
 
     speed_eval_prev_clk = maincpu_clk;
 }
@@ -262,6 +305,74 @@ static void clk_overflow_callback(CLOCK amount, void *data)
 
 /* ------------------------------------------------------------------------- */
 
+/* Account the host time the frame just finished took to emulate: from the
+   end of the previous vsync (after sleeping) to the start of this one.  */
+static void frameskip_measure(uint64_t work_end, int been_skipped)
+{
+    long cost, diff, *avg, *dev;
+    int bucket;
+
+    if (!frame_work_valid) {
+        return;
+    }
+
+    cost = (long)((work_end - frame_work_start) * (uint64_t)vsyncarch_freq
+                  / bench_ticks_per_second());
+
+    if (been_skipped) {
+        avg = &cost_skipped;
+        dev = &dev_skipped;
+    } else {
+        avg = &cost_rendered;
+        dev = &dev_rendered;
+    }
+    if (*avg == 0) {
+        *avg = cost;
+        *dev = cost / 4;
+    } else {
+        diff = cost - *avg;
+        *avg += diff / 8;
+        *dev += (labs(diff) - *dev) / 8;
+    }
+
+    frameskip_stats.frames++;
+    if (been_skipped) {
+        frameskip_stats.skipped++;
+    }
+    if (frame_ticks > 0) {
+        bucket = (int)(cost * 4 / frame_ticks);
+        if (bucket >= VSYNC_COST_BUCKETS) {
+            bucket = VSYNC_COST_BUCKETS - 1;
+        }
+        frameskip_stats.histogram[bucket]++;
+    }
+}
+
+/* Should the next frame be emulated without rendering it?  `delay' is how
+   late the next frame starts.  It is, if a rendered frame is not expected
+   to be done before the one after it is due, allowing for the usual
+   variation of the cost.  The emulation itself is never skipped, so the
+   machine and the sound keep their speed.  */
+static int frameskip_decide(signed long delay, int skipped_redraw)
+{
+    long available = frame_ticks - (delay > 0 ? delay : 0);
+
+    if (skipped_redraw >= adaptive_frameskip_max || cost_rendered == 0) {
+        return 0;
+    }
+    return cost_rendered + 2 * dev_rendered > available;
+}
+
+void vsync_get_frameskip_stats(vsync_frameskip_stats_t *stats)
+{
+    *stats = frameskip_stats;
+    stats->target_fps = timer_speed ? refresh_frequency * timer_speed / 100.0 : 0.0;
+    stats->render_ms = vsyncarch_freq ? cost_rendered * 1000.0 / vsyncarch_freq : 0.0;
+    stats->skip_ms = vsyncarch_freq ? cost_skipped * 1000.0 / vsyncarch_freq : 0.0;
+}
+
+/* ------------------------------------------------------------------------- */
+
 void vsync_set_machine_parameter(double refresh, long cycles)
 {
     refresh_frequency = refresh;
@@ -282,6 +393,10 @@ void vsync_init(void (*hook)(void))
 
     vsyncarch_init();
 
+#ifdef VICE_BENCH
+    bench_init();
+#endif
+
     vsyncarch_freq = vsyncarch_frequency();  /* number of units per second */
     /* log_message(LOG_DEFAULT, "VSYNC Init freq: %u", (unsigned int)vsyncarch_freq); */
 }
@@ -302,6 +417,7 @@ void vsync_suspend_speed_eval(void)
     sound_suspend();
     vsync_sync_reset();
     speed_eval_suspended = 1;
+    frame_work_valid = 0;
 }
 
 /* This resets sync calculation after a "too slow" or "sound buffer
@@ -337,6 +453,7 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 
     double sound_delay;
     int skip_next_frame;
+    int adaptive;
 
     signed long delay;
 
@@ -349,8 +466,23 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     monitor_check_remote();
 #endif
 */
+    /* frames emulated ahead of time are not synchronized */
+    if (runahead_vsync(&skip_next_frame)) {
+        return skip_next_frame;
+    }
+
     vsync_frame_counter++;
 
+    frameskip_measure(bench_ticks(), been_skipped);
+
+#ifdef VICE_BENCH
+    bench_vsync();
+#endif
+    BENCH_ENTER(BENCH_SYNC);
+
+    /* the UI may change the drives */
+    drive_thread_sync();
+
     /*
      * process everything wich should be done before the synchronisation
      * e.g. OS/2: exit the programm if trigger_shutdown set
@@ -364,6 +496,8 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 
     vsync_hook();
 
+    rewind_vsync();
+
     if (network_connected()) {
         network_hook_time = vsyncarch_gettime() - network_hook_time;
 
@@ -404,7 +538,9 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     }
 
     /* Flush sound buffer, get delay in seconds. */
+    BENCH_ENTER(BENCH_SOUND);
     sound_delay = sound_flush();
+    BENCH_LEAVE(BENCH_SOUND);
 
     /* Get current time, directly after getting the sound delay. */
     now = vsyncarch_gettime();
@@ -447,7 +583,14 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
      * We could optimize by sleeping only if a frame is to be output.
      */
     /*log_debug("vsync_do_vsync: sound_delay=%f  frame_ticks=%d  delay=%d", sound_delay, frame_ticks, delay);*/
-    if (!warp_mode_enabled && timer_speed && (skipped_redraw == 0) && (delay < 0)) {
+    adaptive = adaptive_frameskip && !refresh_rate && timer_speed && !warp_mode_enabled;
+
+#ifdef VICE_BENCH
+    /* the benchmark never sleeps and renders every frame */
+    skipped_redraw = 0;
+    skip_next_frame = 0;
+#else
+    if (!warp_mode_enabled && timer_speed && (skipped_redraw == 0 || adaptive) && (delay < 0)) {
         /* FIXME: this is likely implemented as a regular sleep(), which means
            it will wait *at least* the given time (but may just as well wait
            much longer. its doomed to break on those archs - we should instead
@@ -477,7 +620,10 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     compval = (frame_ticks_integer * 3 * timer_speed)
               + ((frame_ticks_remainder * 3 * timer_speed) / 100);
 
-    if ((skipped_redraw < MAX_SKIPPED_FRAMES)
+    if (adaptive) {
+        skip_next_frame = frameskip_decide(delay, skipped_redraw);
+        skipped_redraw = skip_next_frame ? skipped_redraw + 1 : 0;
+    } else if ((skipped_redraw < MAX_SKIPPED_FRAMES)
         && (warp_mode_enabled
             || (skipped_redraw < (refresh_rate - 1))
             || ((!timer_speed || delay > compval) && !refresh_rate))
@@ -490,6 +636,7 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
         skip_next_frame = 0;
         skipped_redraw = 0;
     }
+#endif
 
     /*
      * Check whether the hardware can keep up.
@@ -535,8 +682,9 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
        seems to cause problems with every other sound driver I have tested. */
 #if 1
     /* if the frame was skipped, don't advance the time for the next frame, this
-       helps with catching up when rendering falls behind */
-    if ((frame_ticks > 0) && (skipped_redraw < 1)) {
+       helps with catching up when rendering falls behind.  The adaptive
+       frame skipping keeps to the time, it only skips to catch up.  */
+    if ((frame_ticks > 0) && (skipped_redraw < 1 || adaptive)) {
         next_frame_start += frame_ticks;
     }
 #else
@@ -545,6 +693,13 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
 
     vsyncarch_postsync();
 
+    skip_next_frame = runahead_frame_done(skip_next_frame);
+
+    BENCH_LEAVE(BENCH_SYNC);
+
+    frame_work_start = bench_ticks();
+    frame_work_valid = 1;
+
 #ifdef VSYNC_DEBUG
     log_debug("vsync: start:%lu  delay:%ld  sound-delay:%lf  end:%lu  next-frame:%lu  frame-ticks:%lu", 
                 now, delay, sound_delay * 1000000, vsyncarch_gettime(), next_frame_start, frame_ticks);
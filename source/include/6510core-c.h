@@ -77,6 +77,23 @@
 #endif
 #define RESET_CYCLES    6
 
+/* Opcode dispatch.  Building with CPU_THREADED_DISPATCH makes the core jump
+   to the opcode handler through a table of label addresses instead of
+   going through the switch; compilers without labels-as-values (a GNU
+   extension) silently keep using the switch.  Cycle behaviour is the same
+   in both modes.  */
+#if defined(CPU_THREADED_DISPATCH) && defined(__GNUC__)
+#define CPU_LABEL_DISPATCH
+#endif
+
+#ifdef CPU_LABEL_DISPATCH
+#define OPCODE_CASE(op) op_##op:
+#define OPCODE_BREAK    goto opcode_done
+#else
+#define OPCODE_CASE(op) case op:
+#define OPCODE_BREAK    break
+#endif
+
 /* ------------------------------------------------------------------------- */
 /* Backup for non-6509 CPUs.  */
 
@@ -2050,75 +2067,115 @@ static const uint8_t rewind_fetch_tab[] = {
 trap_skipped:
         SET_LAST_OPCODE(p0);
 
+#ifdef CPU_LABEL_DISPATCH
+        static const void *const opcode_dispatch[0x100] = {
+            &&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07,
+            &&op_0x08, &&op_0x09, &&op_0x0a, &&op_0x0b, &&op_0x0c, &&op_0x0d, &&op_0x0e, &&op_0x0f,
+            &&op_0x10, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17,
+            &&op_0x18, &&op_0x19, &&op_0x1a, &&op_0x1b, &&op_0x1c, &&op_0x1d, &&op_0x1e, &&op_0x1f,
+            &&op_0x20, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&op_0x27,
+            &&op_0x28, &&op_0x29, &&op_0x2a, &&op_0x2b, &&op_0x2c, &&op_0x2d, &&op_0x2e, &&op_0x2f,
+            &&op_0x30, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37,
+            &&op_0x38, &&op_0x39, &&op_0x3a, &&op_0x3b, &&op_0x3c, &&op_0x3d, &&op_0x3e, &&op_0x3f,
+            &&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47,
+            &&op_0x48, &&op_0x49, &&op_0x4a, &&op_0x4b, &&op_0x4c, &&op_0x4d, &&op_0x4e, &&op_0x4f,
+            &&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57,
+            &&op_0x58, &&op_0x59, &&op_0x5a, &&op_0x5b, &&op_0x5c, &&op_0x5d, &&op_0x5e, &&op_0x5f,
+            &&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67,
+            &&op_0x68, &&op_0x69, &&op_0x6a, &&op_0x6b, &&op_0x6c, &&op_0x6d, &&op_0x6e, &&op_0x6f,
+            &&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&op_0x76, &&op_0x77,
+            &&op_0x78, &&op_0x79, &&op_0x7a, &&op_0x7b, &&op_0x7c, &&op_0x7d, &&op_0x7e, &&op_0x7f,
+            &&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87,
+            &&op_0x88, &&op_0x89, &&op_0x8a, &&op_0x8b, &&op_0x8c, &&op_0x8d, &&op_0x8e, &&op_0x8f,
+            &&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97,
+            &&op_0x98, &&op_0x99, &&op_0x9a, &&op_0x9b, &&op_0x9c, &&op_0x9d, &&op_0x9e, &&op_0x9f,
+            &&op_0xa0, &&op_0xa1, &&op_0xa2, &&op_0xa3, &&op_0xa4, &&op_0xa5, &&op_0xa6, &&op_0xa7,
+            &&op_0xa8, &&op_0xa9, &&op_0xaa, &&op_0xab, &&op_0xac, &&op_0xad, &&op_0xae, &&op_0xaf,
+            &&op_0xb0, &&op_0xb1, &&op_0xb2, &&op_0xb3, &&op_0xb4, &&op_0xb5, &&op_0xb6, &&op_0xb7,
+            &&op_0xb8, &&op_0xb9, &&op_0xba, &&op_0xbb, &&op_0xbc, &&op_0xbd, &&op_0xbe, &&op_0xbf,
+            &&op_0xc0, &&op_0xc1, &&op_0xc2, &&op_0xc3, &&op_0xc4, &&op_0xc5, &&op_0xc6, &&op_0xc7,
+            &&op_0xc8, &&op_0xc9, &&op_0xca, &&op_0xcb, &&op_0xcc, &&op_0xcd, &&op_0xce, &&op_0xcf,
+            &&op_0xd0, &&op_0xd1, &&op_0xd2, &&op_0xd3, &&op_0xd4, &&op_0xd5, &&op_0xd6, &&op_0xd7,
+            &&op_0xd8, &&op_0xd9, &&op_0xda, &&op_0xdb, &&op_0xdc, &&op_0xdd, &&op_0xde, &&op_0xdf,
+            &&op_0xe0, &&op_0xe1, &&op_0xe2, &&op_0xe3, &&op_0xe4, &&op_0xe5, &&op_0xe6, &&op_0xe7,
+            &&op_0xe8, &&op_0xe9, &&op_0xea, &&op_0xeb, &&op_0xec, &&op_0xed, &&op_0xee, &&op_0xef,
+            &&op_0xf0, &&op_0xf1, &&op_0xf2, &&op_0xf3, &&op_0xf4, &&op_0xf5, &&op_0xf6, &&op_0xf7,
+            &&op_0xf8, &&op_0xf9, &&op_0xfa, &&op_0xfb, &&op_0xfc, &&op_0xfd, &&op_0xfe, &&op_0xff
+        };
+
+        goto *opcode_dispatch[p0];
+        {
+#else
         switch (p0) {
-            case 0x00:          /* BRK */
+#endif
+            OPCODE_CASE(0x00)   /* BRK */
                 BRK();
-                break;
+                OPCODE_BREAK;
 
-            case 0x01:          /* ORA ($nn,X) */
+            OPCODE_CASE(0x01)   /* ORA ($nn,X) */
                 ORA(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x02:          /* JAM - also used for traps */
+            OPCODE_CASE(0x02)   /* JAM - also used for traps */
                 STATIC_ASSERT(TRAP_OPCODE == 0x02);
                 JAM_02();
-                break;
-
-            case 0x22:          /* JAM */
-            case 0x52:          /* JAM */
-            case 0x62:          /* JAM */
-            case 0x72:          /* JAM */
-            case 0x92:          /* JAM */
-            case 0xb2:          /* JAM */
-            case 0xd2:          /* JAM */
-            case 0xf2:          /* JAM */
+                OPCODE_BREAK;
+
+            OPCODE_CASE(0x22)   /* JAM */
+            OPCODE_CASE(0x52)   /* JAM */
+            OPCODE_CASE(0x62)   /* JAM */
+            OPCODE_CASE(0x72)   /* JAM */
+            OPCODE_CASE(0x92)   /* JAM */
+            OPCODE_CASE(0xb2)   /* JAM */
+            OPCODE_CASE(0xd2)   /* JAM */
+            OPCODE_CASE(0xf2)   /* JAM */
 #ifndef C64DTV
-            case 0x12:          /* JAM */
-            case 0x32:          /* JAM */
-            case 0x42:          /* JAM */
+            OPCODE_CASE(0x12)   /* JAM */
+            OPCODE_CASE(0x32)   /* JAM */
+            OPCODE_CASE(0x42)   /* JAM */
 #endif
                 REWIND_FETCH_OPCODE(CLK);
                 JAM();
-                break;
+                OPCODE_BREAK;
 
 #ifdef C64DTV
             /* These opcodes are defined in c64/c64dtvcpu.c */
-            case 0x12:          /* BRA */
+            OPCODE_CASE(0x12)   /* BRA */
                 BRANCH(1, p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x32:          /* SAC */
+            OPCODE_CASE(0x32)   /* SAC */
                 SAC(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x42:          /* SIR */
+            OPCODE_CASE(0x42)   /* SIR */
                 SIR(p1);
-                break;
+                OPCODE_BREAK;
 #endif
 
-            case 0x03:          /* SLO ($nn,X) */
+            OPCODE_CASE(0x03)   /* SLO ($nn,X) */
                 SLO(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x04:          /* NOOP $nn */
-            case 0x44:          /* NOOP $nn */
-            case 0x64:          /* NOOP $nn */
+            OPCODE_CASE(0x04)   /* NOOP $nn */
+            OPCODE_CASE(0x44)   /* NOOP $nn */
+            OPCODE_CASE(0x64)   /* NOOP $nn */
                 NOOP(1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x05:          /* ORA $nn */
+            OPCODE_CASE(0x05)   /* ORA $nn */
                 ORA(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x06:          /* ASL $nn */
+            OPCODE_CASE(0x06)   /* ASL $nn */
                 ASL(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x07:          /* SLO $nn */
+            OPCODE_CASE(0x07)   /* SLO $nn */
                 SLO(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x08:          /* PHP */
+            OPCODE_CASE(0x08)   /* PHP */
 #ifdef DRIVE_CPU
                 drivecpu_rotate();
                 if (drivecpu_byte_ready()) {
@@ -2127,273 +2184,273 @@ trap_skipped:
                 }
 #endif
                 PHP();
-                break;
+                OPCODE_BREAK;
 
-            case 0x09:          /* ORA #$nn */
+            OPCODE_CASE(0x09)   /* ORA #$nn */
                 ORA(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x0a:          /* ASL A */
+            OPCODE_CASE(0x0a)   /* ASL A */
                 ASL_A();
-                break;
+                OPCODE_BREAK;
 
-            case 0x0b:          /* ANC #$nn */
-            case 0x2b:          /* ANC #$nn */
+            OPCODE_CASE(0x0b)   /* ANC #$nn */
+            OPCODE_CASE(0x2b)   /* ANC #$nn */
                 ANC(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x0c:          /* NOOP $nnnn */
+            OPCODE_CASE(0x0c)   /* NOOP $nnnn */
                 NOOP_ABS();
-                break;
+                OPCODE_BREAK;
 
-            case 0x0d:          /* ORA $nnnn */
+            OPCODE_CASE(0x0d)   /* ORA $nnnn */
                 ORA(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x0e:          /* ASL $nnnn */
+            OPCODE_CASE(0x0e)   /* ASL $nnnn */
                 ASL(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x0f:          /* SLO $nnnn */
+            OPCODE_CASE(0x0f)   /* SLO $nnnn */
                 SLO(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x10:          /* BPL $nnnn */
+            OPCODE_CASE(0x10)   /* BPL $nnnn */
                 BRANCH(!LOCAL_SIGN(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x11:          /* ORA ($nn),Y */
+            OPCODE_CASE(0x11)   /* ORA ($nn),Y */
                 ORA(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x13:          /* SLO ($nn),Y */
+            OPCODE_CASE(0x13)   /* SLO ($nn),Y */
                 SLO_IND_Y(p1);
-                break;
-
-            case 0x14:          /* NOOP $nn,X */
-            case 0x34:          /* NOOP $nn,X */
-            case 0x54:          /* NOOP $nn,X */
-            case 0x74:          /* NOOP $nn,X */
-            case 0xd4:          /* NOOP $nn,X */
-            case 0xf4:          /* NOOP $nn,X */
+                OPCODE_BREAK;
+
+            OPCODE_CASE(0x14)   /* NOOP $nn,X */
+            OPCODE_CASE(0x34)   /* NOOP $nn,X */
+            OPCODE_CASE(0x54)   /* NOOP $nn,X */
+            OPCODE_CASE(0x74)   /* NOOP $nn,X */
+            OPCODE_CASE(0xd4)   /* NOOP $nn,X */
+            OPCODE_CASE(0xf4)   /* NOOP $nn,X */
                 NOOP(CLK_NOOP_ZERO_X, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x15:          /* ORA $nn,X */
+            OPCODE_CASE(0x15)   /* ORA $nn,X */
                 ORA(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x16:          /* ASL $nn,X */
+            OPCODE_CASE(0x16)   /* ASL $nn,X */
                 ASL((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x17:          /* SLO $nn,X */
+            OPCODE_CASE(0x17)   /* SLO $nn,X */
                 SLO((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x18:          /* CLC */
+            OPCODE_CASE(0x18)   /* CLC */
                 CLC();
-                break;
+                OPCODE_BREAK;
 
-            case 0x19:          /* ORA $nnnn,Y */
+            OPCODE_CASE(0x19)   /* ORA $nnnn,Y */
                 ORA(LOAD_ABS_Y(p2), 1, 3);
-                break;
-
-            case 0x1a:          /* NOOP */
-            case 0x3a:          /* NOOP */
-            case 0x5a:          /* NOOP */
-            case 0x7a:          /* NOOP */
-            case 0xda:          /* NOOP */
-            case 0xfa:          /* NOOP */
+                OPCODE_BREAK;
+
+            OPCODE_CASE(0x1a)   /* NOOP */
+            OPCODE_CASE(0x3a)   /* NOOP */
+            OPCODE_CASE(0x5a)   /* NOOP */
+            OPCODE_CASE(0x7a)   /* NOOP */
+            OPCODE_CASE(0xda)   /* NOOP */
+            OPCODE_CASE(0xfa)   /* NOOP */
                 NOOP_IMM(1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x1b:          /* SLO $nnnn,Y */
+            OPCODE_CASE(0x1b)   /* SLO $nnnn,Y */
                 SLO(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
-
-            case 0x1c:          /* NOOP $nnnn,X */
-            case 0x3c:          /* NOOP $nnnn,X */
-            case 0x5c:          /* NOOP $nnnn,X */
-            case 0x7c:          /* NOOP $nnnn,X */
-            case 0xdc:          /* NOOP $nnnn,X */
-            case 0xfc:          /* NOOP $nnnn,X */
+                OPCODE_BREAK;
+
+            OPCODE_CASE(0x1c)   /* NOOP $nnnn,X */
+            OPCODE_CASE(0x3c)   /* NOOP $nnnn,X */
+            OPCODE_CASE(0x5c)   /* NOOP $nnnn,X */
+            OPCODE_CASE(0x7c)   /* NOOP $nnnn,X */
+            OPCODE_CASE(0xdc)   /* NOOP $nnnn,X */
+            OPCODE_CASE(0xfc)   /* NOOP $nnnn,X */
                 NOOP_ABS_X();
-                break;
+                OPCODE_BREAK;
 
-            case 0x1d:          /* ORA $nnnn,X */
+            OPCODE_CASE(0x1d)   /* ORA $nnnn,X */
                 ORA(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x1e:          /* ASL $nnnn,X */
+            OPCODE_CASE(0x1e)   /* ASL $nnnn,X */
                 ASL(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x1f:          /* SLO $nnnn,X */
+            OPCODE_CASE(0x1f)   /* SLO $nnnn,X */
                 SLO(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x20:          /* JSR $nnnn */
+            OPCODE_CASE(0x20)   /* JSR $nnnn */
                 JSR();
-                break;
+                OPCODE_BREAK;
 
-            case 0x21:          /* AND ($nn,X) */
+            OPCODE_CASE(0x21)   /* AND ($nn,X) */
                 AND(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x23:          /* RLA ($nn,X) */
+            OPCODE_CASE(0x23)   /* RLA ($nn,X) */
                 RLA(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x24:          /* BIT $nn */
+            OPCODE_CASE(0x24)   /* BIT $nn */
                 BIT(LOAD_ZERO(p1), 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x25:          /* AND $nn */
+            OPCODE_CASE(0x25)   /* AND $nn */
                 AND(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x26:          /* ROL $nn */
+            OPCODE_CASE(0x26)   /* ROL $nn */
                 ROL(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x27:          /* RLA $nn */
+            OPCODE_CASE(0x27)   /* RLA $nn */
                 RLA(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x28:          /* PLP */
+            OPCODE_CASE(0x28)   /* PLP */
                 PLP();
-                break;
+                OPCODE_BREAK;
 
-            case 0x29:          /* AND #$nn */
+            OPCODE_CASE(0x29)   /* AND #$nn */
                 AND(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x2a:          /* ROL A */
+            OPCODE_CASE(0x2a)   /* ROL A */
                 ROL_A();
-                break;
+                OPCODE_BREAK;
 
-            case 0x2c:          /* BIT $nnnn */
+            OPCODE_CASE(0x2c)   /* BIT $nnnn */
                 BIT(LOAD(p2), 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x2d:          /* AND $nnnn */
+            OPCODE_CASE(0x2d)   /* AND $nnnn */
                 AND(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x2e:          /* ROL $nnnn */
+            OPCODE_CASE(0x2e)   /* ROL $nnnn */
                 ROL(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x2f:          /* RLA $nnnn */
+            OPCODE_CASE(0x2f)   /* RLA $nnnn */
                 RLA(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x30:          /* BMI $nnnn */
+            OPCODE_CASE(0x30)   /* BMI $nnnn */
                 BRANCH(LOCAL_SIGN(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x31:          /* AND ($nn),Y */
+            OPCODE_CASE(0x31)   /* AND ($nn),Y */
                 AND(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x33:          /* RLA ($nn),Y */
+            OPCODE_CASE(0x33)   /* RLA ($nn),Y */
                 RLA_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x35:          /* AND $nn,X */
+            OPCODE_CASE(0x35)   /* AND $nn,X */
                 AND(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x36:          /* ROL $nn,X */
+            OPCODE_CASE(0x36)   /* ROL $nn,X */
                 ROL((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x37:          /* RLA $nn,X */
+            OPCODE_CASE(0x37)   /* RLA $nn,X */
                 RLA((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x38:          /* SEC */
+            OPCODE_CASE(0x38)   /* SEC */
                 SEC();
-                break;
+                OPCODE_BREAK;
 
-            case 0x39:          /* AND $nnnn,Y */
+            OPCODE_CASE(0x39)   /* AND $nnnn,Y */
                 AND(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x3b:          /* RLA $nnnn,Y */
+            OPCODE_CASE(0x3b)   /* RLA $nnnn,Y */
                 RLA(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x3d:          /* AND $nnnn,X */
+            OPCODE_CASE(0x3d)   /* AND $nnnn,X */
                 AND(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x3e:          /* ROL $nnnn,X */
+            OPCODE_CASE(0x3e)   /* ROL $nnnn,X */
                 ROL(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x3f:          /* RLA $nnnn,X */
+            OPCODE_CASE(0x3f)   /* RLA $nnnn,X */
                 RLA(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x40:          /* RTI */
+            OPCODE_CASE(0x40)   /* RTI */
                 RTI();
-                break;
+                OPCODE_BREAK;
 
-            case 0x41:          /* EOR ($nn,X) */
+            OPCODE_CASE(0x41)   /* EOR ($nn,X) */
                 EOR(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x43:          /* SRE ($nn,X) */
+            OPCODE_CASE(0x43)   /* SRE ($nn,X) */
                 SRE(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x45:          /* EOR $nn */
+            OPCODE_CASE(0x45)   /* EOR $nn */
                 EOR(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x46:          /* LSR $nn */
+            OPCODE_CASE(0x46)   /* LSR $nn */
                 LSR(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x47:          /* SRE $nn */
+            OPCODE_CASE(0x47)   /* SRE $nn */
                 SRE(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x48:          /* PHA */
+            OPCODE_CASE(0x48)   /* PHA */
                 PHA();
-                break;
+                OPCODE_BREAK;
 
-            case 0x49:          /* EOR #$nn */
+            OPCODE_CASE(0x49)   /* EOR #$nn */
                 EOR(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x4a:          /* LSR A */
+            OPCODE_CASE(0x4a)   /* LSR A */
                 LSR_A();
-                break;
+                OPCODE_BREAK;
 
-            case 0x4b:          /* ASR #$nn */
+            OPCODE_CASE(0x4b)   /* ASR #$nn */
                 ASR(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x4c:          /* JMP $nnnn */
+            OPCODE_CASE(0x4c)   /* JMP $nnnn */
                 JMP(p2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x4d:          /* EOR $nnnn */
+            OPCODE_CASE(0x4d)   /* EOR $nnnn */
                 EOR(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x4e:          /* LSR $nnnn */
+            OPCODE_CASE(0x4e)   /* LSR $nnnn */
                 LSR(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x4f:          /* SRE $nnnn */
+            OPCODE_CASE(0x4f)   /* SRE $nnnn */
                 SRE(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x50:          /* BVC $nnnn */
+            OPCODE_CASE(0x50)   /* BVC $nnnn */
 #ifdef DRIVE_CPU
                 CLK_ADD(CLK, -1);
                 drivecpu_rotate();
@@ -2404,109 +2461,109 @@ trap_skipped:
                 CLK_ADD(CLK, 1);
 #endif
                 BRANCH(!LOCAL_OVERFLOW(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x51:          /* EOR ($nn),Y */
+            OPCODE_CASE(0x51)   /* EOR ($nn),Y */
                 EOR(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x53:          /* SRE ($nn),Y */
+            OPCODE_CASE(0x53)   /* SRE ($nn),Y */
                 SRE_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x55:          /* EOR $nn,X */
+            OPCODE_CASE(0x55)   /* EOR $nn,X */
                 EOR(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x56:          /* LSR $nn,X */
+            OPCODE_CASE(0x56)   /* LSR $nn,X */
                 LSR((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x57:          /* SRE $nn,X */
+            OPCODE_CASE(0x57)   /* SRE $nn,X */
                 SRE((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x58:          /* CLI */
+            OPCODE_CASE(0x58)   /* CLI */
                 CLI();
-                break;
+                OPCODE_BREAK;
 
-            case 0x59:          /* EOR $nnnn,Y */
+            OPCODE_CASE(0x59)   /* EOR $nnnn,Y */
                 EOR(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x5b:          /* SRE $nnnn,Y */
+            OPCODE_CASE(0x5b)   /* SRE $nnnn,Y */
                 SRE(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x5d:          /* EOR $nnnn,X */
+            OPCODE_CASE(0x5d)   /* EOR $nnnn,X */
                 EOR(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x5e:          /* LSR $nnnn,X */
+            OPCODE_CASE(0x5e)   /* LSR $nnnn,X */
                 LSR(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x5f:          /* SRE $nnnn,X */
+            OPCODE_CASE(0x5f)   /* SRE $nnnn,X */
                 SRE(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x60:          /* RTS */
+            OPCODE_CASE(0x60)   /* RTS */
                 RTS();
-                break;
+                OPCODE_BREAK;
 
-            case 0x61:          /* ADC ($nn,X) */
+            OPCODE_CASE(0x61)   /* ADC ($nn,X) */
                 ADC(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x63:          /* RRA ($nn,X) */
+            OPCODE_CASE(0x63)   /* RRA ($nn,X) */
                 RRA(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x65:          /* ADC $nn */
+            OPCODE_CASE(0x65)   /* ADC $nn */
                 ADC(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x66:          /* ROR $nn */
+            OPCODE_CASE(0x66)   /* ROR $nn */
                 ROR(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x67:          /* RRA $nn */
+            OPCODE_CASE(0x67)   /* RRA $nn */
                 RRA(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x68:          /* PLA */
+            OPCODE_CASE(0x68)   /* PLA */
                 PLA();
-                break;
+                OPCODE_BREAK;
 
-            case 0x69:          /* ADC #$nn */
+            OPCODE_CASE(0x69)   /* ADC #$nn */
                 ADC(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x6a:          /* ROR A */
+            OPCODE_CASE(0x6a)   /* ROR A */
                 ROR_A();
-                break;
+                OPCODE_BREAK;
 
-            case 0x6b:          /* ARR #$nn */
+            OPCODE_CASE(0x6b)   /* ARR #$nn */
                 ARR(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x6c:          /* JMP ($nnnn) */
+            OPCODE_CASE(0x6c)   /* JMP ($nnnn) */
                 JMP_IND();
-                break;
+                OPCODE_BREAK;
 
-            case 0x6d:          /* ADC $nnnn */
+            OPCODE_CASE(0x6d)   /* ADC $nnnn */
                 ADC(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x6e:          /* ROR $nnnn */
+            OPCODE_CASE(0x6e)   /* ROR $nnnn */
                 ROR(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x6f:          /* RRA $nnnn */
+            OPCODE_CASE(0x6f)   /* RRA $nnnn */
                 RRA(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x70:          /* BVS $nnnn */
+            OPCODE_CASE(0x70)   /* BVS $nnnn */
 #ifdef DRIVE_CPU
                 CLK_ADD(CLK, -1);
                 drivecpu_rotate();
@@ -2517,515 +2574,519 @@ trap_skipped:
                 CLK_ADD(CLK, 1);
 #endif
                 BRANCH(LOCAL_OVERFLOW(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x71:          /* ADC ($nn),Y */
+            OPCODE_CASE(0x71)   /* ADC ($nn),Y */
                 ADC(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x73:          /* RRA ($nn),Y */
+            OPCODE_CASE(0x73)   /* RRA ($nn),Y */
                 RRA_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x75:          /* ADC $nn,X */
+            OPCODE_CASE(0x75)   /* ADC $nn,X */
                 ADC(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x76:          /* ROR $nn,X */
+            OPCODE_CASE(0x76)   /* ROR $nn,X */
                 ROR((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x77:          /* RRA $nn,X */
+            OPCODE_CASE(0x77)   /* RRA $nn,X */
                 RRA((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x78:          /* SEI */
+            OPCODE_CASE(0x78)   /* SEI */
                 SEI();
-                break;
+                OPCODE_BREAK;
 
-            case 0x79:          /* ADC $nnnn,Y */
+            OPCODE_CASE(0x79)   /* ADC $nnnn,Y */
                 ADC(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x7b:          /* RRA $nnnn,Y */
+            OPCODE_CASE(0x7b)   /* RRA $nnnn,Y */
                 RRA(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x7d:          /* ADC $nnnn,X */
+            OPCODE_CASE(0x7d)   /* ADC $nnnn,X */
                 ADC(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x7e:          /* ROR $nnnn,X */
+            OPCODE_CASE(0x7e)   /* ROR $nnnn,X */
                 ROR(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x7f:          /* RRA $nnnn,X */
+            OPCODE_CASE(0x7f)   /* RRA $nnnn,X */
                 RRA(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0x80:          /* NOOP #$nn */
-            case 0x82:          /* NOOP #$nn */
-            case 0x89:          /* NOOP #$nn */
-            case 0xc2:          /* NOOP #$nn */
-            case 0xe2:          /* NOOP #$nn */
+            OPCODE_CASE(0x80)   /* NOOP #$nn */
+            OPCODE_CASE(0x82)   /* NOOP #$nn */
+            OPCODE_CASE(0x89)   /* NOOP #$nn */
+            OPCODE_CASE(0xc2)   /* NOOP #$nn */
+            OPCODE_CASE(0xe2)   /* NOOP #$nn */
                 NOOP_IMM(2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x81:          /* STA ($nn,X) */
+            OPCODE_CASE(0x81)   /* STA ($nn,X) */
                 STA(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, 1, 2, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x83:          /* SAX ($nn,X) */
+            OPCODE_CASE(0x83)   /* SAX ($nn,X) */
                 SAX(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x84:          /* STY $nn */
+            OPCODE_CASE(0x84)   /* STY $nn */
                 STY_ZERO(p1, 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x85:          /* STA $nn */
+            OPCODE_CASE(0x85)   /* STA $nn */
                 STA_ZERO(p1, 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x86:          /* STX $nn */
+            OPCODE_CASE(0x86)   /* STX $nn */
                 STX_ZERO(p1, 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x87:          /* SAX $nn */
+            OPCODE_CASE(0x87)   /* SAX $nn */
                 SAX_ZERO(p1, 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x88:          /* DEY */
+            OPCODE_CASE(0x88)   /* DEY */
                 DEY();
-                break;
+                OPCODE_BREAK;
 
-            case 0x8a:          /* TXA */
+            OPCODE_CASE(0x8a)   /* TXA */
                 TXA();
-                break;
+                OPCODE_BREAK;
 
-            case 0x8b:          /* ANE #$nn */
+            OPCODE_CASE(0x8b)   /* ANE #$nn */
                 ANE(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x8c:          /* STY $nnnn */
+            OPCODE_CASE(0x8c)   /* STY $nnnn */
                 STY(p2, 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x8d:          /* STA $nnnn */
+            OPCODE_CASE(0x8d)   /* STA $nnnn */
                 STA(p2, 0, 1, 3, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0x8e:          /* STX $nnnn */
+            OPCODE_CASE(0x8e)   /* STX $nnnn */
                 STX(p2, 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x8f:          /* SAX $nnnn */
+            OPCODE_CASE(0x8f)   /* SAX $nnnn */
                 SAX(p2, 0, 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0x90:          /* BCC $nnnn */
+            OPCODE_CASE(0x90)   /* BCC $nnnn */
                 BRANCH(!LOCAL_CARRY(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x91:          /* STA ($nn),Y */
+            OPCODE_CASE(0x91)   /* STA ($nn),Y */
                 STA_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x93:          /* SHA ($nn),Y */
+            OPCODE_CASE(0x93)   /* SHA ($nn),Y */
                 SHA_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0x94:          /* STY $nn,X */
+            OPCODE_CASE(0x94)   /* STY $nn,X */
                 STY_ZERO(p1 + reg_x_read, CLK_ZERO_I_STORE, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x95:          /* STA $nn,X */
+            OPCODE_CASE(0x95)   /* STA $nn,X */
                 STA_ZERO(p1 + reg_x_read, CLK_ZERO_I_STORE, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x96:          /* STX $nn,Y */
+            OPCODE_CASE(0x96)   /* STX $nn,Y */
                 STX_ZERO(p1 + reg_y_read, CLK_ZERO_I_STORE, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x97:          /* SAX $nn,Y */
+            OPCODE_CASE(0x97)   /* SAX $nn,Y */
                 SAX((p1 + reg_y_read) & 0xff, 0, CLK_ZERO_I_STORE, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x98:          /* TYA */
+            OPCODE_CASE(0x98)   /* TYA */
                 TYA();
-                break;
+                OPCODE_BREAK;
 
-            case 0x99:          /* STA $nnnn,Y */
+            OPCODE_CASE(0x99)   /* STA $nnnn,Y */
                 STA(p2, 0, CLK_ABS_I_STORE2, 3, STORE_ABS_Y);
-                break;
+                OPCODE_BREAK;
 
-            case 0x9a:          /* TXS */
+            OPCODE_CASE(0x9a)   /* TXS */
                 TXS();
-                break;
+                OPCODE_BREAK;
 
-            case 0x9b:          /* SHS $nnnn,Y */
+            OPCODE_CASE(0x9b)   /* SHS $nnnn,Y */
 #ifdef C64DTV
                 NOOP_ABS_Y();
 #else
                 SHS_ABS_Y(p2);
 #endif
-                break;
+                OPCODE_BREAK;
 
-            case 0x9c:          /* SHY $nnnn,X */
+            OPCODE_CASE(0x9c)   /* SHY $nnnn,X */
                 SHY_ABS_X(p2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x9d:          /* STA $nnnn,X */
+            OPCODE_CASE(0x9d)   /* STA $nnnn,X */
                 STA(p2, 0, CLK_ABS_I_STORE2, 3, STORE_ABS_X);
-                break;
+                OPCODE_BREAK;
 
-            case 0x9e:          /* SHX $nnnn,Y */
+            OPCODE_CASE(0x9e)   /* SHX $nnnn,Y */
                 SHX_ABS_Y(p2);
-                break;
+                OPCODE_BREAK;
 
-            case 0x9f:          /* SHA $nnnn,Y */
+            OPCODE_CASE(0x9f)   /* SHA $nnnn,Y */
                 SHA_ABS_Y(p2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa0:          /* LDY #$nn */
+            OPCODE_CASE(0xa0)   /* LDY #$nn */
                 LDY(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa1:          /* LDA ($nn,X) */
+            OPCODE_CASE(0xa1)   /* LDA ($nn,X) */
                 LDA(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa2:          /* LDX #$nn */
+            OPCODE_CASE(0xa2)   /* LDX #$nn */
                 LDX(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa3:          /* LAX ($nn,X) */
+            OPCODE_CASE(0xa3)   /* LAX ($nn,X) */
                 LAX(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa4:          /* LDY $nn */
+            OPCODE_CASE(0xa4)   /* LDY $nn */
                 LDY(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa5:          /* LDA $nn */
+            OPCODE_CASE(0xa5)   /* LDA $nn */
                 LDA(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa6:          /* LDX $nn */
+            OPCODE_CASE(0xa6)   /* LDX $nn */
                 LDX(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa7:          /* LAX $nn */
+            OPCODE_CASE(0xa7)   /* LAX $nn */
                 LAX(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xa8:          /* TAY */
+            OPCODE_CASE(0xa8)   /* TAY */
                 TAY();
-                break;
+                OPCODE_BREAK;
 
-            case 0xa9:          /* LDA #$nn */
+            OPCODE_CASE(0xa9)   /* LDA #$nn */
                 LDA(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xaa:          /* TAX */
+            OPCODE_CASE(0xaa)   /* TAX */
                 TAX();
-                break;
+                OPCODE_BREAK;
 
-            case 0xab:          /* LXA #$nn */
+            OPCODE_CASE(0xab)   /* LXA #$nn */
                 LXA(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xac:          /* LDY $nnnn */
+            OPCODE_CASE(0xac)   /* LDY $nnnn */
                 LDY(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xad:          /* LDA $nnnn */
+            OPCODE_CASE(0xad)   /* LDA $nnnn */
                 LDA(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xae:          /* LDX $nnnn */
+            OPCODE_CASE(0xae)   /* LDX $nnnn */
                 LDX(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xaf:          /* LAX $nnnn */
+            OPCODE_CASE(0xaf)   /* LAX $nnnn */
                 LAX(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb0:          /* BCS $nnnn */
+            OPCODE_CASE(0xb0)   /* BCS $nnnn */
                 BRANCH(LOCAL_CARRY(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb1:          /* LDA ($nn),Y */
+            OPCODE_CASE(0xb1)   /* LDA ($nn),Y */
                 LDA(LOAD_IND_Y_BANK(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb3:          /* LAX ($nn),Y */
+            OPCODE_CASE(0xb3)   /* LAX ($nn),Y */
                 LAX(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb4:          /* LDY $nn,X */
+            OPCODE_CASE(0xb4)   /* LDY $nn,X */
                 LDY(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb5:          /* LDA $nn,X */
+            OPCODE_CASE(0xb5)   /* LDA $nn,X */
                 LDA(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb6:          /* LDX $nn,Y */
+            OPCODE_CASE(0xb6)   /* LDX $nn,Y */
                 LDX(LOAD_ZERO_Y(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb7:          /* LAX $nn,Y */
+            OPCODE_CASE(0xb7)   /* LAX $nn,Y */
                 LAX(LOAD_ZERO_Y(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xb8:          /* CLV */
+            OPCODE_CASE(0xb8)   /* CLV */
                 CLV();
-                break;
+                OPCODE_BREAK;
 
-            case 0xb9:          /* LDA $nnnn,Y */
+            OPCODE_CASE(0xb9)   /* LDA $nnnn,Y */
                 LDA(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xba:          /* TSX */
+            OPCODE_CASE(0xba)   /* TSX */
                 TSX();
-                break;
+                OPCODE_BREAK;
 
-            case 0xbb:          /* LAS $nnnn,Y */
+            OPCODE_CASE(0xbb)   /* LAS $nnnn,Y */
                 LAS(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xbc:          /* LDY $nnnn,X */
+            OPCODE_CASE(0xbc)   /* LDY $nnnn,X */
                 LDY(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xbd:          /* LDA $nnnn,X */
+            OPCODE_CASE(0xbd)   /* LDA $nnnn,X */
                 LDA(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xbe:          /* LDX $nnnn,Y */
+            OPCODE_CASE(0xbe)   /* LDX $nnnn,Y */
                 LDX(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xbf:          /* LAX $nnnn,Y */
+            OPCODE_CASE(0xbf)   /* LAX $nnnn,Y */
                 LAX(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc0:          /* CPY #$nn */
+            OPCODE_CASE(0xc0)   /* CPY #$nn */
                 CPY(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc1:          /* CMP ($nn,X) */
+            OPCODE_CASE(0xc1)   /* CMP ($nn,X) */
                 CMP(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc3:          /* DCP ($nn,X) */
+            OPCODE_CASE(0xc3)   /* DCP ($nn,X) */
                 DCP(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc4:          /* CPY $nn */
+            OPCODE_CASE(0xc4)   /* CPY $nn */
                 CPY(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc5:          /* CMP $nn */
+            OPCODE_CASE(0xc5)   /* CMP $nn */
                 CMP(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc6:          /* DEC $nn */
+            OPCODE_CASE(0xc6)   /* DEC $nn */
                 DEC(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc7:          /* DCP $nn */
+            OPCODE_CASE(0xc7)   /* DCP $nn */
                 DCP(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xc8:          /* INY */
+            OPCODE_CASE(0xc8)   /* INY */
                 INY();
-                break;
+                OPCODE_BREAK;
 
-            case 0xc9:          /* CMP #$nn */
+            OPCODE_CASE(0xc9)   /* CMP #$nn */
                 CMP(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xca:          /* DEX */
+            OPCODE_CASE(0xca)   /* DEX */
                 DEX();
-                break;
+                OPCODE_BREAK;
 
-            case 0xcb:          /* SBX #$nn */
+            OPCODE_CASE(0xcb)   /* SBX #$nn */
                 SBX(p1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xcc:          /* CPY $nnnn */
+            OPCODE_CASE(0xcc)   /* CPY $nnnn */
                 CPY(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xcd:          /* CMP $nnnn */
+            OPCODE_CASE(0xcd)   /* CMP $nnnn */
                 CMP(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xce:          /* DEC $nnnn */
+            OPCODE_CASE(0xce)   /* DEC $nnnn */
                 DEC(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xcf:          /* DCP $nnnn */
+            OPCODE_CASE(0xcf)   /* DCP $nnnn */
                 DCP(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd0:          /* BNE $nnnn */
+            OPCODE_CASE(0xd0)   /* BNE $nnnn */
                 BRANCH(!LOCAL_ZERO(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd1:          /* CMP ($nn),Y */
+            OPCODE_CASE(0xd1)   /* CMP ($nn),Y */
                 CMP(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd3:          /* DCP ($nn),Y */
+            OPCODE_CASE(0xd3)   /* DCP ($nn),Y */
                 DCP_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd5:          /* CMP $nn,X */
+            OPCODE_CASE(0xd5)   /* CMP $nn,X */
                 CMP(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd6:          /* DEC $nn,X */
+            OPCODE_CASE(0xd6)   /* DEC $nn,X */
                 DEC((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd7:          /* DCP $nn,X */
+            OPCODE_CASE(0xd7)   /* DCP $nn,X */
                 DCP((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xd8:          /* CLD */
+            OPCODE_CASE(0xd8)   /* CLD */
                 CLD();
-                break;
+                OPCODE_BREAK;
 
-            case 0xd9:          /* CMP $nnnn,Y */
+            OPCODE_CASE(0xd9)   /* CMP $nnnn,Y */
                 CMP(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xdb:          /* DCP $nnnn,Y */
+            OPCODE_CASE(0xdb)   /* DCP $nnnn,Y */
                 DCP(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0xdd:          /* CMP $nnnn,X */
+            OPCODE_CASE(0xdd)   /* CMP $nnnn,X */
                 CMP(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xde:          /* DEC $nnnn,X */
+            OPCODE_CASE(0xde)   /* DEC $nnnn,X */
                 DEC(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0xdf:          /* DCP $nnnn,X */
+            OPCODE_CASE(0xdf)   /* DCP $nnnn,X */
                 DCP(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe0:          /* CPX #$nn */
+            OPCODE_CASE(0xe0)   /* CPX #$nn */
                 CPX(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe1:          /* SBC ($nn,X) */
+            OPCODE_CASE(0xe1)   /* SBC ($nn,X) */
                 SBC(LOAD_IND_X(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe3:          /* ISB ($nn,X) */
+            OPCODE_CASE(0xe3)   /* ISB ($nn,X) */
                 ISB(LOAD_ZERO_ADDR(p1 + reg_x_read), 3, CLK_IND_X_RMW, 2, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe4:          /* CPX $nn */
+            OPCODE_CASE(0xe4)   /* CPX $nn */
                 CPX(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe5:          /* SBC $nn */
+            OPCODE_CASE(0xe5)   /* SBC $nn */
                 SBC(LOAD_ZERO(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe6:          /* INC $nn */
+            OPCODE_CASE(0xe6)   /* INC $nn */
                 INC(p1, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe7:          /* ISB $nn */
+            OPCODE_CASE(0xe7)   /* ISB $nn */
                 ISB(p1, 0, CLK_ZERO_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xe8:          /* INX */
+            OPCODE_CASE(0xe8)   /* INX */
                 INX();
-                break;
+                OPCODE_BREAK;
 
-            case 0xe9:          /* SBC #$nn */
+            OPCODE_CASE(0xe9)   /* SBC #$nn */
                 SBC(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xea:          /* NOP */
+            OPCODE_CASE(0xea)   /* NOP */
                 NOP();
-                break;
+                OPCODE_BREAK;
 
-            case 0xeb:          /* USBC #$nn (same as SBC) */
+            OPCODE_CASE(0xeb)   /* USBC #$nn (same as SBC) */
                 SBC(p1, 0, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xec:          /* CPX $nnnn */
+            OPCODE_CASE(0xec)   /* CPX $nnnn */
                 CPX(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xed:          /* SBC $nnnn */
+            OPCODE_CASE(0xed)   /* SBC $nnnn */
                 SBC(LOAD(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xee:          /* INC $nnnn */
+            OPCODE_CASE(0xee)   /* INC $nnnn */
                 INC(p2, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xef:          /* ISB $nnnn */
+            OPCODE_CASE(0xef)   /* ISB $nnnn */
                 ISB(p2, 0, CLK_ABS_RMW2, 3, LOAD_ABS, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf0:          /* BEQ $nnnn */
+            OPCODE_CASE(0xf0)   /* BEQ $nnnn */
                 BRANCH(LOCAL_ZERO(), p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf1:          /* SBC ($nn),Y */
+            OPCODE_CASE(0xf1)   /* SBC ($nn),Y */
                 SBC(LOAD_IND_Y(p1), 1, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf3:          /* ISB ($nn),Y */
+            OPCODE_CASE(0xf3)   /* ISB ($nn),Y */
                 ISB_IND_Y(p1);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf5:          /* SBC $nn,X */
+            OPCODE_CASE(0xf5)   /* SBC $nn,X */
                 SBC(LOAD_ZERO_X(p1), CLK_ZERO_I2, 2);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf6:          /* INC $nn,X */
+            OPCODE_CASE(0xf6)   /* INC $nn,X */
                 INC((p1 + reg_x_read) & 0xff, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf7:          /* ISB $nn,X */
+            OPCODE_CASE(0xf7)   /* ISB $nn,X */
                 ISB((p1 + reg_x_read) & 0xff, 0, CLK_ZERO_I_RMW, 2, LOAD_ZERO, STORE_ABS);
-                break;
+                OPCODE_BREAK;
 
-            case 0xf8:          /* SED */
+            OPCODE_CASE(0xf8)   /* SED */
                 SED();
-                break;
+                OPCODE_BREAK;
 
-            case 0xf9:          /* SBC $nnnn,Y */
+            OPCODE_CASE(0xf9)   /* SBC $nnnn,Y */
                 SBC(LOAD_ABS_Y(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xfb:          /* ISB $nnnn,Y */
+            OPCODE_CASE(0xfb)   /* ISB $nnnn,Y */
                 ISB(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_Y_RMW, STORE_ABS_Y_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0xfd:          /* SBC $nnnn,X */
+            OPCODE_CASE(0xfd)   /* SBC $nnnn,X */
                 SBC(LOAD_ABS_X(p2), 1, 3);
-                break;
+                OPCODE_BREAK;
 
-            case 0xfe:          /* INC $nnnn,X */
+            OPCODE_CASE(0xfe)   /* INC $nnnn,X */
                 INC(p2, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
 
-            case 0xff:          /* ISB $nnnn,X */
+            OPCODE_CASE(0xff)   /* ISB $nnnn,X */
                 ISB(p2, 0, CLK_ABS_I_RMW2, 3, LOAD_ABS_X_RMW, STORE_ABS_X_RMW);
-                break;
+                OPCODE_BREAK;
         }
+#ifdef CPU_LABEL_DISPATCH
+opcode_done:
+        ;
+#endif
     }
 }
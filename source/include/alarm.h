@@ -45,7 +45,7 @@ struct alarm_s {
     /* Callback to be called when the alarm is dispatched.  */
     alarm_callback_t callback;
 
-    /* Index into the pending alarm list.  If < 0, the alarm is not
+    /* Index into the pending alarm heap.  If < 0, the alarm is not
        pending.  */
     int pending_idx;
 
@@ -63,6 +63,13 @@ struct pending_alarms_s {
 
     /* Clock tick at which this alarm should be activated.  */
     CLOCK clk;
+
+    /* Position the alarm would have in an unordered array of the pending
+       alarms, appended when set and replaced by the last one when unset.
+       Of the alarms due on the same clock, the one with the highest slot
+       goes first, as it did when the next alarm was found by scanning such
+       an array.  */
+    unsigned int slot;
 };
 typedef struct pending_alarms_s pending_alarms_t;
 
@@ -74,16 +81,22 @@ struct alarm_context_s {
     /* Alarm list.  */
     struct alarm_s *alarms;
 
-    /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+    /* Pending alarms, kept as a binary min-heap ordered by `clk' and then
+       by `slot', so the earliest alarm is always at index 0.  Statically
+       allocated because it's slightly faster this way.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
+    /* The pending alarm in each slot.  */
+    struct alarm_s *slot_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
+
     /* Clock tick for the next pending alarm.  */
     CLOCK next_pending_alarm_clk;
 
-    /* Pending alarm number.  */
-    int next_pending_alarm_idx;
+    /* Next alarm to dispatch, NULL if none is pending.  Usually the one at
+       index 0; an alarm set for the same clock later does not take its
+       place.  */
+    struct alarm_s *next_pending_alarm;
 };
 typedef struct alarm_context_s alarm_context_t;
 
@@ -109,38 +122,97 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
     return context->next_pending_alarm_clk;
 }
 
-inline static void alarm_context_update_next_pending(alarm_context_t *context)
+/* Whether heap entry `a' goes before `b'.  */
+inline static int alarm_heap_before(const pending_alarms_t *a,
+                                    const pending_alarms_t *b)
 {
-    CLOCK next_pending_alarm_clk = (CLOCK)~0L;
-    int next_pending_alarm_idx;
-    unsigned int i;
+    return a->clk < b->clk || (a->clk == b->clk && a->slot > b->slot);
+}
 
-    next_pending_alarm_idx = context->next_pending_alarm_idx;
+/* Store `entry' at heap position `idx'.  */
+inline static void alarm_heap_put(alarm_context_t *context, unsigned int idx,
+                                  const pending_alarms_t *entry)
+{
+    context->pending_alarms[idx] = *entry;
+    entry->alarm->pending_idx = (int)idx;
+}
+
+/* Move the entry at `idx' towards the root while it goes before its
+   parent.  */
+inline static void alarm_heap_sift_up(alarm_context_t *context, unsigned int idx)
+{
+    pending_alarms_t entry = context->pending_alarms[idx];
 
-    for (i = 0; i < context->num_pending_alarms; i++) {
-        CLOCK pending_clk = context->pending_alarms[i].clk;
+    while (idx > 0) {
+        unsigned int parent = (idx - 1) >> 1;
 
-        if (pending_clk <= next_pending_alarm_clk) {
-            next_pending_alarm_clk = pending_clk;
-            next_pending_alarm_idx = (int)i;
+        if (!alarm_heap_before(&entry, &context->pending_alarms[parent])) {
+            break;
         }
+        alarm_heap_put(context, idx, &context->pending_alarms[parent]);
+        idx = parent;
     }
+    alarm_heap_put(context, idx, &entry);
+}
 
-    context->next_pending_alarm_clk = next_pending_alarm_clk;
-    context->next_pending_alarm_idx = next_pending_alarm_idx;
+/* Move the entry at `idx' towards the leaves while a child goes before
+   it.  */
+inline static void alarm_heap_sift_down(alarm_context_t *context, unsigned int idx)
+{
+    pending_alarms_t entry = context->pending_alarms[idx];
+    unsigned int num = context->num_pending_alarms;
+
+    while (1) {
+        unsigned int child = (idx << 1) + 1;
+
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num
+            && alarm_heap_before(&context->pending_alarms[child + 1],
+                                 &context->pending_alarms[child])) {
+            child++;
+        }
+        if (!alarm_heap_before(&context->pending_alarms[child], &entry)) {
+            break;
+        }
+        alarm_heap_put(context, idx, &context->pending_alarms[child]);
+        idx = child;
+    }
+    alarm_heap_put(context, idx, &entry);
+}
+
+/* Restore the heap order around `idx' after its key has changed.  */
+inline static void alarm_heap_fix(alarm_context_t *context, unsigned int idx)
+{
+    if (idx > 0 && alarm_heap_before(&context->pending_alarms[idx],
+                                     &context->pending_alarms[(idx - 1) >> 1])) {
+        alarm_heap_sift_up(context, idx);
+    } else {
+        alarm_heap_sift_down(context, idx);
+    }
+}
+
+inline static void alarm_context_update_next_pending(alarm_context_t *context)
+{
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm = context->pending_alarms[0].alarm;
+    } else {
+        context->next_pending_alarm_clk = (CLOCK)~0L;
+        context->next_pending_alarm = NULL;
+    }
 }
 
 inline static void alarm_context_dispatch(alarm_context_t *context,
                                           CLOCK cpu_clk)
 {
     CLOCK offset;
-    int idx;
     alarm_t *alarm;
 
     offset = (CLOCK)(cpu_clk - context->next_pending_alarm_clk);
 
-    idx = context->next_pending_alarm_idx;
-    alarm = context->pending_alarms[idx].alarm;
+    alarm = context->next_pending_alarm;
 
     (alarm->callback)(offset, alarm->data);
 }
@@ -154,33 +226,43 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
     idx = alarm->pending_idx;
 
     if (idx < 0) {
-        int new_idx;
+        pending_alarms_t entry;
+        unsigned int new_idx;
 
         /* Not pending yet: add.  */
 
-        new_idx = (int)(context->num_pending_alarms);
-        if (new_idx >= (int)ALARM_CONTEXT_MAX_PENDING_ALARMS) {
+        new_idx = context->num_pending_alarms;
+        if (new_idx >= ALARM_CONTEXT_MAX_PENDING_ALARMS) {
             alarm_log_too_many_alarms();
             return;
         }
 
-        context->pending_alarms[new_idx].alarm = alarm;
-        context->pending_alarms[new_idx].clk = cpu_clk;
-
+        entry.alarm = alarm;
+        entry.clk = cpu_clk;
+        entry.slot = new_idx;
+        context->slot_alarms[new_idx] = alarm;
         context->num_pending_alarms++;
+        alarm_heap_put(context, new_idx, &entry);
+        alarm_heap_sift_up(context, new_idx);
 
         if (cpu_clk < context->next_pending_alarm_clk) {
             context->next_pending_alarm_clk = cpu_clk;
-            context->next_pending_alarm_idx = new_idx;
+            context->next_pending_alarm = alarm;
         }
-
-        alarm->pending_idx = new_idx;
     } else {
         /* Already pending: modify.  */
 
+        CLOCK old_clk = context->pending_alarms[idx].clk;
+
         context->pending_alarms[idx].clk = cpu_clk;
+        if (cpu_clk < old_clk) {
+            alarm_heap_sift_up(context, (unsigned int)idx);
+        } else {
+            alarm_heap_sift_down(context, (unsigned int)idx);
+        }
+
         if (context->next_pending_alarm_clk > cpu_clk
-            || idx == context->next_pending_alarm_idx) {
+            || alarm == context->next_pending_alarm) {
             alarm_context_update_next_pending(context);
         }
     }
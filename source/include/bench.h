@@ -0,0 +1,68 @@
+/*
+ * bench.h - Headless throughput benchmark
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BENCH_H
+#define VICE_BENCH_H
+
+#include "types.h"
+
+/* Subsystems the host time is split into.  BENCH_CPU is the base: every
+   tick not claimed by one of the others is charged to it. */
+#define BENCH_CPU       0
+#define BENCH_DRIVE     1
+#define BENCH_SOUND     2
+#define BENCH_VIDEO     3
+#define BENCH_SYNC      4
+#define BENCH_NUM_SUBSYSTEMS 5
+
+/* host timer, available in every build */
+extern uint64_t bench_ticks(void);
+extern uint64_t bench_ticks_per_second(void);
+
+#ifdef VICE_BENCH
+
+extern int bench_resources_init(void);
+extern void bench_resources_shutdown(void);
+
+extern void bench_init(void);
+extern void bench_enter(int subsystem);
+extern void bench_leave(int subsystem);
+
+/* Called once per emulated frame from vsync_do_vsync(); prints the
+   report and exits once the configured number of frames has run. */
+extern void bench_vsync(void);
+
+/* Machine specific micro-benchmarks are registered at startup, see the
+   "BenchMicro" resource.  */
+extern void bench_register_micro(const char *name, void (*run)(void));
+
+#define BENCH_ENTER(s) bench_enter(s)
+#define BENCH_LEAVE(s) bench_leave(s)
+
+#else
+
+#define BENCH_ENTER(s)
+#define BENCH_LEAVE(s)
+
+#endif
+
+#endif
@@ -27,6 +27,10 @@
 #ifndef VICE_C64_SNAPSHOT_H
 #define VICE_C64_SNAPSHOT_H
 
+#include "types.h"
+
 extern int c64_snapshot_write(const char *name, int save_roms, int save_disks, int save_settings, int event_mode);
+extern int c64_snapshot_write_memory(uint8_t **buffer, size_t *size, size_t *buffer_size);
 extern int c64_snapshot_read(const char *name, int event_mode);
+extern int c64_snapshot_read_memory(const uint8_t *data, size_t size);
 #endif
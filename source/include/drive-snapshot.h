@@ -33,4 +33,8 @@ extern int drive_snapshot_write_module(struct snapshot_s *s, int save_disks,
                                        int save_roms);
 extern int drive_snapshot_read_module(struct snapshot_s *s);
 
+/* For in-memory snapshots, which leave the disk images alone.  */
+extern int drive_snapshot_write_quick_module(struct snapshot_s *s);
+extern int drive_snapshot_read_quick_module(struct snapshot_s *s);
+
 #endif
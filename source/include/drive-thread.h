@@ -0,0 +1,65 @@
+/*
+ * drive-thread.h - Running the drive CPUs on a second host thread.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_DRIVE_THREAD_H
+#define VICE_DRIVE_THREAD_H
+
+#include "types.h"
+
+struct drive_context_s;
+
+typedef struct drive_thread_stats_s {
+    /* slices handed to the drive thread */
+    unsigned int slices;
+
+    /* slices not handed over because the previous one wasn't done yet */
+    unsigned int busy;
+
+    /* times the main CPU had to wait for the drive thread, and the host
+       ticks (see bench_ticks()) spent waiting */
+    unsigned int waits;
+    uint64_t wait_ticks;
+} drive_thread_stats_t;
+
+extern int drive_thread_resources_init(void);
+extern void drive_thread_init(void);
+extern void drive_thread_shutdown(void);
+
+/* Called at every vsync to restart the slice alarm.  */
+extern void drive_thread_vsync(void);
+
+/* Wait until the drive thread has caught up with the slice it was given.
+   Must be called before the main thread looks at or changes anything
+   belonging to a drive.  */
+extern void drive_thread_sync(void);
+
+/* Whether the caller is the drive thread, which must not look at the main
+   CPU or call into the UI.  */
+extern int drive_thread_is_current(void);
+
+/* Called on the drive thread when a drive CPU jams; the jam is reported by
+   the main thread once it has collected the slice.  */
+extern void drive_thread_jam(struct drive_context_s *drv);
+
+extern void drive_thread_get_stats(drive_thread_stats_t *stats);
+
+#endif
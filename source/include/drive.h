@@ -218,6 +218,14 @@ typedef struct drive_s {
     /* Activates the byte ready line.  */
     int byte_ready_active;
 
+    /* Set whenever rotation_rotate_disk() looks at the spinning disk;
+       cleared by the drive CPU idle loop detector.  */
+    int rotation_polled;
+
+    /* Set whenever the drive CPU reads a VIA timer counter, whose value
+       follows the clock; cleared by the drive CPU idle loop detector.  */
+    int timer_polled;
+
     /* Clock frequency of this drive in 1MHz units.  */
     int clock_frequency;
 
@@ -278,6 +286,10 @@ typedef struct drive_s {
     /* Is P64 image dirty?  */
     int P64_dirty;
 
+    /* Counts image changes, so an in-memory snapshot can tell whether
+       the image is still the one it was taken with.  */
+    unsigned int image_serial;
+
     /* is this disk read only?  */
     int read_only;
 
@@ -54,6 +54,10 @@ extern void drivecpu_reset_clk(struct drive_context_s *drv);
 extern void drivecpu_trigger_reset(unsigned int dnr);
 extern void drivecpu_set_overflow(struct drive_context_s *drv);
 
+/* Report a JAM of the drive CPU and reset if asked to; returns the JAM_*
+   action chosen.  */
+extern unsigned int drivecpu_jam(struct drive_context_s *drv);
+
 extern void drivecpu_execute(struct drive_context_s *drv, CLOCK clk_value);
 extern int drivecpu_snapshot_write_module(struct drive_context_s *drv,
                                           struct snapshot_s *s);
@@ -98,6 +98,15 @@ typedef struct drivecpu_context_s {
 
     uint8_t *pageone;        /* init to NULL */
 
+    /* Idle loop detector state, see drivecpu_idle_detect().  */
+    unsigned int idle_last_pc;   /* PC at the previous instruction boundary */
+    unsigned int idle_loop_pc;   /* head of the loop being watched */
+    int idle_passes;             /* identical passes through the head so far */
+    int idle_store;              /* non-zero if memory was written since */
+    CLOCK idle_loop_clk;         /* clock at the last pass through the head */
+    CLOCK idle_period;           /* cycles taken by the last pass */
+    mos6510_regs_t idle_regs;    /* registers at the last pass */
+
     int monspace;         /* init to e_disk[89]_space */
 
     char *snap_module_name;
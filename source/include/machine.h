@@ -142,6 +142,16 @@ extern int machine_write_snapshot(const char *name, int save_roms,
 /* Read a snapshot.  */
 extern int machine_read_snapshot(const char *name, int even_mode);
 
+/* Write a snapshot of the machine state (without ROMs, disk images and
+   settings) to memory.  `*buffer' (of `*buffer_size' bytes) may be NULL or
+   the buffer of an earlier call to reuse; on return it holds the snapshot of
+   `*size' bytes and must be freed with lib_free().  */
+extern int machine_write_snapshot_memory(uint8_t **buffer, size_t *size,
+                                         size_t *buffer_size);
+
+/* Read a snapshot written by machine_write_snapshot_memory().  */
+extern int machine_read_snapshot_memory(const uint8_t *data, size_t size);
+
 /* handle pending interrupts - needed by libsid.a.  */
 extern void machine_handle_pending_alarms(int num_write_cycles);
 
@@ -112,14 +112,37 @@
 #endif /* C64DTV */
 #endif /* FEATURE_CPUMEMHISTORY */
 
+/* Plain RAM and ROM pages are accessed through the direct tables, only
+   I/O, cartridge and watchpoint pages call the memory functions.  */
 #ifndef STORE
+inline static void maincpu_store(uint16_t addr, uint8_t value)
+{
+    uint8_t *p = _mem_write_direct_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        p[addr] = value;
+    } else {
+        (*_mem_write_tab_ptr[addr >> 8])(addr, value);
+    }
+}
+
 #define STORE(addr, value) \
-    (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value))
+    maincpu_store((uint16_t)(addr), (uint8_t)(value))
 #endif
 
 #ifndef LOAD
+inline static uint8_t maincpu_load(uint16_t addr)
+{
+    uint8_t *p = _mem_read_direct_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        return p[addr];
+    }
+    return (*_mem_read_tab_ptr[addr >> 8])(addr);
+}
+
 #define LOAD(addr) \
-    (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr))
+    maincpu_load((uint16_t)(addr))
 #endif
 
 #ifndef STORE_ZERO
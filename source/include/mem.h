@@ -40,6 +40,12 @@ typedef store_func_t *store_func_ptr_t;
 extern read_func_ptr_t *_mem_read_tab_ptr;
 extern store_func_ptr_t *_mem_write_tab_ptr;
 
+/* Per-page base pointers the main CPU can load from and store to directly
+   (`base[addr]'), for pages whose read or store function has no side
+   effects.  NULL means the function in the tables above must be called.  */
+extern uint8_t **_mem_read_direct_tab_ptr;
+extern uint8_t **_mem_write_direct_tab_ptr;
+
 extern uint8_t mem_ram[];
 extern uint8_t *mem_page_zero;
 extern uint8_t *mem_page_one;
@@ -107,6 +107,26 @@ struct raster_cache_s {
 };
 typedef struct raster_cache_s raster_cache_t;
 
+/* How the lines were drawn, see raster_cache_get_stats().  */
+#define RASTER_CACHE_STATS_MODES  16
+
+typedef struct raster_cache_stats_s {
+    /* visible lines drawn with the cache enabled, by video mode: found
+       unchanged, partly drawn again, and drawn again as a whole */
+    unsigned long hits[RASTER_CACHE_STATS_MODES];
+    unsigned long partial[RASTER_CACHE_STATS_MODES];
+    unsigned long misses[RASTER_CACHE_STATS_MODES];
+
+    /* pixels drawn again on the partly drawn lines */
+    unsigned long partial_pixels;
+
+    /* visible lines that could not use the cache: mid-line changes, open
+       borders or the cache being disabled */
+    unsigned long uncached;
+} raster_cache_stats_t;
+
+extern raster_cache_stats_t raster_cache_stats;
+
 struct raster_sprite_status_s;
 
 extern void raster_cache_new(raster_cache_t *cache,
@@ -116,4 +136,8 @@ extern void raster_cache_destroy(raster_cache_t *cache,
 extern void raster_cache_realloc(raster_cache_t **cache,
                                  unsigned int screen_height);
 
+/* The counts for all the video chips together.  */
+extern void raster_cache_get_stats(raster_cache_stats_t *stats);
+extern void raster_cache_reset_stats(void);
+
 #endif
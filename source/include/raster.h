@@ -162,6 +162,14 @@ struct raster_s {
        is valid again.  */
     unsigned int num_cached_lines;
 
+    /* With the video thread, the frame is drawn into two draw buffers in
+       turn; this is the cache of the buffer not being drawn into, with
+       its `dont_cache' and `num_cached_lines' (see raster_swap_cache()).  */
+    struct raster_cache_s *cache_back;
+    unsigned int cache_back_lines;
+    int dont_cache_back;
+    unsigned int num_cached_lines_back;
+
     /* Area to update.  */
     struct raster_canvas_area_s *update_area;
 
@@ -214,6 +222,7 @@ extern void raster_set_geometry(raster_t *raster,
 extern void raster_new_cache(raster_t *raster, unsigned int screen_height);
 extern void raster_draw_buffer_ptr_update(raster_t *raster);
 extern void raster_force_repaint(raster_t *raster);
+extern void raster_swap_cache(raster_t *raster);
 extern void raster_set_title(raster_t *raster, const char *name);
 extern void raster_skip_frame(raster_t *raster, int skip);
 extern void raster_enable_cache(raster_t *raster, int enable);
@@ -79,4 +79,9 @@ extern void render_32_1x1_pal(video_render_color_tables_t *color_tab,
                               const unsigned int xt, const unsigned int yt,
                               const unsigned int pitchs,
                               const unsigned int pitcht, video_render_config_t *config);
+
+/* Recalculate the lookup tables of the 1x1 PAL renderers from the y, u
+   and v tables, whenever those have changed.  */
+extern void render_1x1_pal_update_tables(video_render_color_tables_t *color_tab);
+
 #endif
@@ -27,8 +27,13 @@
 #ifndef VICE_RESID_H
 #define VICE_RESID_H
 
+#include "sid.h"
 #include "types.h"
 
 extern sid_engine_t resid_hooks;
 
+#ifdef VICE_BENCH
+extern void resid_bench(void);
+#endif
+
 #endif
@@ -0,0 +1,64 @@
+/*
+ * rewind.h - Rewind buffer of in-memory snapshots
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_REWIND_H
+#define VICE_REWIND_H
+
+#include "types.h"
+
+/* a full snapshot every this many steps */
+#define REWIND_KEYFRAME_STEPS   10
+
+/* "RewindDepth" must hold at least one keyframe with its delta steps,
+   otherwise the steps being taken are dropped as soon as they are made */
+#define REWIND_DEPTH_MIN        REWIND_KEYFRAME_STEPS
+
+typedef struct rewind_stats_s {
+    /* snapshots taken and the host ticks (see bench_ticks()) spent on them */
+    unsigned int captures;
+    uint64_t capture_ticks;
+
+    /* total size of those snapshots, before and after delta compression */
+    uint64_t raw_bytes;
+    uint64_t stored_bytes;
+
+    /* steps currently held and the memory they use */
+    unsigned int steps;
+    size_t bytes;
+} rewind_stats_t;
+
+extern int rewind_resources_init(void);
+extern void rewind_shutdown(void);
+
+/* Called once per frame from vsync_do_vsync(); takes a step every
+   "RewindInterval" frames, or goes back one step if requested.  */
+extern void rewind_vsync(void);
+
+/* Go back to the most recent step at the next frame.  */
+extern void rewind_step_back(void);
+
+/* Drop all steps.  */
+extern void rewind_reset(void);
+
+extern void rewind_get_stats(rewind_stats_t *stats);
+
+#endif
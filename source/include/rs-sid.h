@@ -90,6 +90,11 @@ public:
   State read_state();
   void write_state(const State& state);
 
+  // Vectorized FIR convolution for the resampling methods, used by all
+  // SIDs.  Returns false if there is none for this CPU.
+  static bool enable_simd(bool enable);
+  static const char* convolution_name();
+
   // 16-bit input (EXT IN).
   void input(short sample);
 
@@ -0,0 +1,53 @@
+/*
+ * runahead.h - Run-ahead input latency reduction
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RUNAHEAD_H
+#define VICE_RUNAHEAD_H
+
+#include "types.h"
+
+typedef struct runahead_stats_s {
+    /* frames that were run ahead for */
+    unsigned int frames;
+
+    /* host ticks (see bench_ticks()) spent on them in total, of which for
+       saving and restoring the machine state, and the most for one frame */
+    uint64_t ticks;
+    uint64_t state_ticks;
+    uint64_t max_ticks;
+} runahead_stats_t;
+
+extern int runahead_resources_init(void);
+extern void runahead_shutdown(void);
+
+/* Called first thing in vsync_do_vsync().  Returns 1 for a frame emulated
+   ahead of time, which must not be synchronized; `*skip_next_frame' is then
+   set to whether the next frame is to be drawn.  */
+extern int runahead_vsync(int *skip_next_frame);
+
+/* Called at the end of vsync_do_vsync() for a real frame, starts running
+   ahead.  Returns whether the next frame is to be drawn.  */
+extern int runahead_frame_done(int skip_next_frame);
+
+extern void runahead_get_stats(runahead_stats_t *stats);
+
+#endif
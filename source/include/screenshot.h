@@ -107,6 +107,22 @@ typedef struct screenshot_s {
 #define SCREENSHOT_MODE_RGB32   1
 #define SCREENSHOT_MODE_RGB24   2
 
+typedef struct screenshot_record_stats_s {
+    /* vsyncs with a new frame, and without one (skipped frames, or frames
+       dropped because the writer was behind) */
+    unsigned int frames;
+    unsigned int repeats;
+
+    /* frames not copied because no slot was free */
+    unsigned int dropped;
+
+    /* frames of samples not recorded */
+    unsigned int sound_dropped;
+
+    /* host ticks (see bench_ticks()) the writer spent on frames */
+    uint64_t write_ticks;
+} screenshot_record_stats_t;
+
 /* Functions called by external emulator code.  */
 extern int screenshot_init(void);
 extern void screenshot_shutdown(void);
@@ -118,6 +134,12 @@ extern int screenshot_is_recording(void);
 extern void screenshot_prepare_reopen(void);
 extern void screenshot_try_reopen(void);
 
+/* Recording with the "AVI" driver: the raster hands over every finished
+   frame of a canvas, and sound_flush() the samples it writes.  */
+extern void screenshot_record_frame(struct video_canvas_s *canvas, int skipped);
+extern void screenshot_record_sound(const int16_t *samples, int nr, int channels, int rate);
+extern void screenshot_record_get_stats(screenshot_record_stats_t *stats);
+
 #ifdef FEATURE_CPUMEMHISTORY
 extern int memmap_screenshot_save(const char *drvname, const char *filename, int x_size, int y_size, uint8_t *gfx, uint8_t *palette);
 #endif
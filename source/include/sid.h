@@ -129,6 +129,8 @@ extern uint8_t sid_sound_machine_read(sound_t *psid, uint16_t addr);
 extern void sid_sound_machine_store(sound_t *psid, uint16_t addr, uint8_t byte);
 extern void sid_sound_machine_reset(sound_t *psid, CLOCK cpu_clk);
 extern int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int sound_output_channels, int sound_chip_channels, int *delta_t);
+extern int sid_sound_machine_calculate_chip_samples(sound_t *psid, int16_t *pbuf, int nr, int *delta_t);
+extern void sid_sound_machine_mix_chip_samples(int16_t **chip_buf, int16_t *pbuf, int nr, int sound_output_channels, int sound_chip_channels);
 extern void sid_sound_machine_prevent_clk_overflow(sound_t *psid, CLOCK sub);
 extern char *sid_sound_machine_dump_state(sound_t *psid);
 extern int sid_sound_machine_cycle_based(void);
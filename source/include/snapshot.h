@@ -145,6 +145,24 @@ extern snapshot_t *snapshot_open(const char *filename,
                                  const char *snapshot_machine_name);
 extern int snapshot_close(snapshot_t *s);
 
+/* Snapshots kept in memory instead of a file, for quick-save, rewind and
+   run-ahead.  snapshot_memory_create() collects the data in a buffer that
+   grows as needed; `buffer' may be NULL or a lib_malloc()ed buffer of
+   `buffer_size' bytes (e.g. one returned by an earlier snapshot) to reuse.
+   snapshot_memory_take() closes such a snapshot and hands the buffer, to be
+   freed with lib_free(), to the caller.  snapshot_memory_open() reads a
+   snapshot from a caller supplied buffer, which must stay valid until
+   snapshot_close().  */
+extern snapshot_t *snapshot_memory_create(uint8_t *buffer, size_t buffer_size,
+                                          uint8_t major_version, uint8_t minor_version,
+                                          const char *snapshot_machine_name);
+extern uint8_t *snapshot_memory_take(snapshot_t *s, size_t *size_return,
+                                     size_t *buffer_size_return);
+extern snapshot_t *snapshot_memory_open(const uint8_t *data, size_t size,
+                                        uint8_t *major_version_return,
+                                        uint8_t *minor_version_return,
+                                        const char *snapshot_machine_name);
+
 extern void snapshot_set_error(int error);
 
 extern int snapshot_version_at_least(uint8_t major_version, uint8_t minor_version, uint8_t major_version_required, uint8_t minor_version_required);
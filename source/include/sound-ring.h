@@ -0,0 +1,73 @@
+/*
+ * sound-ring.h - Handing samples to pulling sound devices.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SOUND_RING_H
+#define VICE_SOUND_RING_H
+
+#include "types.h"
+
+typedef struct sound_ring_stats_s {
+    /* frames put into the ring by sound_flush() and taken by the device */
+    unsigned int written;
+    unsigned int pulled;
+
+    /* frames that didn't fit into the ring and were dropped */
+    unsigned int overrun_frames;
+
+    /* times the device pulled, times it got less than it asked for, and
+       the frames it had to make up */
+    unsigned int pulls;
+    unsigned int underruns;
+    unsigned int underrun_frames;
+
+    /* frames in the ring whenever the device pulled: fewest, most and in
+       all, for the average */
+    unsigned int fill_min;
+    unsigned int fill_max;
+    uint64_t fill_sum;
+
+    /* frames the ring holds, and the fill sound_flush() aims for (the
+       latency target, "SoundBufferSize") */
+    unsigned int size;
+    unsigned int target;
+    int rate;
+} sound_ring_stats_t;
+
+/* Set up the ring for `channels' channels, aiming at `target' frames of
+   latency.  */
+extern int sound_ring_open(int target, int channels, int rate);
+extern void sound_ring_close(void);
+
+/* Producer side, used by sound_flush() in place of the write() and
+   bufferspace() of a pulling device.  Never blocks.  */
+extern int sound_ring_write(int16_t *pbuf, size_t nr);
+extern int sound_ring_bufferspace(void);
+
+/* Consumer side, for the device's own thread or callback: fills `pbuf'
+   with `nr' samples (all channels, as for write()) and returns how many
+   of them came from the ring; the rest repeats the last frame (silence if
+   the ring isn't open).  */
+extern int sound_ring_pull(int16_t *pbuf, size_t nr);
+
+extern void sound_ring_get_stats(sound_ring_stats_t *stats);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * sound-thread.h - Rendering the sound chips on worker threads.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SOUND_THREAD_H
+#define VICE_SOUND_THREAD_H
+
+#include "types.h"
+
+typedef struct sound_thread_stats_s {
+    /* times sound_thread_run() was called, and the jobs it ran */
+    unsigned int runs;
+    unsigned int jobs;
+
+    /* jobs that were run by the worker threads */
+    unsigned int thread_jobs;
+
+    /* times the caller had to wait for the workers after doing its own
+       share, and the host ticks (see bench_ticks()) spent waiting */
+    unsigned int waits;
+    uint64_t wait_ticks;
+} sound_thread_stats_t;
+
+/* Run `job(0)' ... `job(jobs - 1)', spread over the worker threads and the
+   calling thread, and return once all of them are done.  The jobs must not
+   touch each other's data.  If there are no workers (they need a New 3DS)
+   the calling thread runs all of them.  */
+extern void sound_thread_run(void (*job)(int), int jobs);
+
+extern void sound_thread_shutdown(void);
+
+extern void sound_thread_get_stats(sound_thread_stats_t *stats);
+
+#endif
@@ -116,6 +116,10 @@ typedef struct sound_device_s {
     int need_attenuation;
     /* maximum amount of channels */
     int max_channels;
+    /* the device takes the samples itself with sound_ring_pull() (e.g.
+       from an audio callback) instead of having them written; write() and
+       bufferspace() are not used then */
+    int pull;
 } sound_device_t;
 
 static inline int16_t sound_audio_mix(int ch1, int ch2)
@@ -171,6 +175,17 @@ extern void sound_set_machine_parameter(long clock_rate, long ticks_per_frame);
 extern void sound_snapshot_prepare(void);
 extern void sound_snapshot_finish(void);
 
+/* Samples generated between these two calls are thrown away and the sound
+   clocks are put back, for emulating frames ahead of time.  */
+extern void sound_runahead_begin(void);
+extern void sound_runahead_end(void);
+
+#ifdef VICE_BENCH
+/* Plays the same writes to the SIDs with and without "SoundLazyClock" and
+   compares the samples.  */
+extern void sound_queue_bench(void);
+#endif
+
 extern int sound_resources_init(void);
 extern void sound_resources_shutdown(void);
 //extern int sound_cmdline_options_init(void); // 3DS
@@ -189,6 +204,7 @@ extern int sound_init_hpux_device(void);
 extern int sound_init_midas_device(void);
 extern int sound_init_sdl_device(void);
 extern int sound_init_ndsp_device(void);
+extern int sound_init_nulltimed_device(void);
 extern int sound_init_sgi_device(void);
 extern int sound_init_sun_device(void);
 extern int sound_init_uss_device(void);
@@ -244,6 +260,13 @@ typedef struct sound_chip_s {
     int (*cycle_based)(void);
     int (*channels)(void);
     int chip_enabled;
+
+    /* Optional, for rendering the chips one at a time (see
+       "SoundSidThreads"): render chip `psid' alone into the mono buffer
+       `pbuf', and mix the mono buffers of all chips into `pbuf' the way
+       calculate_samples() would have.  */
+    int (*calculate_chip_samples)(sound_t *psid, int16_t *pbuf, int nr, int *delta_t);
+    void (*mix_chip_samples)(int16_t **chip_buf, int16_t *pbuf, int nr, int sound_output_channels, int sound_chip_channels);
 } sound_chip_t;
 
 extern uint16_t sound_chip_register(sound_chip_t *chip);
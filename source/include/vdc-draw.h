@@ -31,4 +31,7 @@
 
 extern void vdc_draw_init(void);
 
+/* `len' bytes of VDC RAM from `addr' on have been written to.  */
+extern void vdc_draw_ram_changed(unsigned int addr, unsigned int len);
+
 #endif
@@ -167,6 +167,8 @@ extern uint8_t viacore_read(struct via_context_s *via_context,
                          uint16_t addr);
 extern uint8_t viacore_peek(struct via_context_s *via_context,
                          uint16_t addr);
+extern int viacore_read_is_timed(struct via_context_s *via_context,
+                                 uint16_t addr);
 
 /* WARNING: this is a hack */
 extern void viacore_set_sr(via_context_t *via_context, uint8_t data);
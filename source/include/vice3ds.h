@@ -26,6 +26,23 @@
 #include <3ds.h>
 #include <SDL/SDL.h>
 
+/* Priorities of the worker threads.  On the New 3DS they all share core 2;
+   on the Old 3DS the writers and the null sound device run on the core of
+   the main thread and the others are not started.  A lower value pre-empts
+   a higher one, so they are ordered by how soon the emulation on the main
+   thread needs their result:
+   - the real-time null sound device takes the samples every fragment and
+     so sets the pace; it only runs for a moment each time,
+   - the drive CPU is waited for at every synchronisation with the main CPU,
+   - the SID workers are waited for once every sound fragment,
+   - the video thread has a whole frame until it is waited for,
+   - the AVI and WAV writers have big buffers and use the time left.  */
+#define VICE3DS_PRIO_TIMED_SOUND    0x2f
+#define VICE3DS_PRIO_DRIVE          0x30
+#define VICE3DS_PRIO_SOUND          0x31
+#define VICE3DS_PRIO_VIDEO          0x32
+#define VICE3DS_PRIO_WRITER         0x38
+
 #define KEYMAPPINGS_DEFAULT " c9 01d20000 cc 02010000 ce 02030000 d6 011e0000 d7 01110000 d8 011f0000 d9 011d0000 e8 01031900 f6 01030000 f7 01200000 f8 010d0000"
 #define HELPTEXT_MAX 256
 
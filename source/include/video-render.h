@@ -29,16 +29,58 @@
 #define VICE_VIDEORENDER_H
 
 #include "types.h"
+#include "video.h"
 #include "viewport.h"
 
 struct video_render_config_s;
 struct video_canvas_s;
 
+typedef void (*video_render_1x1_func_t)(const video_render_color_tables_t *,
+                                        const uint8_t *, uint8_t *,
+                                        unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int);
+
+typedef void (*video_render_2x2_func_t)(const video_render_color_tables_t *,
+                                        const uint8_t *, uint8_t *,
+                                        unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int,
+                                        const unsigned int, const unsigned int,
+                                        const unsigned int, video_render_config_t *);
+
+/* The 16 and 32 bpp renderers all render modes fall back to: the plain
+   ones, or the word parallel ones from rendersimd.c if the CPU can do
+   them.  Chosen the first time video_render_main() is called.  */
+typedef struct video_render_kernels_s {
+    const char *name;
+    video_render_1x1_func_t render_16_1x1;
+    video_render_1x1_func_t render_32_1x1;
+    video_render_2x2_func_t render_16_2x2;
+    video_render_2x2_func_t render_32_2x2;
+    video_render_1x1_func_t render_16_scale2x;
+    video_render_1x1_func_t render_32_scale2x;
+} video_render_kernels_t;
+
+extern const video_render_kernels_t *video_render_kernels;
+
+/* The plain (simd == 0) or word parallel (simd == 1) renderers, NULL if
+   the CPU can't do the latter.  */
+extern const video_render_kernels_t *video_render_get_kernels(int simd);
+
 extern void video_render_main(struct video_render_config_s *config, uint8_t *src,
                               uint8_t *trg, int width, int height,
                               int xs, int ys, int xt, int yt,
                               int pitchs, int pitcht, int depth,
                               viewport_t *viewport);
+/* Like video_render_main(), but without updating the video sound, for
+   rendering a frame in parts.  */
+extern void video_render_area(struct video_render_config_s *config, uint8_t *src,
+                              uint8_t *trg, int width, int height,
+                              int xs, int ys, int xt, int yt,
+                              int pitchs, int pitcht, int depth,
+                              viewport_t *viewport);
 extern void video_render_update_palette(struct video_canvas_s *canvas);
 
 extern void video_render_1x2func_set(void (*func)(struct video_render_config_s *,
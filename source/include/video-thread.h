@@ -0,0 +1,72 @@
+/*
+ * video-thread.h - Rendering and presenting frames on a second host thread.
+ *
+ * This file is part of VICE3DS
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VIDEO_THREAD_H
+#define VICE_VIDEO_THREAD_H
+
+#include "types.h"
+
+struct video_canvas_s;
+
+typedef struct video_thread_stats_s {
+    /* frames handed to the video thread, and those it has shown */
+    unsigned int frames;
+    unsigned int presented;
+
+    /* host ticks (see bench_ticks()) the video thread spent on a frame,
+       in all and at most */
+    uint64_t render_ticks;
+    uint64_t max_render_ticks;
+
+    /* times the emulation had to wait for the video thread, and the host
+       ticks spent waiting */
+    unsigned int waits;
+    uint64_t wait_ticks;
+
+    /* host ticks between two frames shown, the shortest and the longest */
+    uint64_t min_interval_ticks;
+    uint64_t max_interval_ticks;
+} video_thread_stats_t;
+
+extern int video_thread_resources_init(void);
+extern void video_thread_shutdown(void);
+
+/* Called by the raster at the end of each frame instead of
+   video_canvas_refresh_all().  */
+extern void video_thread_refresh_frame(struct video_canvas_s *canvas);
+
+/* Called by video_canvas_refresh() once the status bar is drawn.  Returns
+   1 if the frame was handed to the video thread, and 0 if the caller is
+   to render it.  */
+extern int video_thread_refresh(struct video_canvas_s *canvas,
+                                unsigned int xs, unsigned int ys,
+                                unsigned int xi, unsigned int yi,
+                                unsigned int w, unsigned int h);
+
+/* Wait until the video thread is done with the frame it was given.  Must
+   be called before the canvas, its screen or its draw buffers are changed
+   or replaced.  */
+extern void video_thread_sync(void);
+
+extern void video_thread_get_stats(video_thread_stats_t *stats);
+
+#endif
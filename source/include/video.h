@@ -77,6 +77,9 @@ struct draw_buffer_s {
     /* Height of draw_buffer in pixels. Typically same as geometry->screen_size.height */
     unsigned int draw_buffer_height;
     unsigned int draw_buffer_pitch;
+    /* With "VideoThread", the frame being rendered while the emulation
+       draws the next one into draw_buffer; see video-thread.c */
+    uint8_t *draw_buffer_back;
     /* Width of emulator screen (physical screen on the machine where the emulator runs) in pixels */
     unsigned int canvas_physical_width;
     /* Height of emulator screen (physical screen on the machine where the emulator runs) in pixels */
@@ -152,6 +155,18 @@ struct video_render_color_tables_s {
     /* YUV table for hardware rendering: (Y << 16) | (U << 8) | V */
     int yuv_updated;            /* yuv table updated for packed mode */
     uint32_t yuv_table[512];
+
+    /* Sums of the tables above for the 1x1 PAL renderer, for pixels in the
+       first 16 colours: y of the (previous, current, next) pixel, indexed
+       by the three colours, and u and v of two neighbouring pixels, indexed
+       by the two colours.  See render_1x1_pal_update_tables().  */
+    int pal_lut_updated;
+    int32_t ytable3[16 * 16 * 16];
+    int32_t cbcrpair[16 * 16 * 2];
+    int32_t cbcrpair_odd[16 * 16 * 2];
+    int32_t cuvpair[16 * 16 * 2];
+    int32_t cuvpair_odd[16 * 16 * 2];
+
     int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
     int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
     uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
@@ -239,9 +254,48 @@ extern void video_canvas_destroy(struct video_canvas_s *canvas);
 extern void video_canvas_map(struct video_canvas_s *canvas);
 extern void video_canvas_unmap(struct video_canvas_s *canvas);
 extern void video_canvas_resize(struct video_canvas_s *canvas, char resize_canvas);
-extern void video_canvas_render(struct video_canvas_s *canvas, uint8_t *trg,
-                                int width, int height, int xs, int ys,
-                                int xt, int yt, int pitcht, int depth);
+
+/* The target lines video_canvas_render() has drawn, as up to
+   VIDEO_CANVAS_MAX_RUNS runs of lines.  Runs that are close together are
+   merged, so a run may include some lines that didn't change.  */
+#define VIDEO_CANVAS_MAX_RUNS   8
+
+typedef struct video_canvas_run_s {
+    int yt;
+    int height;
+} video_canvas_run_t;
+
+/* Returns the number of runs, 0 if the target already shows the frame.  */
+extern int video_canvas_render(struct video_canvas_s *canvas, uint8_t *src,
+                               uint8_t *trg, int width, int height,
+                               int xs, int ys, int xt, int yt,
+                               int pitcht, int depth,
+                               video_canvas_run_t *runs);
+
+/* Render `src', a draw buffer of `canvas', and show it: what
+   video_canvas_refresh() does after drawing the status bar.  */
+extern void video_canvas_present(struct video_canvas_s *canvas, uint8_t *src,
+                                 unsigned int xs, unsigned int ys,
+                                 unsigned int xi, unsigned int yi,
+                                 unsigned int w, unsigned int h);
+
+typedef struct video_canvas_dirty_s video_canvas_dirty_t;
+
+/* Forget what has been rendered into the targets of `canvas', to be
+   called when they have been replaced.  */
+extern void video_canvas_dirty_reset(struct video_canvas_s *canvas);
+
+typedef struct video_canvas_dirty_stats_s {
+    /* frames rendered, and those in which no line had changed */
+    unsigned int frames;
+    unsigned int frames_clean;
+
+    /* target lines to be rendered, and those skipped as unchanged */
+    unsigned long lines;
+    unsigned long lines_skipped;
+} video_canvas_dirty_stats_t;
+
+extern void video_canvas_get_dirty_stats(video_canvas_dirty_stats_t *stats);
 extern void video_canvas_refresh_all(struct video_canvas_s *canvas);
 extern char video_canvas_can_resize(struct video_canvas_s *canvas);
 extern void video_viewport_get(struct video_canvas_s *canvas,
@@ -264,6 +318,10 @@ typedef struct video_draw_buffer_callback_s {
 
 struct raster_s;
 
+/* "VideoDirtyLines": render only the lines that changed since the last
+   frame, see video_canvas_render() */
+extern int video_dirty_lines;
+
 extern int video_resources_init(void);
 extern void video_resources_shutdown(void);
 extern int video_resources_chip_init(const char *chipname,
@@ -52,6 +52,9 @@ struct video_canvas_s {
     int index;
     unsigned int depth;
 
+    /* Drawn as 8 bit palette indices, the colours are looked up by SDL */
+    int paletted;
+
     /* Size of the drawable canvas area, including the black borders */
     unsigned int width, height;
 
@@ -77,6 +80,9 @@ struct video_canvas_s {
     struct palette_s *palette;
     struct raster_s *parent_raster;
 
+    /* Lines rendered into each target, see video_canvas_render() */
+    struct video_canvas_dirty_s *dirty;
+
     struct video_draw_buffer_callback_s *video_draw_buffer_callback;
     struct fullscreenconfig_s *fullscreenconfig;
     video_refresh_func_t video_fullscreen_refresh_func;
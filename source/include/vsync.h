@@ -48,4 +48,29 @@ extern double vsync_get_refresh_frequency(void);
 extern int vsync_do_vsync(struct video_canvas_s *c, int been_skipped);
 extern int vsync_disable_timer(void);
 
+/* Frame costs are counted in quarters of the frame time, the last bucket
+   takes everything longer.  */
+#define VSYNC_COST_BUCKETS  8
+
+typedef struct vsync_frameskip_stats_s {
+    /* frames emulated, and those of them that were not rendered */
+    unsigned int frames;
+    unsigned int skipped;
+
+    /* frames per second to be emulated (0 without a speed limit), and
+       frames rendered per second over the last two seconds */
+    double target_fps;
+    double actual_fps;
+
+    /* the expected host time (ms) to emulate a rendered and a skipped
+       frame, as "AdaptiveFrameskip" predicts it */
+    double render_ms;
+    double skip_ms;
+
+    /* host time spent per frame, see VSYNC_COST_BUCKETS */
+    unsigned int histogram[VSYNC_COST_BUCKETS];
+} vsync_frameskip_stats_t;
+
+extern void vsync_get_frameskip_stats(vsync_frameskip_stats_t *stats);
+
 #endif